@@ -0,0 +1,405 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+#ifndef __BVH_h
+#define __BVH_h
+
+
+/**
+********************************************************************************
+*
+*   @file       BVH.h
+*
+*   @brief      Class to manipulate a bounding volume hierarchy (BVH).
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <vector>
+
+#ifndef __Vec3_h
+#include "Vec3.h"
+#endif
+
+#ifndef __Triangle_h
+#include "Triangle.h"
+#endif
+
+#ifndef __Ray_h
+#include "Ray.h"
+#endif
+
+#ifndef __RayPacket_h
+#include "RayPacket.h"
+#endif
+
+
+//==============================================================================
+/**
+*   @struct BVHNode
+*   @brief  BVHNode is a node of a BVH. It is 32-byte long so that two
+*           siblings fit in a single cache line.
+*/
+//==============================================================================
+struct BVHNode
+//------------------------------------------------------------------------------
+{
+    bool isLeaf() const;
+
+    /// The lower corner of the node's bounding box
+    Vec3 m_lower_bbox_corner;
+
+    /// The upper corner of the node's bounding box
+    Vec3 m_upper_bbox_corner;
+
+    /// Index of the left child if the node is internal (the right child
+    /// is stored right after it), index of the first primitive otherwise
+    unsigned int m_first;
+
+    /// Number of primitives in the leaf, 0 if the node is internal
+    unsigned int m_primitive_count;
+};
+
+
+//==============================================================================
+/**
+*   @struct BVHStatistics
+*   @brief  BVHStatistics gathers measures of the quality of a BVH, e.g. to
+*           tune the build parameters of a given model.
+*/
+//==============================================================================
+struct BVHStatistics
+//------------------------------------------------------------------------------
+{
+    /// Expected cost of a ray traversal, see BVH::getSAHCost
+    float m_sah_cost;
+
+    /// Number of nodes, including the leaves
+    size_t m_number_of_nodes;
+
+    /// Number of leaves
+    size_t m_number_of_leaves;
+
+    /// Number of leaves at each depth, the root is at depth 0
+    std::vector<unsigned int> m_depth_histogram;
+
+    /// Number of leaves for each number of primitives per leaf
+    std::vector<unsigned int> m_leaf_size_histogram;
+};
+
+
+//==============================================================================
+/**
+*   @class  BVH
+*   @brief  BVH is a class to build and traverse a bounding volume hierarchy
+*           over a set of primitives given by their bounding boxes.
+*           The hierarchy is either built top-down using binned surface area
+*           heuristic (SAH) splits, or in parallel as a linear BVH (LBVH)
+*           from the Morton codes of the primitives' centroids. The LBVH is
+*           much faster to build, but slower to traverse. For triangles, the
+*           SBVH build also considers spatial splits, which reference large
+*           triangles in several leaves.
+*/
+//==============================================================================
+class BVH
+//------------------------------------------------------------------------------
+{
+//******************************************************************************
+public:
+    /// The build algorithms
+    enum BuildMethod
+    {
+        SAH,  ///< Binned SAH, top-down (best traversal speed)
+        LBVH, ///< Linear BVH built in parallel (best build speed)
+        SBVH  ///< Binned SAH with spatial splits, for large overlapping triangles
+    };
+
+    /// Index of the unused slots of a block, see groupPrimitivesIntoBlocks
+    static const unsigned int NO_PRIMITIVE = 0xFFFFFFFF;
+
+
+    BVH();
+
+    void build(const std::vector<Vec3>& aLowerBBoxCornerSet,
+               const std::vector<Vec3>& anUpperBBoxCornerSet,
+               BuildMethod aBuildMethod = SAH);
+
+    //--------------------------------------------------------------------------
+    /// Build the hierarchy
+    /*
+    *   @param aLowerBBoxCornerSet  the lower corners of the primitives' bbox
+    *   @param anUpperBBoxCornerSet the upper corners of the primitives' bbox
+    *   @param aLowerBBoxCorner     the lower corner of the bbox of all the primitives
+    *   @param anUpperBBoxCorner    the upper corner of the bbox of all the primitives
+    *   @param aBuildMethod         the build algorithm
+    */
+    //--------------------------------------------------------------------------
+    void build(const std::vector<Vec3>& aLowerBBoxCornerSet,
+               const std::vector<Vec3>& anUpperBBoxCornerSet,
+               const Vec3& aLowerBBoxCorner,
+               const Vec3& anUpperBBoxCorner,
+               BuildMethod aBuildMethod = SAH);
+
+    //--------------------------------------------------------------------------
+    /// Build the hierarchy over triangles. The SBVH build clips the
+    /// triangles by the split planes, the other methods only use the bboxes
+    /*
+    *   @param aTriangleSet         the triangles
+    *   @param aLowerBBoxCornerSet  the lower corners of the triangles' bbox
+    *   @param anUpperBBoxCornerSet the upper corners of the triangles' bbox
+    *   @param aLowerBBoxCorner     the lower corner of the bbox of all the triangles
+    *   @param anUpperBBoxCorner    the upper corner of the bbox of all the triangles
+    *   @param aBuildMethod         the build algorithm
+    */
+    //--------------------------------------------------------------------------
+    void build(const std::vector<Triangle>& aTriangleSet,
+               const std::vector<Vec3>& aLowerBBoxCornerSet,
+               const std::vector<Vec3>& anUpperBBoxCornerSet,
+               const Vec3& aLowerBBoxCorner,
+               const Vec3& anUpperBBoxCorner,
+               BuildMethod aBuildMethod);
+
+    //--------------------------------------------------------------------------
+    /// Set a hierarchy built beforehand, e.g. loaded from a cache file
+    /*
+    *   @param aNodeSet             the nodes, the root is the first one
+    *   @param aPrimitiveIndexSet   the primitive indices referenced by the leaves
+    *   @param aBuildMethod         the algorithm used to build the hierarchy
+    */
+    //--------------------------------------------------------------------------
+    void setNodes(const std::vector<BVHNode>& aNodeSet,
+                  const std::vector<unsigned int>& aPrimitiveIndexSet,
+                  BuildMethod aBuildMethod);
+
+    //--------------------------------------------------------------------------
+    /// Update the bboxes of the nodes after the primitives moved, keeping the
+    /// topology of the hierarchy. The nodes are refitted bottom-up in parallel
+    /*
+    *   @param aLowerBBoxCornerSet  the new lower corners of the primitives' bbox
+    *   @param anUpperBBoxCornerSet the new upper corners of the primitives' bbox
+    */
+    //--------------------------------------------------------------------------
+    void refit(const std::vector<Vec3>& aLowerBBoxCornerSet,
+               const std::vector<Vec3>& anUpperBBoxCornerSet);
+
+    //--------------------------------------------------------------------------
+    /// Lower the SAH cost of the hierarchy by restructuring its treelets, see
+    /// "Fast Parallel Construction of High-Quality Bounding Volume
+    /// Hierarchies" by Karras and Aila (2013). The best topology of each
+    /// treelet of up to TREELET_SIZE subtrees is found by dynamic programming,
+    /// the leaves are kept as they are
+    /*
+    *   @param aNumberOfPasses  the number of bottom-up passes over the tree
+    */
+    //--------------------------------------------------------------------------
+    void restructure(unsigned int aNumberOfPasses = 3);
+
+    //--------------------------------------------------------------------------
+    /// Turn the subtrees of up to aBlockSize primitive references into
+    /// leaves, and pack the primitives of every leaf into blocks of
+    /// aBlockSize primitives, e.g. to test them at once with SIMD
+    /// instructions. The leaves then reference whole blocks: the primitive
+    /// indices of the hierarchy become block indices
+    /*
+    *   @param aBlockSize           the number of primitives per block
+    *   @param aBlockPrimitiveSet   the primitive indices of each block,
+    *                               aBlockSize per block, the unused slots
+    *                               are set to NO_PRIMITIVE
+    */
+    //--------------------------------------------------------------------------
+    void groupPrimitivesIntoBlocks(unsigned int aBlockSize,
+                                   std::vector<unsigned int>& aBlockPrimitiveSet);
+
+    void clear();
+
+    BuildMethod getBuildMethod() const;
+
+    /// Wall-clock time of the last build, in seconds (0 if set with setNodes)
+    double getBuildTime() const;
+
+    bool isEmpty() const;
+
+    /// Expected cost of a ray traversal according to the surface area
+    /// heuristic, relative to the cost of a primitive intersection test
+    float getSAHCost() const;
+
+    /// Node and leaf counts, depth and leaf size histograms
+    BVHStatistics getStatistics() const;
+
+    size_t getNumberOfNodes() const;
+    const BVHNode& getNode(unsigned int i) const;
+
+    size_t getNumberOfPrimitiveIndices() const;
+    unsigned int getPrimitiveIndex(unsigned int i) const;
+
+    //--------------------------------------------------------------------------
+    /// Find the closest intersection between a ray and the primitives.
+    /// The nearest child is visited first, so that the subtrees behind the
+    /// closest intersection found so far are culled
+    /*
+    *   @param aRay             the ray
+    *   @param anIntersector    functor with the signature
+    *                           bool (const Ray&, unsigned int aPrimitiveId, float& t)
+    *                           that tests a ray against a given primitive.
+    *                           It returns true and sets t only if the
+    *                           primitive is hit within the ray's interval.
+    *                           The interval is shrunk to the closest
+    *                           intersection found so far
+    *   @param t                the distance to the closest intersection (if any)
+    *   @param aPrimitiveId     the ID of the closest primitive (if any)
+    *   @param apVisitCount     if not null, it is incremented for each
+    *                           node visited
+    *   @return true if an intersection was found within the ray's interval
+    */
+    //-------------------------------------------------------
+    template<typename PrimitiveIntersector>
+    bool intersect(const Ray& aRay,
+                   const PrimitiveIntersector& anIntersector,
+                   float& t,
+                   unsigned int& aPrimitiveId,
+                   unsigned int* apVisitCount = 0) const;
+
+    //-------------------------------------------------------
+    /// Check if any primitive intersects a ray (any-hit query). The traversal
+    /// stops as soon as an intersection is found, e.g. for shadow rays
+    /*
+    *   @param aRay             the ray
+    *   @param anOccluder       functor with the signature
+    *                           bool (const Ray&, unsigned int aPrimitiveId)
+    *                           that returns true if the primitive is hit
+    *                           within the ray's interval
+    *   @return true if an intersection was found within the ray's interval
+    */
+    //--------------------------------------------------------------------------
+    template<typename PrimitiveOccluder>
+    bool occluded(const Ray& aRay,
+                  const PrimitiveOccluder& anOccluder) const;
+
+    //--------------------------------------------------------------------------
+    /// Find the closest intersections between a packet of coherent rays and
+    /// the primitives. The rays traverse the tree together: a node is culled
+    /// if it is outside of the packet's frustum, and otherwise the rays
+    /// before the first one that hits its box are skipped in the subtree
+    /// (see "Large Ray Packets for Real-time Whitted Ray Tracing" by
+    /// Overbeck et al., 2008). It also runs any-hit queries: the
+    /// intersector empties the interval of the occluded rays, which then
+    /// fail every box test
+    /*
+    *   @param aPacket          the packet of rays, their closest
+    *                           intersections are recorded in it
+    *   @param anIntersector    functor with the signature
+    *                           void (RayPacket&, unsigned int aPrimitiveId,
+    *                           unsigned int aFirstRay) that tests the rays
+    *                           from aFirstRay against a given primitive, and
+    *                           records the closer intersections in the packet
+    */
+    //--------------------------------------------------------------------------
+    template<typename PacketIntersector>
+    void intersect(RayPacket& aPacket,
+                   const PacketIntersector& anIntersector) const;
+
+
+//******************************************************************************
+protected:
+    static const unsigned int MAX_STACK_SIZE = 64;
+    static const unsigned int NUMBER_OF_BINS = 16;
+    static const unsigned int MAX_PRIMITIVES_PER_LEAF = 8;
+    static const unsigned int TREELET_SIZE = 7;
+
+    static bool intersectBBox(const BVHNode& aNode,
+                              const Ray& aRay);
+
+    void buildSAH(const std::vector<Vec3>& aLowerBBoxCornerSet,
+                  const std::vector<Vec3>& anUpperBBoxCornerSet);
+
+    void buildSBVH(const std::vector<Triangle>& aTriangleSet,
+                   const std::vector<Vec3>& aLowerBBoxCornerSet,
+                   const std::vector<Vec3>& anUpperBBoxCornerSet);
+
+    void restructureSubtree(unsigned int aNodeId,
+                            std::vector<float>& aSubtreeCostSet);
+
+    void restructureTreelet(unsigned int aRootId,
+                            std::vector<float>& aSubtreeCostSet);
+
+    unsigned int countPrimitives(unsigned int aNodeId,
+                                 std::vector<unsigned int>& aPrimitiveCountSet) const;
+
+    void gatherPrimitives(unsigned int aNodeId,
+                          std::vector<unsigned int>& aPrimitiveSet) const;
+
+    void buildLBVH(const std::vector<Vec3>& aLowerBBoxCornerSet,
+                   const std::vector<Vec3>& anUpperBBoxCornerSet,
+                   const Vec3& aLowerBBoxCorner,
+                   const Vec3& anUpperBBoxCorner);
+
+    /// The nodes, the root is the first one
+    std::vector<BVHNode> m_node_set;
+
+    /// The primitive indices referenced by the leaves
+    std::vector<unsigned int> m_primitive_index_set;
+
+    /// The algorithm used to build the hierarchy
+    BuildMethod m_build_method;
+
+    /// The build time in seconds
+    double m_build_time;
+};
+
+
+#include "BVH.inl"
+
+
+#endif // __BVH_h
@@ -0,0 +1,453 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       BVH.inl
+*
+*   @brief      Class to manipulate a bounding volume hierarchy (BVH).
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <algorithm> // for min/max
+#include <limits>    // for inf
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//---------------------------------
+inline bool BVHNode::isLeaf() const
+//---------------------------------
+{
+    return m_primitive_count > 0;
+}
+
+
+//----------------
+inline BVH::BVH():
+//----------------
+        m_build_method(SAH),
+        m_build_time(0.0)
+//---------------
+{
+    // Do nothing
+}
+
+
+//-------------------------------------------------------------------------
+inline void BVH::setNodes(const std::vector<BVHNode>& aNodeSet,
+                          const std::vector<unsigned int>& aPrimitiveIndexSet,
+                          BuildMethod aBuildMethod)
+//-------------------------------------------------------------------------
+{
+    m_node_set = aNodeSet;
+    m_primitive_index_set = aPrimitiveIndexSet;
+    m_build_method = aBuildMethod;
+    m_build_time = 0.0;
+}
+
+
+//----------------------
+inline void BVH::clear()
+//----------------------
+{
+    m_node_set.clear();
+    m_primitive_index_set.clear();
+}
+
+
+//-----------------------------------------------------
+inline BVH::BuildMethod BVH::getBuildMethod() const
+//-----------------------------------------------------
+{
+    return m_build_method;
+}
+
+
+//--------------------------------------
+inline double BVH::getBuildTime() const
+//--------------------------------------
+{
+    return m_build_time;
+}
+
+
+//------------------------------
+inline bool BVH::isEmpty() const
+//------------------------------
+{
+    return m_node_set.empty();
+}
+
+
+//-----------------------------------------
+inline size_t BVH::getNumberOfNodes() const
+//-----------------------------------------
+{
+    return m_node_set.size();
+}
+
+
+//------------------------------------------------------
+inline const BVHNode& BVH::getNode(unsigned int i) const
+//------------------------------------------------------
+{
+    return m_node_set[i];
+}
+
+
+//----------------------------------------------------
+inline size_t BVH::getNumberOfPrimitiveIndices() const
+//----------------------------------------------------
+{
+    return m_primitive_index_set.size();
+}
+
+
+//--------------------------------------------------------------
+inline unsigned int BVH::getPrimitiveIndex(unsigned int i) const
+//--------------------------------------------------------------
+{
+    return m_primitive_index_set[i];
+}
+
+
+//--------------------------------------------------
+inline bool BVH::intersectBBox(const BVHNode& aNode,
+                               const Ray& aRay)
+//--------------------------------------------------
+{
+    float t_near;
+    float t_far;
+
+    return aRay.intersect(aNode.m_lower_bbox_corner, aNode.m_upper_bbox_corner, t_near, t_far);
+}
+
+
+//------------------------------------------------------------
+template<typename PrimitiveIntersector>
+bool BVH::intersect(const Ray& aRay,
+                    const PrimitiveIntersector& anIntersector,
+                    float& t,
+                    unsigned int& aPrimitiveId,
+                    unsigned int* apVisitCount) const
+//------------------------------------------------------------
+{
+    if (m_node_set.empty())
+    {
+        return false;
+    }
+
+    // The interval of the ray shrinks as closer intersections are found
+    Ray ray(aRay);
+    bool has_hit = false;
+
+    float t_near;
+    float t_far;
+    if (!ray.intersect(m_node_set[0].m_lower_bbox_corner, m_node_set[0].m_upper_bbox_corner, t_near, t_far))
+    {
+        return false;
+    }
+
+    // Traverse the tree depth-first using a fixed size stack,
+    // so that there is no heap allocation per ray. The nearest child is
+    // visited first, the other one is pushed with the entry distance of the
+    // ray in its box, so that it is skipped if a closer intersection is
+    // found in the meantime
+    unsigned int stack[MAX_STACK_SIZE];
+    float stack_t_near[MAX_STACK_SIZE];
+    unsigned int stack_size = 0;
+
+    unsigned int node_id = 0;
+    while (true)
+    {
+        const BVHNode& node = m_node_set[node_id];
+
+        if (apVisitCount)
+        {
+            ++(*apVisitCount);
+        }
+
+        // Test the primitives of the leaf
+        if (node.isLeaf())
+        {
+            for (unsigned int i = node.m_first; i < node.m_first + node.m_primitive_count; ++i)
+            {
+                unsigned int primitive_id = m_primitive_index_set[i];
+
+                float primitive_t;
+                if (anIntersector(ray, primitive_id, primitive_t))
+                {
+                    ray.setTMax(primitive_t);
+                    aPrimitiveId = primitive_id;
+                    has_hit = true;
+                }
+            }
+        }
+        // Test the boxes of both children, and go down into the nearest one
+        else
+        {
+            const BVHNode& left_child = m_node_set[node.m_first];
+            const BVHNode& right_child = m_node_set[node.m_first + 1];
+
+            float left_t_near;
+            float right_t_near;
+            bool left_hit = ray.intersect(left_child.m_lower_bbox_corner, left_child.m_upper_bbox_corner, left_t_near, t_far);
+            bool right_hit = ray.intersect(right_child.m_lower_bbox_corner, right_child.m_upper_bbox_corner, right_t_near, t_far);
+
+            if (left_hit && right_hit)
+            {
+                if (left_t_near <= right_t_near)
+                {
+                    stack[stack_size] = node.m_first + 1;
+                    stack_t_near[stack_size++] = right_t_near;
+                    node_id = node.m_first;
+                }
+                else
+                {
+                    stack[stack_size] = node.m_first;
+                    stack_t_near[stack_size++] = left_t_near;
+                    node_id = node.m_first + 1;
+                }
+                continue;
+            }
+            else if (left_hit || right_hit)
+            {
+                node_id = left_hit ? node.m_first : node.m_first + 1;
+                continue;
+            }
+        }
+
+        // Pop the next node that may still hold a closer intersection
+        while (stack_size && stack_t_near[stack_size - 1] > ray.getTMax())
+        {
+            --stack_size;
+        }
+
+        if (!stack_size)
+        {
+            break;
+        }
+
+        node_id = stack[--stack_size];
+    }
+
+    if (has_hit)
+    {
+        t = ray.getTMax();
+    }
+
+    return has_hit;
+}
+
+
+//-----------------------------------------------------------
+template<typename PrimitiveOccluder>
+bool BVH::occluded(const Ray& aRay,
+                   const PrimitiveOccluder& anOccluder) const
+//-----------------------------------------------------------
+{
+    if (m_node_set.empty())
+    {
+        return false;
+    }
+
+    unsigned int stack[MAX_STACK_SIZE];
+    unsigned int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size)
+    {
+        const BVHNode& node = m_node_set[stack[--stack_size]];
+
+        if (!intersectBBox(node, aRay))
+        {
+            continue;
+        }
+
+        if (node.isLeaf())
+        {
+            for (unsigned int i = node.m_first; i < node.m_first + node.m_primitive_count; ++i)
+            {
+                // Any intersection will do
+                if (anOccluder(aRay, m_primitive_index_set[i]))
+                {
+                    return true;
+                }
+            }
+        }
+        else
+        {
+            stack[stack_size++] = node.m_first + 1;
+            stack[stack_size++] = node.m_first;
+        }
+    }
+
+    return false;
+}
+
+
+//------------------------------------------------------------------
+template<typename PacketIntersector>
+void BVH::intersect(RayPacket& aPacket,
+                    const PacketIntersector& anIntersector) const
+//------------------------------------------------------------------
+{
+    if (m_node_set.empty())
+    {
+        return;
+    }
+
+    unsigned int size = aPacket.getSize();
+
+    float t_near;
+    unsigned int first_ray = 0;
+    if (!aPacket.intersectFrustum(m_node_set[0].m_lower_bbox_corner, m_node_set[0].m_upper_bbox_corner) ||
+        (first_ray = aPacket.findFirstHit(m_node_set[0].m_lower_bbox_corner, m_node_set[0].m_upper_bbox_corner, 0, t_near)) == size)
+    {
+        return;
+    }
+
+    // Each node is pushed with the first ray that hits its box
+    unsigned int stack[MAX_STACK_SIZE];
+    unsigned int stack_first_ray[MAX_STACK_SIZE];
+    unsigned int stack_size = 0;
+
+    unsigned int node_id = 0;
+    while (true)
+    {
+        const BVHNode& node = m_node_set[node_id];
+
+        // Test the primitives of the leaf
+        if (node.isLeaf())
+        {
+            for (unsigned int i = node.m_first; i < node.m_first + node.m_primitive_count; ++i)
+            {
+                anIntersector(aPacket, m_primitive_index_set[i], first_ray);
+            }
+        }
+        // Test the boxes of both children, and go down into the nearest one
+        // for the first active ray
+        else
+        {
+            const BVHNode& left_child = m_node_set[node.m_first];
+            const BVHNode& right_child = m_node_set[node.m_first + 1];
+
+            float left_t_near;
+            float right_t_near;
+            unsigned int left_first_ray = size;
+            unsigned int right_first_ray = size;
+
+            if (aPacket.intersectFrustum(left_child.m_lower_bbox_corner, left_child.m_upper_bbox_corner))
+            {
+                left_first_ray = aPacket.findFirstHit(left_child.m_lower_bbox_corner, left_child.m_upper_bbox_corner, first_ray, left_t_near);
+            }
+
+            if (aPacket.intersectFrustum(right_child.m_lower_bbox_corner, right_child.m_upper_bbox_corner))
+            {
+                right_first_ray = aPacket.findFirstHit(right_child.m_lower_bbox_corner, right_child.m_upper_bbox_corner, first_ray, right_t_near);
+            }
+
+            bool left_hit = left_first_ray < size;
+            bool right_hit = right_first_ray < size;
+
+            if (left_hit && right_hit)
+            {
+                if (left_t_near <= right_t_near)
+                {
+                    stack[stack_size] = node.m_first + 1;
+                    stack_first_ray[stack_size++] = right_first_ray;
+                    node_id = node.m_first;
+                    first_ray = left_first_ray;
+                }
+                else
+                {
+                    stack[stack_size] = node.m_first;
+                    stack_first_ray[stack_size++] = left_first_ray;
+                    node_id = node.m_first + 1;
+                    first_ray = right_first_ray;
+                }
+                continue;
+            }
+            else if (left_hit || right_hit)
+            {
+                node_id = left_hit ? node.m_first : node.m_first + 1;
+                first_ray = left_hit ? left_first_ray : right_first_ray;
+                continue;
+            }
+        }
+
+        // Pop the next node that some rays still hit before their closest
+        // intersection
+        bool found = false;
+        while (stack_size && !found)
+        {
+            node_id = stack[--stack_size];
+            const BVHNode& next_node = m_node_set[node_id];
+            first_ray = aPacket.findFirstHit(next_node.m_lower_bbox_corner, next_node.m_upper_bbox_corner, stack_first_ray[stack_size], t_near);
+            found = first_ray < size;
+        }
+
+        if (!found)
+        {
+            break;
+        }
+    }
+}
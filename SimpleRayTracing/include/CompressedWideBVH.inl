@@ -0,0 +1,558 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       CompressedWideBVH.inl
+*
+*   @brief      Class to manipulate a wide BVH whose child boxes are quantized to 8 bits.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <algorithm> // for min/max
+#include <limits>    // for inf
+#include <cmath>     // for floor/ceil/nextafter
+#include <cstring>   // for memcpy
+#include <stdexcept> // for exceptions
+
+#if defined(__SSE2__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//----------------------------------------------
+template<unsigned int N>
+inline CompressedWideBVH<N>::CompressedWideBVH()
+//----------------------------------------------
+{
+    // Do nothing
+}
+
+
+//----------------------------------------------------------
+template<unsigned int N>
+void CompressedWideBVH<N>::build(const WideBVH<N>& aWideBVH)
+//----------------------------------------------------------
+{
+    clear();
+
+    // The leaves reference the same primitive ranges as in the wide BVH
+    m_primitive_index_set.resize(aWideBVH.getNumberOfPrimitiveIndices());
+    for (unsigned int i = 0; i < m_primitive_index_set.size(); ++i)
+    {
+        m_primitive_index_set[i] = aWideBVH.getPrimitiveIndex(i);
+    }
+
+    // The nodes keep their index
+    m_node_set.resize(aWideBVH.getNumberOfNodes());
+    for (unsigned int i = 0; i < m_node_set.size(); ++i)
+    {
+        compress(aWideBVH.getNode(i), m_node_set[i]);
+    }
+}
+
+
+//---------------------------------------
+template<unsigned int N>
+inline void CompressedWideBVH<N>::clear()
+//---------------------------------------
+{
+    m_node_set.clear();
+    m_primitive_index_set.clear();
+}
+
+
+//-----------------------------------------------
+template<unsigned int N>
+inline bool CompressedWideBVH<N>::isEmpty() const
+//-----------------------------------------------
+{
+    return m_node_set.empty();
+}
+
+
+//----------------------------------------------------------
+template<unsigned int N>
+inline size_t CompressedWideBVH<N>::getNumberOfNodes() const
+//----------------------------------------------------------
+{
+    return m_node_set.size();
+}
+
+
+//----------------------------------------------------------------------------------------
+template<unsigned int N>
+inline const CompressedWideBVHNode<N>& CompressedWideBVH<N>::getNode(unsigned int i) const
+//----------------------------------------------------------------------------------------
+{
+    return m_node_set[i];
+}
+
+
+//---------------------------------------------------------------------
+template<unsigned int N>
+inline size_t CompressedWideBVH<N>::getNumberOfPrimitiveIndices() const
+//---------------------------------------------------------------------
+{
+    return m_primitive_index_set.size();
+}
+
+
+//-------------------------------------------------------------------------------
+template<unsigned int N>
+inline unsigned int CompressedWideBVH<N>::getPrimitiveIndex(unsigned int i) const
+//-------------------------------------------------------------------------------
+{
+    return m_primitive_index_set[i];
+}
+
+
+//----------------------------------------------------------------------------
+template<unsigned int N>
+void CompressedWideBVH<N>::compress(const WideBVHNode<N>& aNode,
+                                    CompressedWideBVHNode<N>& aCompressedNode)
+//----------------------------------------------------------------------------
+{
+    float inf = std::numeric_limits<float>::infinity();
+
+    // The decoded coordinates may be rounded differently during the
+    // traversal (e.g. with FMA), keep a margin of a few ulps
+    const float margin = 4.0 * std::numeric_limits<float>::epsilon();
+
+    // The box of the node is the union of its children's boxes
+    float lower[3] = { inf,  inf,  inf};
+    float upper[3] = {-inf, -inf, -inf};
+    for (unsigned int i = 0; i < N; ++i)
+    {
+        if (aNode.m_bbox[0][i] <= aNode.m_bbox[3][i])
+        {
+            for (unsigned int axis = 0; axis < 3; ++axis)
+            {
+                lower[axis] = std::min(lower[axis], aNode.m_bbox[axis][i]);
+                upper[axis] = std::max(upper[axis], aNode.m_bbox[axis + 3][i]);
+            }
+        }
+    }
+
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        // A node always has at least one child
+        float origin = lower[axis] <= upper[axis] ? lower[axis] : 0.0f;
+        float extent = lower[axis] <= upper[axis] ? upper[axis] - lower[axis] : 0.0f;
+        float scale = extent / 255.0f;
+
+        // The last step must reach the upper bound, and be beyond the
+        // origin so that the boxes of the empty slots are inverted
+        if (scale <= 0.0)
+        {
+            scale = std::max(1.0f, std::abs(origin)) * margin;
+        }
+
+        while (origin + 255.0f * scale <= origin ||
+               origin + 255.0f * scale < upper[axis] + std::abs(upper[axis]) * margin)
+        {
+            scale = std::nextafter(scale, inf) * (1.0f + margin);
+        }
+
+        aCompressedNode.m_origin[axis] = origin;
+        aCompressedNode.m_scale[axis] = scale;
+
+        for (unsigned int i = 0; i < N; ++i)
+        {
+            float child_lower = aNode.m_bbox[axis][i];
+            float child_upper = aNode.m_bbox[axis + 3][i];
+
+            // Empty slot
+            if (aNode.m_bbox[0][i] > aNode.m_bbox[3][i])
+            {
+                aCompressedNode.m_bbox[axis][i] = 255;
+                aCompressedNode.m_bbox[axis + 3][i] = 0;
+                continue;
+            }
+
+            // Round the lower bound down and the upper bound up
+            int q_lower = std::max(0.0f, std::min(255.0f, std::floor((child_lower - origin) / scale)));
+            while (q_lower > 0 &&
+                   origin + q_lower * scale > child_lower - std::abs(child_lower) * margin)
+            {
+                --q_lower;
+            }
+
+            int q_upper = std::max(0.0f, std::min(255.0f, std::ceil((child_upper - origin) / scale)));
+            while (q_upper < 255 &&
+                   origin + q_upper * scale < child_upper + std::abs(child_upper) * margin)
+            {
+                ++q_upper;
+            }
+
+            aCompressedNode.m_bbox[axis][i] = q_lower;
+            aCompressedNode.m_bbox[axis + 3][i] = q_upper;
+        }
+    }
+
+    for (unsigned int i = 0; i < N; ++i)
+    {
+        if (aNode.m_primitive_count[i] > 255)
+        {
+            throw std::overflow_error("Too many primitives in a leaf of the compressed BVH");
+        }
+
+        aCompressedNode.m_primitive_count[i] = aNode.m_primitive_count[i];
+        aCompressedNode.m_child[i] = aNode.m_child[i];
+    }
+}
+
+
+//------------------------------------------------------------------------------------------------
+template<unsigned int N>
+inline unsigned int CompressedWideBVH<N>::intersectChildren(const CompressedWideBVHNode<N>& aNode,
+                                                            const Ray& aRay,
+                                                            float aTNear[N])
+//------------------------------------------------------------------------------------------------
+{
+    // Decode the boxes, then same slab test as WideBVH
+    const Vec3& origin = aRay.getOrigin();
+    const Vec3& inverse_direction = aRay.getInverseDirection();
+
+    unsigned int near_x = aRay.getDirectionSign(0) * 3;
+    unsigned int near_y = aRay.getDirectionSign(1) * 3 + 1;
+    unsigned int near_z = aRay.getDirectionSign(2) * 3 + 2;
+
+    unsigned int hit_mask = 0;
+    for (unsigned int i = 0; i < N; ++i)
+    {
+        float x_near = aNode.m_origin[0] + aNode.m_bbox[near_x    ][i] * aNode.m_scale[0];
+        float x_far  = aNode.m_origin[0] + aNode.m_bbox[3 - near_x][i] * aNode.m_scale[0];
+        float y_near = aNode.m_origin[1] + aNode.m_bbox[near_y    ][i] * aNode.m_scale[1];
+        float y_far  = aNode.m_origin[1] + aNode.m_bbox[5 - near_y][i] * aNode.m_scale[1];
+        float z_near = aNode.m_origin[2] + aNode.m_bbox[near_z    ][i] * aNode.m_scale[2];
+        float z_far  = aNode.m_origin[2] + aNode.m_bbox[7 - near_z][i] * aNode.m_scale[2];
+
+        float tx_near = (x_near - origin.getX()) * inverse_direction.getX();
+        float tx_far  = (x_far  - origin.getX()) * inverse_direction.getX();
+        float ty_near = (y_near - origin.getY()) * inverse_direction.getY();
+        float ty_far  = (y_far  - origin.getY()) * inverse_direction.getY();
+        float tz_near = (z_near - origin.getZ()) * inverse_direction.getZ();
+        float tz_far  = (z_far  - origin.getZ()) * inverse_direction.getZ();
+
+        float t_near = std::max(std::max(std::max(tx_near, ty_near), tz_near), aRay.getTMin());
+        float t_far  = std::min(std::min(std::min(tx_far,  ty_far),  tz_far),  aRay.getTMax());
+
+        aTNear[i] = t_near;
+        if (t_near <= t_far)
+        {
+            hit_mask |= 1 << i;
+        }
+    }
+
+    return hit_mask;
+}
+
+
+#ifdef __SSE2__
+//------------------------------------------------------------------------------------------------
+template<>
+inline unsigned int CompressedWideBVH<4>::intersectChildren(const CompressedWideBVHNode<4>& aNode,
+                                                            const Ray& aRay,
+                                                            float aTNear[4])
+//------------------------------------------------------------------------------------------------
+{
+    const Vec3& origin = aRay.getOrigin();
+    const Vec3& inverse_direction = aRay.getInverseDirection();
+
+    unsigned int near_x = aRay.getDirectionSign(0) * 3;
+    unsigned int near_y = aRay.getDirectionSign(1) * 3 + 1;
+    unsigned int near_z = aRay.getDirectionSign(2) * 3 + 2;
+
+    // Widen 4 bytes to 4 floats, and map them to the node's box
+    __m128i zero = _mm_setzero_si128();
+    unsigned int plane_id[6] = {near_x, 3 - near_x, near_y, 5 - near_y, near_z, 7 - near_z};
+    __m128 plane[6];
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        int bytes;
+        memcpy(&bytes, aNode.m_bbox[plane_id[i]], sizeof(bytes));
+
+        __m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero);
+        __m128 quantized = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+
+        plane[i] = _mm_add_ps(_mm_set1_ps(aNode.m_origin[i / 2]),
+                              _mm_mul_ps(quantized, _mm_set1_ps(aNode.m_scale[i / 2])));
+    }
+
+    __m128 origin_x = _mm_set1_ps(origin.getX());
+    __m128 origin_y = _mm_set1_ps(origin.getY());
+    __m128 origin_z = _mm_set1_ps(origin.getZ());
+
+    __m128 inverse_direction_x = _mm_set1_ps(inverse_direction.getX());
+    __m128 inverse_direction_y = _mm_set1_ps(inverse_direction.getY());
+    __m128 inverse_direction_z = _mm_set1_ps(inverse_direction.getZ());
+
+    __m128 tx_near = _mm_mul_ps(_mm_sub_ps(plane[0], origin_x), inverse_direction_x);
+    __m128 tx_far  = _mm_mul_ps(_mm_sub_ps(plane[1], origin_x), inverse_direction_x);
+    __m128 ty_near = _mm_mul_ps(_mm_sub_ps(plane[2], origin_y), inverse_direction_y);
+    __m128 ty_far  = _mm_mul_ps(_mm_sub_ps(plane[3], origin_y), inverse_direction_y);
+    __m128 tz_near = _mm_mul_ps(_mm_sub_ps(plane[4], origin_z), inverse_direction_z);
+    __m128 tz_far  = _mm_mul_ps(_mm_sub_ps(plane[5], origin_z), inverse_direction_z);
+
+    __m128 t_near = _mm_max_ps(_mm_max_ps(tx_near, ty_near), _mm_max_ps(tz_near, _mm_set1_ps(aRay.getTMin())));
+    __m128 t_far  = _mm_min_ps(_mm_min_ps(tx_far,  ty_far),  _mm_min_ps(tz_far,  _mm_set1_ps(aRay.getTMax())));
+
+    _mm_storeu_ps(aTNear, t_near);
+    return _mm_movemask_ps(_mm_cmple_ps(t_near, t_far));
+}
+#endif
+
+
+#ifdef __AVX__
+//------------------------------------------------------------------------------------------------
+template<>
+inline unsigned int CompressedWideBVH<8>::intersectChildren(const CompressedWideBVHNode<8>& aNode,
+                                                            const Ray& aRay,
+                                                            float aTNear[8])
+//------------------------------------------------------------------------------------------------
+{
+    const Vec3& origin = aRay.getOrigin();
+    const Vec3& inverse_direction = aRay.getInverseDirection();
+
+    unsigned int near_x = aRay.getDirectionSign(0) * 3;
+    unsigned int near_y = aRay.getDirectionSign(1) * 3 + 1;
+    unsigned int near_z = aRay.getDirectionSign(2) * 3 + 2;
+
+    // Widen 8 bytes to 8 floats, and map them to the node's box
+    unsigned int plane_id[6] = {near_x, 3 - near_x, near_y, 5 - near_y, near_z, 7 - near_z};
+    __m256 plane[6];
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(aNode.m_bbox[plane_id[i]]));
+        __m256i integers = _mm256_insertf128_si256(_mm256_castsi128_si256(_mm_cvtepu8_epi32(bytes)),
+                                                   _mm_cvtepu8_epi32(_mm_srli_si128(bytes, 4)), 1);
+
+        plane[i] = _mm256_add_ps(_mm256_set1_ps(aNode.m_origin[i / 2]),
+                                 _mm256_mul_ps(_mm256_cvtepi32_ps(integers), _mm256_set1_ps(aNode.m_scale[i / 2])));
+    }
+
+    __m256 origin_x = _mm256_set1_ps(origin.getX());
+    __m256 origin_y = _mm256_set1_ps(origin.getY());
+    __m256 origin_z = _mm256_set1_ps(origin.getZ());
+
+    __m256 inverse_direction_x = _mm256_set1_ps(inverse_direction.getX());
+    __m256 inverse_direction_y = _mm256_set1_ps(inverse_direction.getY());
+    __m256 inverse_direction_z = _mm256_set1_ps(inverse_direction.getZ());
+
+    __m256 tx_near = _mm256_mul_ps(_mm256_sub_ps(plane[0], origin_x), inverse_direction_x);
+    __m256 tx_far  = _mm256_mul_ps(_mm256_sub_ps(plane[1], origin_x), inverse_direction_x);
+    __m256 ty_near = _mm256_mul_ps(_mm256_sub_ps(plane[2], origin_y), inverse_direction_y);
+    __m256 ty_far  = _mm256_mul_ps(_mm256_sub_ps(plane[3], origin_y), inverse_direction_y);
+    __m256 tz_near = _mm256_mul_ps(_mm256_sub_ps(plane[4], origin_z), inverse_direction_z);
+    __m256 tz_far  = _mm256_mul_ps(_mm256_sub_ps(plane[5], origin_z), inverse_direction_z);
+
+    __m256 t_near = _mm256_max_ps(_mm256_max_ps(tx_near, ty_near), _mm256_max_ps(tz_near, _mm256_set1_ps(aRay.getTMin())));
+    __m256 t_far  = _mm256_min_ps(_mm256_min_ps(tx_far,  ty_far),  _mm256_min_ps(tz_far,  _mm256_set1_ps(aRay.getTMax())));
+
+    _mm256_storeu_ps(aTNear, t_near);
+    return _mm256_movemask_ps(_mm256_cmp_ps(t_near, t_far, _CMP_LE_OQ));
+}
+#endif
+
+
+//-----------------------------------------------------------------------------
+template<unsigned int N>
+template<typename PrimitiveIntersector>
+bool CompressedWideBVH<N>::intersect(const Ray& aRay,
+                                     const PrimitiveIntersector& anIntersector,
+                                     float& t,
+                                     unsigned int& aPrimitiveId) const
+//-----------------------------------------------------------------------------
+{
+    if (m_node_set.empty())
+    {
+        return false;
+    }
+
+    // The interval of the ray shrinks as closer intersections are found
+    Ray ray(aRay);
+    bool has_hit = false;
+
+    // Each node pushes at most N children. The entry distance of the ray
+    // in a child is stored along with it, so that the child is skipped if a
+    // closer intersection is found before it is popped
+    unsigned int stack[MAX_STACK_SIZE];
+    float stack_t_near[MAX_STACK_SIZE];
+    unsigned int stack_size = 0;
+    stack[stack_size] = 0;
+    stack_t_near[stack_size++] = ray.getTMin();
+
+    while (stack_size)
+    {
+        --stack_size;
+        if (stack_t_near[stack_size] > ray.getTMax())
+        {
+            continue;
+        }
+
+        const CompressedWideBVHNode<N>& node = m_node_set[stack[stack_size]];
+
+        // Test all the children at once
+        float t_near[N];
+        unsigned int hit_mask = intersectChildren(node, ray, t_near);
+        unsigned int first_pushed = stack_size;
+
+        for (unsigned int i = 0; hit_mask; ++i, hit_mask >>= 1)
+        {
+            if (hit_mask & 1)
+            {
+                // Test the primitives of the leaf straight away
+                if (node.m_primitive_count[i])
+                {
+                    unsigned int first = node.m_child[i];
+                    for (unsigned int j = first; j < first + node.m_primitive_count[i]; ++j)
+                    {
+                        unsigned int primitive_id = m_primitive_index_set[j];
+
+                        float primitive_t;
+                        if (anIntersector(ray, primitive_id, primitive_t))
+                        {
+                            ray.setTMax(primitive_t);
+                            aPrimitiveId = primitive_id;
+                            has_hit = true;
+                        }
+                    }
+                }
+                // Visit the internal node later. The children are sorted
+                // by decreasing distance on the stack (insertion sort, there
+                // are only a few), so that the nearest one is popped first
+                else
+                {
+                    unsigned int j = stack_size++;
+                    while (j > first_pushed && stack_t_near[j - 1] < t_near[i])
+                    {
+                        stack[j] = stack[j - 1];
+                        stack_t_near[j] = stack_t_near[j - 1];
+                        --j;
+                    }
+
+                    stack[j] = node.m_child[i];
+                    stack_t_near[j] = t_near[i];
+                }
+            }
+        }
+    }
+
+    if (has_hit)
+    {
+        t = ray.getTMax();
+    }
+
+    return has_hit;
+}
+
+
+//----------------------------------------------------------------------------
+template<unsigned int N>
+template<typename PrimitiveOccluder>
+bool CompressedWideBVH<N>::occluded(const Ray& aRay,
+                                    const PrimitiveOccluder& anOccluder) const
+//----------------------------------------------------------------------------
+{
+    if (m_node_set.empty())
+    {
+        return false;
+    }
+
+    unsigned int stack[MAX_STACK_SIZE];
+    unsigned int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size)
+    {
+        const CompressedWideBVHNode<N>& node = m_node_set[stack[--stack_size]];
+
+        float t_near[N];
+        unsigned int hit_mask = intersectChildren(node, aRay, t_near);
+
+        for (unsigned int i = 0; hit_mask; ++i, hit_mask >>= 1)
+        {
+            if (hit_mask & 1)
+            {
+                if (node.m_primitive_count[i])
+                {
+                    unsigned int first = node.m_child[i];
+                    for (unsigned int j = first; j < first + node.m_primitive_count[i]; ++j)
+                    {
+                        // Any intersection will do
+                        if (anOccluder(aRay, m_primitive_index_set[j]))
+                        {
+                            return true;
+                        }
+                    }
+                }
+                else
+                {
+                    stack[stack_size++] = node.m_child[i];
+                }
+            }
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,178 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+#ifndef __GBuffer_h
+#define __GBuffer_h
+
+
+/**
+********************************************************************************
+*
+*   @file       GBuffer.h
+*
+*   @brief      Class to store the visible surfaces of a tile of pixels for deferred shading.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <vector>
+#include <limits> // for inf
+
+#ifndef __Vec3_h
+#include "Vec3.h"
+#endif
+
+#ifndef __Hit_h
+#include "Hit.h"
+#endif
+
+
+//==============================================================================
+/**
+*   @class  GBuffer
+*   @brief  GBuffer is a class to store what the primary rays of a tile of
+*           pixels hit, for a deferred renderer: the visibility pass traces
+*           the rays and fills it, then the shading pass processes the
+*           pixels that hit the same mesh, i.e. that share their material,
+*           together. Only the hit records, the points hit and the shadow
+*           flags are stored, the shading attributes are fetched when the
+*           pixels are shaded.
+*/
+//==============================================================================
+class GBuffer
+//------------------------------------------------------------------------------
+{
+//******************************************************************************
+public:
+    void clear();
+    void reserve(size_t aSize);
+
+    //--------------------------------------------------------------------------
+    /// Add a pixel to the buffer, it is not hit yet
+    /*
+    *   @param aColumn  the column of the pixel in the image
+    *   @param aRow     the row of the pixel in the image
+    */
+    //--------------------------------------------------------------------------
+    void addPixel(unsigned int aColumn, unsigned int aRow);
+
+    size_t getSize() const;
+    unsigned int getColumn(unsigned int i) const;
+    unsigned int getRow(unsigned int i) const;
+
+    //--------------------------------------------------------------------------
+    /// Record the closest intersection of the primary ray of a pixel
+    /*
+    *   @param i        the index of the pixel in the buffer
+    *   @param aHit     the intersection
+    *   @param aMeshId  the ID of the mesh of the instance that is hit
+    *   @param aPoint   the point hit, in world space
+    */
+    //--------------------------------------------------------------------------
+    void setHit(unsigned int i,
+                const Hit& aHit,
+                unsigned int aMeshId,
+                const Vec3& aPoint);
+
+    bool hasHit(unsigned int i) const;
+    const Hit& getHit(unsigned int i) const;
+    unsigned int getMeshId(unsigned int i) const;
+    const Vec3& getPoint(unsigned int i) const;
+
+    void setShadow(unsigned int i, bool isInShadow);
+    bool isInShadow(unsigned int i) const;
+
+    //--------------------------------------------------------------------------
+    /// Group the pixels that are hit by mesh, with a counting sort. It must
+    /// be called after the visibility pass, before the groups are read.
+    /*
+    *   @param aNumberOfMeshes  the number of meshes in the scene
+    */
+    //--------------------------------------------------------------------------
+    void groupByMesh(unsigned int aNumberOfMeshes);
+
+    unsigned int getNumberOfGroups() const;
+    unsigned int getGroupMeshId(unsigned int aGroupId) const;
+    unsigned int getGroupSize(unsigned int aGroupId) const;
+
+    /// The index in the buffer of the i-th pixel of a group
+    unsigned int getGroupPixel(unsigned int aGroupId, unsigned int i) const;
+
+
+//******************************************************************************
+protected:
+    /// The pixels
+    std::vector<unsigned int> m_column_set;
+    std::vector<unsigned int> m_row_set;
+
+    /// What the pixels' primary rays hit (their distance is infinite if
+    /// they missed), and whether the points hit are in shadow
+    std::vector<Hit> m_hit_set;
+    std::vector<unsigned int> m_mesh_id_set;
+    std::vector<Vec3> m_point_set;
+    std::vector<unsigned char> m_shadow_set;
+
+    /// The pixels that are hit, grouped by mesh, the first pixel and the
+    /// mesh of each group
+    std::vector<unsigned int> m_group_pixel_set;
+    std::vector<unsigned int> m_group_offset_set;
+    std::vector<unsigned int> m_group_mesh_id_set;
+};
+
+
+#include "GBuffer.inl"
+
+
+#endif // __GBuffer_h
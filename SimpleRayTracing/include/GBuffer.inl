@@ -0,0 +1,230 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       GBuffer.inl
+*
+*   @brief      Class to store the visible surfaces of a tile of pixels for deferred shading.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//--------------------------
+inline void GBuffer::clear()
+//--------------------------
+{
+    m_column_set.clear();
+    m_row_set.clear();
+
+    m_hit_set.clear();
+    m_mesh_id_set.clear();
+    m_point_set.clear();
+    m_shadow_set.clear();
+
+    m_group_pixel_set.clear();
+    m_group_offset_set.clear();
+    m_group_mesh_id_set.clear();
+}
+
+
+//----------------------------------------
+inline void GBuffer::reserve(size_t aSize)
+//----------------------------------------
+{
+    m_column_set.reserve(aSize);
+    m_row_set.reserve(aSize);
+
+    m_hit_set.reserve(aSize);
+    m_mesh_id_set.reserve(aSize);
+    m_point_set.reserve(aSize);
+    m_shadow_set.reserve(aSize);
+
+    m_group_pixel_set.reserve(aSize);
+}
+
+
+//--------------------------------------------------------------------
+inline void GBuffer::addPixel(unsigned int aColumn, unsigned int aRow)
+//--------------------------------------------------------------------
+{
+    m_column_set.push_back(aColumn);
+    m_row_set.push_back(aRow);
+
+    m_hit_set.push_back(Hit());
+    m_mesh_id_set.push_back(0);
+    m_point_set.push_back(Vec3());
+    m_shadow_set.push_back(false);
+}
+
+
+//------------------------------------
+inline size_t GBuffer::getSize() const
+//------------------------------------
+{
+    return m_column_set.size();
+}
+
+
+//----------------------------------------------------------
+inline unsigned int GBuffer::getColumn(unsigned int i) const
+//----------------------------------------------------------
+{
+    return m_column_set[i];
+}
+
+
+//-------------------------------------------------------
+inline unsigned int GBuffer::getRow(unsigned int i) const
+//-------------------------------------------------------
+{
+    return m_row_set[i];
+}
+
+
+//-----------------------------------------------
+inline void GBuffer::setHit(unsigned int i,
+                            const Hit& aHit,
+                            unsigned int aMeshId,
+                            const Vec3& aPoint)
+//-----------------------------------------------
+{
+    m_hit_set[i] = aHit;
+    m_mesh_id_set[i] = aMeshId;
+    m_point_set[i] = aPoint;
+}
+
+
+//-----------------------------------------------
+inline bool GBuffer::hasHit(unsigned int i) const
+//-----------------------------------------------
+{
+    return m_hit_set[i].m_t != std::numeric_limits<float>::infinity();
+}
+
+
+//-----------------------------------------------------
+inline const Hit& GBuffer::getHit(unsigned int i) const
+//-----------------------------------------------------
+{
+    return m_hit_set[i];
+}
+
+
+//----------------------------------------------------------
+inline unsigned int GBuffer::getMeshId(unsigned int i) const
+//----------------------------------------------------------
+{
+    return m_mesh_id_set[i];
+}
+
+
+//--------------------------------------------------------
+inline const Vec3& GBuffer::getPoint(unsigned int i) const
+//--------------------------------------------------------
+{
+    return m_point_set[i];
+}
+
+
+//-------------------------------------------------------------
+inline void GBuffer::setShadow(unsigned int i, bool isInShadow)
+//-------------------------------------------------------------
+{
+    m_shadow_set[i] = isInShadow;
+}
+
+
+//---------------------------------------------------
+inline bool GBuffer::isInShadow(unsigned int i) const
+//---------------------------------------------------
+{
+    return m_shadow_set[i];
+}
+
+
+//----------------------------------------------------
+inline unsigned int GBuffer::getNumberOfGroups() const
+//----------------------------------------------------
+{
+    return m_group_mesh_id_set.size();
+}
+
+
+//----------------------------------------------------------------------
+inline unsigned int GBuffer::getGroupMeshId(unsigned int aGroupId) const
+//----------------------------------------------------------------------
+{
+    return m_group_mesh_id_set[aGroupId];
+}
+
+
+//--------------------------------------------------------------------
+inline unsigned int GBuffer::getGroupSize(unsigned int aGroupId) const
+//--------------------------------------------------------------------
+{
+    return m_group_offset_set[aGroupId + 1] - m_group_offset_set[aGroupId];
+}
+
+
+//-------------------------------------------------------------------------------------
+inline unsigned int GBuffer::getGroupPixel(unsigned int aGroupId, unsigned int i) const
+//-------------------------------------------------------------------------------------
+{
+    return m_group_pixel_set[m_group_offset_set[aGroupId] + i];
+}
@@ -0,0 +1,267 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+#ifndef __Grid_h
+#define __Grid_h
+
+
+/**
+********************************************************************************
+*
+*   @file       Grid.h
+*
+*   @brief      Class to manipulate a uniform or hierarchical grid traversed with 3D-DDA.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <vector>
+
+#ifndef __Vec3_h
+#include "Vec3.h"
+#endif
+
+#ifndef __Ray_h
+#include "Ray.h"
+#endif
+
+
+//==============================================================================
+/**
+*   @struct GridLevel
+*   @brief  GridLevel is a uniform grid: either the top-level grid, or the
+*           grid that subdivides a dense cell of its parent.
+*/
+//==============================================================================
+struct GridLevel
+//------------------------------------------------------------------------------
+{
+    /// The lower corner of the grid's bounding box
+    Vec3 m_lower_bbox_corner;
+
+    /// The upper corner of the grid's bounding box
+    Vec3 m_upper_bbox_corner;
+
+    /// The size of a cell along each axis
+    Vec3 m_cell_size;
+
+    /// The number of cells along each axis
+    unsigned int m_resolution[3];
+
+    /// Index of the first cell of the grid, the cells are stored x first
+    unsigned int m_first_cell;
+};
+
+
+//==============================================================================
+/**
+*   @struct GridCell
+*   @brief  GridCell is a cell of a grid. It references the primitives whose
+*           bounding box overlaps the cell, or the grid that subdivides it.
+*/
+//==============================================================================
+struct GridCell
+//------------------------------------------------------------------------------
+{
+    /// Index of the first primitive index of the cell
+    unsigned int m_first;
+
+    /// Number of primitives in the cell
+    unsigned int m_primitive_count;
+
+    /// Index of the grid that subdivides the cell, 0 if none
+    /// (the top-level grid cannot be a sub-grid)
+    unsigned int m_sub_grid;
+};
+
+
+//==============================================================================
+/**
+*   @class  Grid
+*   @brief  Grid is a class to find the primitives intersected by a ray with
+*           a uniform grid traversed with a 3D digital differential analyser
+*           (3D-DDA), see "A Fast Voxel Traversal Algorithm for Ray Tracing"
+*           by Amanatides and Woo (1987).
+*
+*           The grid is built in linear time: its resolution is derived from
+*           the number of primitives and the shape of their bounding box.
+*           In a hierarchical grid, the cells that reference too many
+*           primitives are subdivided by another uniform grid.
+*/
+//==============================================================================
+class Grid
+//------------------------------------------------------------------------------
+{
+//******************************************************************************
+public:
+    Grid();
+
+    //--------------------------------------------------------------------------
+    /// Build the grid
+    /*
+    *   @param aLowerBBoxCornerSet  the lower corners of the primitives' bbox
+    *   @param anUpperBBoxCornerSet the upper corners of the primitives' bbox
+    *   @param aLowerBBoxCorner     the lower corner of the bbox of all the primitives
+    *   @param anUpperBBoxCorner    the upper corner of the bbox of all the primitives
+    *   @param aNumberOfLevels      1 for a uniform grid, more for a hierarchical grid
+    */
+    //--------------------------------------------------------------------------
+    void build(const std::vector<Vec3>& aLowerBBoxCornerSet,
+               const std::vector<Vec3>& anUpperBBoxCornerSet,
+               const Vec3& aLowerBBoxCorner,
+               const Vec3& anUpperBBoxCorner,
+               unsigned int aNumberOfLevels = 1);
+
+    void clear();
+
+    bool isEmpty() const;
+
+    /// Wall-clock time of the last build, in seconds
+    double getBuildTime() const;
+
+    unsigned int getNumberOfLevels() const;
+
+    size_t getNumberOfGrids() const;
+    const GridLevel& getGrid(unsigned int i) const;
+
+    size_t getNumberOfCells() const;
+
+    size_t getNumberOfPrimitiveIndices() const;
+
+    //--------------------------------------------------------------------------
+    /// Find the closest primitive intersected by a ray
+    /*
+    *   @param aRay             the ray
+    *   @param anIntersector    functor with the signature
+    *                           bool (const Ray&, unsigned int aPrimitiveId, float& t)
+    *                           that returns true if the primitive is hit
+    *                           within the ray's interval
+    *   @param t                the distance of the closest intersection
+    *   @param aPrimitiveId     the ID of the closest primitive
+    *   @return true if an intersection was found within the ray's interval
+    */
+    //-------------------------------------------------------
+    template<typename PrimitiveIntersector>
+    bool intersect(const Ray& aRay,
+                   const PrimitiveIntersector& anIntersector,
+                   float& t,
+                   unsigned int& aPrimitiveId) const;
+
+    //-------------------------------------------------------
+    /// Check if any primitive intersects a ray (any-hit query)
+    /*
+    *   @param aRay             the ray
+    *   @param anOccluder       functor with the signature
+    *                           bool (const Ray&, unsigned int aPrimitiveId)
+    *                           that returns true if the primitive is hit
+    *                           within the ray's interval
+    *   @return true if an intersection was found within the ray's interval
+    */
+    //--------------------------------------------------------------------------
+    template<typename PrimitiveOccluder>
+    bool occluded(const Ray& aRay,
+                  const PrimitiveOccluder& anOccluder) const;
+
+
+//******************************************************************************
+protected:
+    static const unsigned int MAX_RESOLUTION = 512;
+    static const unsigned int MAX_PRIMITIVES_PER_CELL = 32;
+
+    //--------------------------------------------------------------------------
+    /// Visit the cells pierced by a ray in front-to-back order
+    /*
+    *   @param aGridId      the grid to traverse
+    *   @param aRay         the ray
+    *   @param aTStart      the distance along the ray where the walk starts
+    *   @param aTEnd        the distance along the ray where the walk ends
+    *   @param aVisitor     functor with the signature
+    *                       bool (const GridCell&, float aTExit)
+    *                       that returns true to stop the walk
+    *   @return true if the visitor stopped the walk
+    */
+    //--------------------------------------------------------------------------
+    template<typename CellVisitor>
+    bool walk(unsigned int aGridId,
+              const Ray& aRay,
+              float aTStart,
+              float aTEnd,
+              const CellVisitor& aVisitor) const;
+
+    unsigned int buildLevel(const std::vector<Vec3>& aLowerBBoxCornerSet,
+                            const std::vector<Vec3>& anUpperBBoxCornerSet,
+                            const std::vector<unsigned int>& aPrimitiveIdSet,
+                            const Vec3& aLowerBBoxCorner,
+                            const Vec3& anUpperBBoxCorner,
+                            unsigned int aLevel);
+
+    /// The grids, the top-level grid is the first one
+    std::vector<GridLevel> m_grid_set;
+
+    /// The cells of all the grids
+    std::vector<GridCell> m_cell_set;
+
+    /// The primitive indices referenced by the cells
+    std::vector<unsigned int> m_primitive_index_set;
+
+    unsigned int m_number_of_levels;
+    double m_build_time;
+};
+
+
+#include "Grid.inl"
+
+
+#endif // __Grid_h
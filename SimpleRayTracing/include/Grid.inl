@@ -0,0 +1,361 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       Grid.inl
+*
+*   @brief      Class to manipulate a uniform or hierarchical grid traversed with 3D-DDA.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <algorithm> // for min/max
+#include <limits>    // for inf
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//------------------
+inline Grid::Grid():
+//------------------
+        m_number_of_levels(0),
+        m_build_time(0.0)
+//-------------------
+{
+    // Do nothing
+}
+
+
+//-----------------------
+inline void Grid::clear()
+//-----------------------
+{
+    m_grid_set.clear();
+    m_cell_set.clear();
+    m_primitive_index_set.clear();
+    m_number_of_levels = 0;
+    m_build_time = 0.0;
+}
+
+
+//-----------------------------
+inline bool Grid::isEmpty() const
+//-----------------------------
+{
+    return m_grid_set.empty();
+}
+
+
+//-----------------------------------------
+inline double Grid::getBuildTime() const
+//-----------------------------------------
+{
+    return m_build_time;
+}
+
+
+//------------------------------------------------
+inline unsigned int Grid::getNumberOfLevels() const
+//------------------------------------------------
+{
+    return m_number_of_levels;
+}
+
+
+//------------------------------------------
+inline size_t Grid::getNumberOfGrids() const
+//------------------------------------------
+{
+    return m_grid_set.size();
+}
+
+
+//-----------------------------------------------------------
+inline const GridLevel& Grid::getGrid(unsigned int i) const
+//-----------------------------------------------------------
+{
+    return m_grid_set[i];
+}
+
+
+//------------------------------------------
+inline size_t Grid::getNumberOfCells() const
+//------------------------------------------
+{
+    return m_cell_set.size();
+}
+
+
+//-----------------------------------------------------
+inline size_t Grid::getNumberOfPrimitiveIndices() const
+//-----------------------------------------------------
+{
+    return m_primitive_index_set.size();
+}
+
+
+//-------------------------------------------------------------
+template<typename PrimitiveIntersector>
+bool Grid::intersect(const Ray& aRay,
+                     const PrimitiveIntersector& anIntersector,
+                     float& t,
+                     unsigned int& aPrimitiveId) const
+//-------------------------------------------------------------
+{
+    if (m_grid_set.empty())
+    {
+        return false;
+    }
+
+    // The interval of the ray shrinks as closer intersections are found
+    Ray ray(aRay);
+    bool has_hit = false;
+
+    const std::vector<unsigned int>& primitive_index_set = m_primitive_index_set;
+
+    auto visitor = [&](const GridCell& aCell, float aTExit)
+    {
+        for (unsigned int i = aCell.m_first; i < aCell.m_first + aCell.m_primitive_count; ++i)
+        {
+            unsigned int primitive_id = primitive_index_set[i];
+
+            float primitive_t;
+            if (anIntersector(ray, primitive_id, primitive_t))
+            {
+                ray.setTMax(primitive_t);
+                aPrimitiveId = primitive_id;
+                has_hit = true;
+            }
+        }
+
+        // A primitive overlaps several cells: its intersection may be
+        // beyond the current cell, and a closer one may be in the next cells
+        return ray.getTMax() <= aTExit;
+    };
+
+    walk(0, ray, ray.getTMin(), ray.getTMax(), visitor);
+
+    if (has_hit)
+    {
+        t = ray.getTMax();
+    }
+
+    return has_hit;
+}
+
+
+//------------------------------------------------------------
+template<typename PrimitiveOccluder>
+bool Grid::occluded(const Ray& aRay,
+                    const PrimitiveOccluder& anOccluder) const
+//------------------------------------------------------------
+{
+    if (m_grid_set.empty())
+    {
+        return false;
+    }
+
+    const std::vector<unsigned int>& primitive_index_set = m_primitive_index_set;
+
+    // Stop at the first intersection, wherever it is along the ray
+    auto visitor = [&](const GridCell& aCell, float /*aTExit*/)
+    {
+        for (unsigned int i = aCell.m_first; i < aCell.m_first + aCell.m_primitive_count; ++i)
+        {
+            if (anOccluder(aRay, primitive_index_set[i]))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    };
+
+    return walk(0, aRay, aRay.getTMin(), aRay.getTMax(), visitor);
+}
+
+
+//------------------------------------------------
+template<typename CellVisitor>
+bool Grid::walk(unsigned int aGridId,
+                const Ray& aRay,
+                float aTStart,
+                float aTEnd,
+                const CellVisitor& aVisitor) const
+//------------------------------------------------
+{
+    const GridLevel& grid = m_grid_set[aGridId];
+
+    // Clip the ray by the grid's bbox
+    float t_near;
+    float t_far;
+    if (!aRay.intersect(grid.m_lower_bbox_corner, grid.m_upper_bbox_corner, t_near, t_far))
+    {
+        return false;
+    }
+
+    t_near = std::max(t_near, aTStart);
+    t_far = std::min(t_far, aTEnd);
+    if (t_near > t_far)
+    {
+        return false;
+    }
+
+    // Find the cell where the ray enters the grid, and along each axis,
+    // the distance to the next cell boundary and between two boundaries
+    const Vec3& origin = aRay.getOrigin();
+    const Vec3& direction = aRay.getDirection();
+    float inf = std::numeric_limits<float>::infinity();
+
+    int cell[3];
+    int step[3];
+    int out[3];
+    float t_next[3];
+    float t_delta[3];
+
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        int resolution = grid.m_resolution[axis];
+        float cell_size = grid.m_cell_size[axis];
+        float position = origin[axis] + direction[axis] * t_near;
+
+        cell[axis] = 0;
+        if (cell_size > 0.0)
+        {
+            cell[axis] = std::min(resolution - 1, std::max(0,
+                    int((position - grid.m_lower_bbox_corner[axis]) / cell_size)));
+        }
+
+        if (direction[axis] > 0.0)
+        {
+            float boundary = grid.m_lower_bbox_corner[axis] + (cell[axis] + 1) * cell_size;
+            step[axis] = 1;
+            out[axis] = resolution;
+            t_next[axis] = (boundary - origin[axis]) / direction[axis];
+            t_delta[axis] = cell_size / direction[axis];
+        }
+        else if (direction[axis] < 0.0)
+        {
+            float boundary = grid.m_lower_bbox_corner[axis] + cell[axis] * cell_size;
+            step[axis] = -1;
+            out[axis] = -1;
+            t_next[axis] = (boundary - origin[axis]) / direction[axis];
+            t_delta[axis] = -cell_size / direction[axis];
+        }
+        else
+        {
+            step[axis] = 0;
+            out[axis] = -1;
+            t_next[axis] = inf;
+            t_delta[axis] = inf;
+        }
+    }
+
+    // Visit the cells front-to-back
+    float t_enter = t_near;
+    while (true)
+    {
+        // The cell is further away than the closest intersection found so far
+        if (t_enter > aRay.getTMax())
+        {
+            return false;
+        }
+
+        unsigned int cell_id = grid.m_first_cell + cell[0] +
+                grid.m_resolution[0] * (cell[1] + grid.m_resolution[1] * cell[2]);
+        const GridCell& grid_cell = m_cell_set[cell_id];
+
+        unsigned int axis = 0;
+        if (t_next[1] < t_next[axis]) axis = 1;
+        if (t_next[2] < t_next[axis]) axis = 2;
+
+        float t_exit = std::min(t_next[axis], t_far);
+
+        if (grid_cell.m_sub_grid)
+        {
+            if (walk(grid_cell.m_sub_grid, aRay, t_enter, t_exit, aVisitor))
+            {
+                return true;
+            }
+        }
+        else if (grid_cell.m_primitive_count)
+        {
+            if (aVisitor(grid_cell, t_exit))
+            {
+                return true;
+            }
+        }
+
+        // Step into the next cell along the axis of the closest boundary
+        if (t_next[axis] >= t_far)
+        {
+            return false;
+        }
+
+        cell[axis] += step[axis];
+        if (cell[axis] == out[axis])
+        {
+            return false;
+        }
+
+        t_enter = t_next[axis];
+        t_next[axis] += t_delta[axis];
+    }
+}
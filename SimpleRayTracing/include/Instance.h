@@ -0,0 +1,129 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+#ifndef __Instance_h
+#define __Instance_h
+
+
+/**
+********************************************************************************
+*
+*   @file       Instance.h
+*
+*   @brief      Class to manipulate an instance of a triangle mesh.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#ifndef __Ray_h
+#include "Ray.h"
+#endif
+
+#ifndef __Transform_h
+#include "Transform.h"
+#endif
+
+
+//==============================================================================
+/**
+*   @class  Instance
+*   @brief  Instance is a class to place a shared triangle mesh in the scene.
+*           It only holds the ID of the mesh and its transformation, so that
+*           many instances of the same mesh do not duplicate its triangles,
+*           its texture or its BVH.
+*/
+//==============================================================================
+class Instance
+//------------------------------------------------------------------------------
+{
+//******************************************************************************
+public:
+    Instance(unsigned int aMeshId, const Transform& aTransform = Transform());
+
+    unsigned int getMeshId() const;
+
+    void setTransform(const Transform& aTransform);
+    const Transform& getTransform() const;
+    const Transform& getInverseTransform() const;
+
+    bool isIdentity() const;
+
+    //--------------------------------------------------------------------------
+    /// Transform a ray from world space to the mesh's object space
+    /*
+    *   @param aRay     the ray in world space
+    *   @param aScale   the ratio between distances along the ray in
+    *                   object space and in world space
+    *   @return the ray in object space
+    */
+    //--------------------------------------------------------------------------
+    Ray transformRay(const Ray& aRay, float& aScale) const;
+
+    Vec3 transformNormal(const Vec3& aNormal) const;
+
+//******************************************************************************
+private:
+    unsigned int m_mesh_id;
+
+    Transform m_transform;
+    Transform m_inverse_transform;
+    Transform m_normal_transform;
+};
+
+
+#include "Instance.inl"
+
+
+#endif // __Instance_h
@@ -0,0 +1,139 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       Instance.inl
+*
+*   @brief      Class to manipulate an instance of a triangle mesh.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//-----------------------------------------------------
+inline Instance::Instance(unsigned int aMeshId,
+                          const Transform& aTransform):
+//-----------------------------------------------------
+        m_mesh_id(aMeshId)
+//-----------------------------------------------------
+{
+    setTransform(aTransform);
+}
+
+
+//-------------------------------------------------
+inline unsigned int Instance::getMeshId() const
+//-------------------------------------------------
+{
+    return m_mesh_id;
+}
+
+
+//--------------------------------------------------------------
+inline void Instance::setTransform(const Transform& aTransform)
+//--------------------------------------------------------------
+{
+    m_transform = aTransform;
+    m_inverse_transform = aTransform.getInverse();
+    m_normal_transform = aTransform.getNormalTransform();
+}
+
+
+//-------------------------------------------------------
+inline const Transform& Instance::getTransform() const
+//-------------------------------------------------------
+{
+    return m_transform;
+}
+
+
+//--------------------------------------------------------------
+inline const Transform& Instance::getInverseTransform() const
+//--------------------------------------------------------------
+{
+    return m_inverse_transform;
+}
+
+
+//---------------------------------------
+inline bool Instance::isIdentity() const
+//---------------------------------------
+{
+    return m_transform.isIdentity();
+}
+
+
+//-----------------------------------------------------------------------
+inline Ray Instance::transformRay(const Ray& aRay, float& aScale) const
+//-----------------------------------------------------------------------
+{
+    Vec3 direction = m_inverse_transform.transformVector(aRay.getDirection());
+    aScale = direction.getLength();
+
+    // The direction is normalised, so the distances are scaled
+    return Ray(m_inverse_transform.transformPoint(aRay.getOrigin()), direction,
+            aRay.getTMin() * aScale, aRay.getTMax() * aScale);
+}
+
+
+//---------------------------------------------------------------
+inline Vec3 Instance::transformNormal(const Vec3& aNormal) const
+//---------------------------------------------------------------
+{
+    return normalise(m_normal_transform.transformVector(aNormal));
+}
@@ -0,0 +1,188 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+#ifndef __MeshCache_h
+#define __MeshCache_h
+
+
+/**
+********************************************************************************
+*
+*   @file       MeshCache.h
+*
+*   @brief      Class to save and load triangle meshes with their BVH in binary cache files.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <string>
+#include <vector>
+#include <stdint.h> // for uint64_t
+
+#ifndef __TriangleMesh_h
+#include "TriangleMesh.h"
+#endif
+
+
+//==============================================================================
+/**
+*   @class  MeshCache
+*   @brief  MeshCache is a class to store triangle meshes together with their
+*           BVH in a directory of versioned binary files, so that later runs
+*           skip both the import of the model and the build of the BVH.
+*           A mesh file is keyed by a hash of the mesh's vertex and index
+*           buffers and of its material. An index file, keyed by the path, size and modification
+*           time of the model file, lists the meshes of the model. The files
+*           are memory-mapped when possible.
+*/
+//==============================================================================
+class MeshCache
+//------------------------------------------------------------------------------
+{
+//******************************************************************************
+public:
+    //--------------------------------------------------------------------------
+    /// Constructor
+    /*
+    *   @param aDirectory   the directory of the cache files, the cache is
+    *                       disabled if it is empty
+    */
+    //--------------------------------------------
+    MeshCache(const std::string& aDirectory = "");
+
+    bool isEnabled() const;
+    const std::string& getDirectory() const;
+
+    //--------------------------------------------
+    /// Compute the key of a mesh (FNV-1a hash of its buffers and material).
+    /// The material is part of the key as it is restored with the mesh
+    /*
+    *   @param aVertexSet   the vertices
+    *   @param anIndexSet   the indices
+    *   @param aMaterial    the material
+    *   @return the key
+    */
+    //----------------------------------------------------------------------
+    static uint64_t computeKey(const std::vector<float>& aVertexSet,
+                               const std::vector<unsigned int>& anIndexSet,
+                               const Material& aMaterial);
+
+    //----------------------------------------------------------------------
+    /// Load a mesh, its material and its BVH from the cache
+    /*
+    *   @param aKey     the key of the mesh
+    *   @param aMesh    the mesh, its build method selects the cache file
+    *   @return true if the mesh was found in the cache, false otherwise
+    *           (missing, outdated or corrupted file)
+    */
+    //--------------------------------------------------
+    bool load(uint64_t aKey, TriangleMesh& aMesh) const;
+
+    //--------------------------------------------------
+    /// Save a mesh, its material and its BVH in the cache
+    /*
+    *   @param aKey     the key of the mesh
+    *   @param aMesh    the mesh
+    *   @return true if the file was written, false otherwise
+    */
+    //--------------------------------------------------------
+    bool save(uint64_t aKey, const TriangleMesh& aMesh) const;
+
+    //--------------------------------------------------------
+    /// Load the keys of the meshes of a model file
+    /*
+    *   @param aFileName    the model file
+    *   @param aKeySet      the keys of its meshes
+    *   @return true if the index is up-to-date with the model file
+    */
+    //---------------------------------------------------
+    bool loadIndex(const std::string& aFileName,
+                   std::vector<uint64_t>& aKeySet) const;
+
+    //---------------------------------------------------
+    /// Save the keys of the meshes of a model file
+    /*
+    *   @param aFileName    the model file
+    *   @param aKeySet      the keys of its meshes
+    *   @return true if the file was written, false otherwise
+    */
+    //--------------------------------------------------------------------------
+    bool saveIndex(const std::string& aFileName,
+                   const std::vector<uint64_t>& aKeySet) const;
+
+
+//******************************************************************************
+protected:
+    /// Increase it each time the file layout changes
+    static const unsigned int VERSION = 2;
+
+    std::string getMeshFileName(uint64_t aKey,
+                                BVH::BuildMethod aBuildMethod,
+                                bool aRestructuringFlag) const;
+
+    std::string getIndexFileName(const std::string& aFileName) const;
+
+    bool writeFile(const std::string& aFileName,
+                   const std::vector<char>& aBuffer) const;
+
+    /// The directory of the cache files
+    std::string m_directory;
+};
+
+
+#include "MeshCache.inl"
+
+
+#endif // __MeshCache_h
@@ -0,0 +1,138 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+#ifndef __OccluderCache_h
+#define __OccluderCache_h
+
+
+/**
+********************************************************************************
+*
+*   @file       OccluderCache.h
+*
+*   @brief      Last occluder of the shadow rays of a thread.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//==============================================================================
+/**
+*   @class  OccluderCache
+*   @brief  OccluderCache remembers the triangle that last occluded a shadow
+*           ray. The shadow rays of neighbouring pixels are often blocked
+*           by the same triangle, which is tested first before any
+*           traversal (see Scene::occluded). Each rendering thread owns its
+*           cache. The cache hits are counted to measure its hit rate.
+*/
+//==============================================================================
+class OccluderCache
+//------------------------------------------------------------------------------
+{
+//******************************************************************************
+public:
+    OccluderCache();
+
+    /// Forget the occluder and reset the counters
+    void clear();
+
+    /// True if a ray has been occluded since the last clear
+    bool hasOccluder() const;
+    unsigned int getInstanceId() const;
+    unsigned int getTriangleId() const;
+
+    //--------------------------------------------------------------------------
+    /// Record the triangle that occluded the last shadow ray
+    /*
+    *   @param anInstanceId the ID of the instance
+    *   @param aTriangleId  the ID of the triangle in the instance's mesh
+    */
+    //--------------------------------------------------------------------------
+    void setOccluder(unsigned int anInstanceId, unsigned int aTriangleId);
+
+    //--------------------------------------------------------------------------
+    /// Count a shadow ray
+    /*
+    *   @param isOccluded   true if the ray is occluded
+    *   @param isCacheHit   true if the cached triangle occludes it
+    */
+    //--------------------------------------------------------------------------
+    void addQuery(bool isOccluded, bool isCacheHit);
+
+    /// Add the counters of another cache, e.g. of another thread
+    void addCounters(const OccluderCache& aCache);
+
+    unsigned long long getNumberOfQueries() const;
+    unsigned long long getNumberOfOccludedRays() const;
+    unsigned long long getNumberOfCacheHits() const;
+
+    /// The ratio of the shadow rays that are occluded by the cached triangle
+    double getHitRate() const;
+
+
+//******************************************************************************
+protected:
+    /// The last occluder
+    bool m_has_occluder;
+    unsigned int m_instance_id;
+    unsigned int m_triangle_id;
+
+    /// The counters of shadow rays
+    unsigned long long m_query_count;
+    unsigned long long m_occluded_count;
+    unsigned long long m_cache_hit_count;
+};
+
+
+#include "OccluderCache.inl"
+
+
+#endif // __OccluderCache_h
@@ -0,0 +1,187 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       OccluderCache.inl
+*
+*   @brief      Last occluder of the shadow rays of a thread.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//-----------------------------------
+inline OccluderCache::OccluderCache()
+//-----------------------------------
+{
+    clear();
+}
+
+
+//--------------------------------
+inline void OccluderCache::clear()
+//--------------------------------
+{
+    m_has_occluder = false;
+    m_instance_id = 0;
+    m_triangle_id = 0;
+
+    m_query_count = 0;
+    m_occluded_count = 0;
+    m_cache_hit_count = 0;
+}
+
+
+//--------------------------------------------
+inline bool OccluderCache::hasOccluder() const
+//--------------------------------------------
+{
+    return m_has_occluder;
+}
+
+
+//------------------------------------------------------
+inline unsigned int OccluderCache::getInstanceId() const
+//------------------------------------------------------
+{
+    return m_instance_id;
+}
+
+
+//------------------------------------------------------
+inline unsigned int OccluderCache::getTriangleId() const
+//------------------------------------------------------
+{
+    return m_triangle_id;
+}
+
+
+//---------------------------------------------------------------
+inline void OccluderCache::setOccluder(unsigned int anInstanceId,
+                                       unsigned int aTriangleId)
+//---------------------------------------------------------------
+{
+    m_has_occluder = true;
+    m_instance_id = anInstanceId;
+    m_triangle_id = aTriangleId;
+}
+
+
+//-------------------------------------------------------------------
+inline void OccluderCache::addQuery(bool isOccluded, bool isCacheHit)
+//-------------------------------------------------------------------
+{
+    ++m_query_count;
+
+    if (isOccluded)
+    {
+        ++m_occluded_count;
+    }
+
+    if (isCacheHit)
+    {
+        ++m_cache_hit_count;
+    }
+}
+
+
+//-----------------------------------------------------------------
+inline void OccluderCache::addCounters(const OccluderCache& aCache)
+//-----------------------------------------------------------------
+{
+    m_query_count += aCache.m_query_count;
+    m_occluded_count += aCache.m_occluded_count;
+    m_cache_hit_count += aCache.m_cache_hit_count;
+}
+
+
+//-----------------------------------------------------------------
+inline unsigned long long OccluderCache::getNumberOfQueries() const
+//-----------------------------------------------------------------
+{
+    return m_query_count;
+}
+
+
+//----------------------------------------------------------------------
+inline unsigned long long OccluderCache::getNumberOfOccludedRays() const
+//----------------------------------------------------------------------
+{
+    return m_occluded_count;
+}
+
+
+//-------------------------------------------------------------------
+inline unsigned long long OccluderCache::getNumberOfCacheHits() const
+//-------------------------------------------------------------------
+{
+    return m_cache_hit_count;
+}
+
+
+//---------------------------------------------
+inline double OccluderCache::getHitRate() const
+//---------------------------------------------
+{
+    if (!m_query_count)
+    {
+        return 0.0;
+    }
+
+    return double(m_cache_hit_count) / m_query_count;
+}
@@ -66,6 +66,8 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //******************************************************************************
 //  Include
 //******************************************************************************
+#include <limits> // for inf
+
 #ifndef Vec3_h
 #include "Vec3.h"
 #endif
@@ -74,11 +76,17 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Triangle.h"
 #endif
 
+#ifndef __TriangleRecord_h
+#include "TriangleRecord.h"
+#endif
+
 
 //==============================================================================
 /**
 *   @class  Ray
-*   @brief  Ray is a class to handle a ray.
+*   @brief  Ray is a class to handle a ray. Only the intersections between
+*           tMin and tMax along the ray are considered, e.g. a shadow ray
+*           stops at the light.
 */
 //==============================================================================
 class Ray
@@ -86,7 +94,10 @@ class Ray
 {
 public:
     Ray(const Ray& aRay);
-    Ray(const Vec3& anOrigin, const Vec3& aDirection);
+    Ray(const Vec3& anOrigin,
+        const Vec3& aDirection,
+        float aTMin = 0.0,
+        float aTMax = std::numeric_limits<float>::infinity());
 
     Ray& operator=(const Ray& aRay);
 
@@ -96,14 +107,85 @@ public:
     void setOrigin(const Vec3& aPoint);
     void setDirection(const Vec3& aUnitVector);
 
+    float getTMin() const;
+    float getTMax() const;
+
+    void setTMin(float aTMin);
+    void setTMax(float aTMax);
+
+    const Vec3& getInverseDirection() const;
+    unsigned int getDirectionSign(unsigned int i) const;
+
     Vec3 getPointAt(float t) const;
 
+    //--------------------------------------------------------------------------
+    /// Intersect the ray with a triangle
+    /*
+    *   @param aTriangle    the triangle
+    *   @param t            the distance to the intersection (unchanged if none)
+    *   @return true if the triangle is hit strictly between tMin and tMax
+    */
+    //--------------------------------------------------------------------------
     bool intersect(const Triangle& aTriangle, float& t) const;
 
+    //--------------------------------------------------------------------------
+    /// Intersect the ray with a triangle whose edges are precomputed
+    /*
+    *   @param aRecord      the vertex and edges of the triangle
+    *   @param t            the distance to the intersection (unchanged if none)
+    *   @return true if the triangle is hit strictly between tMin and tMax
+    */
+    //--------------------------------------------------------------------------
+    bool intersect(const TriangleRecord& aRecord, float& t) const;
+
+    //--------------------------------------------------------------------------
+    /// Intersect the ray with a triangle whose edges are precomputed, and
+    /// keep the barycentric coordinates of the intersection
+    /*
+    *   @param aRecord      the vertex and edges of the triangle
+    *   @param t            the distance to the intersection (unchanged if none)
+    *   @param u            the barycentric coordinate of P2 (unchanged if none)
+    *   @param v            the barycentric coordinate of P3 (unchanged if none)
+    *   @return true if the triangle is hit strictly between tMin and tMax
+    */
+    //--------------------------------------------------------------------------
+    bool intersect(const TriangleRecord& aRecord,
+                   float& t,
+                   float& u,
+                   float& v) const;
+
+    //--------------------------------------------------------------------------
+    /// Intersect the ray with an axis-aligned bounding box (slab test)
+    /*
+    *   @param aLowerBBoxCorner     the lower corner of the box
+    *   @param anUpperBBoxCorner    the upper corner of the box
+    *   @param tNear                the distance where the ray enters the box
+    *   @param tFar                 the distance where the ray leaves the box
+    *   @return true if the ray intersects the box between tMin and tMax
+    *           (tNear and tFar are clipped to that interval)
+    */
+    //--------------------------------------------------------------------------
+    bool intersect(const Vec3& aLowerBBoxCorner,
+                   const Vec3& anUpperBBoxCorner,
+                   float& tNear,
+                   float& tFar) const;
+
 //******************************************************************************
 private:
+    void updateInverseDirection();
+
     Vec3 m_origin;
     Vec3 m_direction;
+
+    /// The interval of valid intersection distances
+    float m_t_min;
+    float m_t_max;
+
+    /// 1 / m_direction, cached for the ray/box tests
+    Vec3 m_inverse_direction;
+
+    /// 1 if the corresponding component of m_direction is negative, 0 otherwise
+    unsigned int m_direction_sign[3];
 };
 
 #include "Ray.inl"
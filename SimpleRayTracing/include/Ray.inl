@@ -63,6 +63,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //  Include
 //******************************************************************************
 #include <cmath>
+#include <algorithm> // for min/max
 
 
 //******************************************************************************
@@ -72,9 +73,13 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 //--------------------------------------
 inline Ray::Ray(const Vec3& anOrigin,
-				const Vec3& aDirection):
+				const Vec3& aDirection,
+				float aTMin,
+				float aTMax):
 //--------------------------------------
-	    m_origin(anOrigin)
+	    m_origin(anOrigin),
+	    m_t_min(aTMin),
+	    m_t_max(aTMax)
 //--------------------------------------
 {
     float length = aDirection.getLength();
@@ -82,6 +87,24 @@ inline Ray::Ray(const Vec3& anOrigin,
     {
         m_direction = aDirection / length;
     }
+
+    updateInverseDirection();
+}
+
+
+//-------------------------------
+inline Ray::Ray(const Ray& aRay):
+//-------------------------------
+        m_origin(aRay.m_origin),
+        m_direction(aRay.m_direction),
+        m_t_min(aRay.m_t_min),
+        m_t_max(aRay.m_t_max),
+        m_inverse_direction(aRay.m_inverse_direction)
+//-------------------------------
+{
+    m_direction_sign[0] = aRay.m_direction_sign[0];
+    m_direction_sign[1] = aRay.m_direction_sign[1];
+    m_direction_sign[2] = aRay.m_direction_sign[2];
 }
 
 
@@ -91,6 +114,13 @@ inline Ray& Ray::operator=(const Ray& aRay)
 {
     m_origin = aRay.m_origin;
     m_direction = aRay.m_direction;
+    m_t_min = aRay.m_t_min;
+    m_t_max = aRay.m_t_max;
+    m_inverse_direction = aRay.m_inverse_direction;
+
+    m_direction_sign[0] = aRay.m_direction_sign[0];
+    m_direction_sign[1] = aRay.m_direction_sign[1];
+    m_direction_sign[2] = aRay.m_direction_sign[2];
 
     return *this;
 }
@@ -125,6 +155,56 @@ inline void Ray::setDirection(const Vec3& aUnitVector)
 //----------------------------------------------------
 {
     m_direction = aUnitVector / aUnitVector.getLength();
+
+    updateInverseDirection();
+}
+
+
+//-------------------------------
+inline float Ray::getTMin() const
+//-------------------------------
+{
+    return m_t_min;
+}
+
+
+//-------------------------------
+inline float Ray::getTMax() const
+//-------------------------------
+{
+    return m_t_max;
+}
+
+
+//-----------------------------------
+inline void Ray::setTMin(float aTMin)
+//-----------------------------------
+{
+    m_t_min = aTMin;
+}
+
+
+//-----------------------------------
+inline void Ray::setTMax(float aTMax)
+//-----------------------------------
+{
+    m_t_max = aTMax;
+}
+
+
+//-------------------------------------------------
+inline const Vec3& Ray::getInverseDirection() const
+//-------------------------------------------------
+{
+    return m_inverse_direction;
+}
+
+
+//-------------------------------------------------------------
+inline unsigned int Ray::getDirectionSign(unsigned int i) const
+//-------------------------------------------------------------
+{
+    return m_direction_sign[i];
 }
 
 
@@ -134,3 +214,137 @@ inline Vec3 Ray::getPointAt(float t) const
 {
     return m_origin + m_direction * t;
 }
+
+
+//-------------------------------------------------------------------
+inline bool Ray::intersect(const Triangle& aTriangle, float& t) const
+//-------------------------------------------------------------------
+{
+    // Find vectors for two edges sharing vert
+    // (they are precomputed for the triangles of a mesh)
+    return intersect(TriangleRecord(aTriangle), t);
+}
+
+
+//-----------------------------------------------------------------------
+inline bool Ray::intersect(const TriangleRecord& aRecord, float& t) const
+//-----------------------------------------------------------------------
+{
+    // The barycentric coordinates are dropped
+    float u;
+    float v;
+    return intersect(aRecord, t, u, v);
+}
+
+
+//-------------------------------------------------------
+inline bool Ray::intersect(const TriangleRecord& aRecord,
+                           float& t,
+                           float& u,
+                           float& v) const
+//-------------------------------------------------------
+{
+    //    ARTICLE
+    //    Fast, minimum storage ray/triangle intersection
+    //    Share on
+    //    Authors:
+    //    Tomas Möller profile imageTomas Möller, Ben  Trumbore profile imageBen Trumbore
+    //
+    // Publication: SIGGRAPH '05: ACM SIGGRAPH 2005 CoursesJuly 2005 Pages 7–eshttps://doi.org/10.1145/1198555.1198746
+
+    // See https://cadxfem.org/inf/Fast%20MinimumStorage%20RayTriangle%20Intersection.pdf
+
+    // The edges sharing P1 were computed beforehand
+    const Vec3& edge1 = aRecord.m_edge1;
+    const Vec3& edge2 = aRecord.m_edge2;
+
+    // Begin calculating determinant - also used to calculate U parameter
+    Vec3 pvec = m_direction.crossProduct(edge2);
+
+    // If determinant is near zero, ray lies in plane of triangle
+    float det = edge1.dotProduct(pvec);
+    if (std::fpclassify(det) == FP_ZERO)
+    {
+        return false;
+    }
+
+    float inv_det = 1.0 / det;
+
+    // Calculate distance from vert P1 to ray origin
+    Vec3 tvec = m_origin - aRecord.m_p1;
+
+    // Calculate U parameter and test bounds
+    float temp_u = tvec.dotProduct(pvec) * inv_det;
+    if (temp_u < 0.0 || temp_u > 1.0)
+    {
+        return false;
+    }
+
+    // Prepare to test V parameter
+    Vec3 qvec = tvec.crossProduct(edge1);
+
+    // Calculate t, and reject the intersections outside of the ray's
+    // interval before the last barycentric test
+    float temp_t = edge2.dotProduct(qvec) * inv_det;
+    if (temp_t <= m_t_min || temp_t >= m_t_max)
+    {
+        return false;
+    }
+
+    // Calculate V parameter and test bounds
+    float temp_v = m_direction.dotProduct(qvec) * inv_det;
+    if (temp_v < 0.0 || temp_u + temp_v > 1.0)
+    {
+        return false;
+    }
+
+    // Ray intersects triangle
+    t = temp_t;
+    u = temp_u;
+    v = temp_v;
+
+    return true;
+}
+
+
+//-------------------------------------------------------
+inline bool Ray::intersect(const Vec3& aLowerBBoxCorner,
+                           const Vec3& anUpperBBoxCorner,
+                           float& tNear,
+                           float& tFar) const
+//-------------------------------------------------------
+{
+    // See "An Efficient and Robust Ray-Box Intersection Algorithm"
+    // by Williams et al., Journal of Graphics Tools, 2005.
+    // The sign bits select the near and far planes of every slab,
+    // so that no swap is needed.
+    const Vec3* p_bounds[2] = {&aLowerBBoxCorner, &anUpperBBoxCorner};
+
+    float tx_near = (p_bounds[    m_direction_sign[0]]->getX() - m_origin.getX()) * m_inverse_direction.getX();
+    float tx_far  = (p_bounds[1 - m_direction_sign[0]]->getX() - m_origin.getX()) * m_inverse_direction.getX();
+    float ty_near = (p_bounds[    m_direction_sign[1]]->getY() - m_origin.getY()) * m_inverse_direction.getY();
+    float ty_far  = (p_bounds[1 - m_direction_sign[1]]->getY() - m_origin.getY()) * m_inverse_direction.getY();
+    float tz_near = (p_bounds[    m_direction_sign[2]]->getZ() - m_origin.getZ()) * m_inverse_direction.getZ();
+    float tz_far  = (p_bounds[1 - m_direction_sign[2]]->getZ() - m_origin.getZ()) * m_inverse_direction.getZ();
+
+    // Clip the slabs' intersection to the ray's interval
+    tNear = std::max(std::max(std::max(tx_near, ty_near), tz_near), m_t_min);
+    tFar  = std::min(std::min(std::min(tx_far,  ty_far),  tz_far),  m_t_max);
+
+    return tNear <= tFar;
+}
+
+
+//---------------------------------------
+inline void Ray::updateInverseDirection()
+//---------------------------------------
+{
+    // A null component gives an infinite inverse, which the slab test handles
+    m_inverse_direction = Vec3(1.0f / m_direction.getX(),
+                               1.0f / m_direction.getY(),
+                               1.0f / m_direction.getZ());
+
+    m_direction_sign[0] = m_inverse_direction.getX() < 0;
+    m_direction_sign[1] = m_inverse_direction.getY() < 0;
+    m_direction_sign[2] = m_inverse_direction.getZ() < 0;
+}
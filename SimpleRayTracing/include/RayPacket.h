@@ -0,0 +1,241 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+#ifndef __RayPacket_h
+#define __RayPacket_h
+
+
+/**
+********************************************************************************
+*
+*   @file       RayPacket.h
+*
+*   @brief      Class to trace a packet of coherent rays together.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <vector>
+
+#ifndef __Ray_h
+#include "Ray.h"
+#endif
+
+#ifndef __TriangleRecord_h
+#include "TriangleRecord.h"
+#endif
+
+
+//==============================================================================
+/**
+*   @class  RayPacket
+*   @brief  RayPacket is a class to trace up to MAX_SIZE coherent rays
+*           together, e.g. the primary rays of a block of 8x8 pixels. The
+*           rays are stored as a structure of arrays, so that a triangle is
+*           tested against all of them with SIMD instructions. A box is
+*           first tested against the frustum of the whole packet, which is
+*           bounded by the ranges of the rays' origins and inverse
+*           directions (see "Geometric and Arithmetic Culling Methods for
+*           Entire Ray Packets" by Boulos et al., 2006). This test is only
+*           conservative if the directions of all the rays have the same
+*           signs: the other packets must be traced ray by ray.
+*/
+//==============================================================================
+class RayPacket
+//------------------------------------------------------------------------------
+{
+//******************************************************************************
+public:
+    /// Maximum number of rays in a packet
+    static const unsigned int MAX_SIZE = 64;
+
+    RayPacket();
+
+    void clear();
+    void addRay(const Ray& aRay);
+
+    unsigned int getSize() const;
+
+    /// The i-th ray, its interval stops at the closest intersection so far
+    Ray getRay(unsigned int i) const;
+
+    float getTMax(unsigned int i) const;
+
+    bool hasHit(unsigned int i) const;
+    float getT(unsigned int i) const;
+    float getU(unsigned int i) const;
+    float getV(unsigned int i) const;
+    unsigned int getPrimitiveId(unsigned int i) const;
+    unsigned int getInstanceId(unsigned int i) const;
+
+    //--------------------------------------------------------------------------
+    /// Record a closer intersection of a ray
+    /*
+    *   @param i            the index of the ray
+    *   @param t            the distance to the intersection
+    *   @param u            the barycentric coordinate of P2
+    *   @param v            the barycentric coordinate of P3
+    *   @param aPrimitiveId the ID of the primitive
+    */
+    //--------------------------------------------------------------------------
+    void setHit(unsigned int i,
+                float t,
+                float u,
+                float v,
+                unsigned int aPrimitiveId);
+
+    void setInstanceId(unsigned int i, unsigned int anInstanceId);
+
+    /// Record that a ray is occluded: its interval is emptied, so that it
+    /// skips the rest of the traversal
+    void setOccluded(unsigned int i);
+
+    /// True if the directions of the rays have the same signs along each axis
+    bool isCoherent() const;
+
+    //--------------------------------------------------------------------------
+    /// Check if the frustum of the packet overlaps a box. It is conservative:
+    /// if false, none of the rays intersects the box
+    /*
+    *   @param aLowerBBoxCorner     the lower corner of the box
+    *   @param anUpperBBoxCorner    the upper corner of the box
+    *   @return false if no ray can intersect the box
+    */
+    //--------------------------------------------------------------------------
+    bool intersectFrustum(const Vec3& aLowerBBoxCorner,
+                          const Vec3& anUpperBBoxCorner) const;
+
+    //--------------------------------------------------------------------------
+    /// Find the first ray that intersects a box within its interval
+    /*
+    *   @param aLowerBBoxCorner     the lower corner of the box
+    *   @param anUpperBBoxCorner    the upper corner of the box
+    *   @param aFirstRay            the index of the first ray to test
+    *   @param tNear                the entry distance of this ray in the box
+    *   @return the index of the ray, the size of the packet if none
+    */
+    //--------------------------------------------------------------------------
+    unsigned int findFirstHit(const Vec3& aLowerBBoxCorner,
+                              const Vec3& anUpperBBoxCorner,
+                              unsigned int aFirstRay,
+                              float& tNear) const;
+
+    //--------------------------------------------------------------------------
+    /// Intersect the rays with a triangle, the closer intersections are
+    /// recorded (see Ray::intersect)
+    /*
+    *   @param aRecord      the vertex and edges of the triangle
+    *   @param aTriangleId  the ID of the triangle
+    *   @param aFirstRay    the index of the first ray to test
+    */
+    //--------------------------------------------------------------------------
+    void intersect(const TriangleRecord& aRecord,
+                   unsigned int aTriangleId,
+                   unsigned int aFirstRay);
+
+    //--------------------------------------------------------------------------
+    /// Check which rays intersect a triangle, e.g. for shadow rays. The rays
+    /// that do are marked as occluded (see setOccluded)
+    /*
+    *   @param aRecord      the vertex and edges of the triangle
+    *   @param aFirstRay    the index of the first ray to test
+    */
+    //--------------------------------------------------------------------------
+    void occlude(const TriangleRecord& aRecord, unsigned int aFirstRay);
+
+
+//******************************************************************************
+protected:
+    /// The rays, to trace them one by one if needed
+    std::vector<Ray> m_ray_set;
+
+    /// The x, y and z coordinates of the origins
+    float m_origin[3][MAX_SIZE];
+
+    /// The x, y and z coordinates of the directions
+    float m_direction[3][MAX_SIZE];
+
+    /// The x, y and z coordinates of the inverse directions
+    float m_inverse_direction[3][MAX_SIZE];
+
+    /// The intervals of the rays, the upper bounds shrink to the closest
+    /// intersections
+    float m_t_min[MAX_SIZE];
+    float m_t_max[MAX_SIZE];
+
+    /// The closest intersections
+    bool m_hit[MAX_SIZE];
+    float m_u[MAX_SIZE];
+    float m_v[MAX_SIZE];
+    unsigned int m_primitive_id[MAX_SIZE];
+    unsigned int m_instance_id[MAX_SIZE];
+
+    /// The signs of the directions, if they are the same for all the rays
+    unsigned int m_direction_sign[3];
+    bool m_coherent;
+
+    /// The frustum: ranges of the origins and of the inverse directions
+    Vec3 m_lower_origin;
+    Vec3 m_upper_origin;
+    Vec3 m_lower_inverse_direction;
+    Vec3 m_upper_inverse_direction;
+    float m_lowest_t_min;
+};
+
+
+#include "RayPacket.inl"
+
+
+#endif // __RayPacket_h
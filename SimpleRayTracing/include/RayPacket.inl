@@ -0,0 +1,200 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       RayPacket.inl
+*
+*   @brief      Class to trace a packet of coherent rays together.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//---------------------------
+inline RayPacket::RayPacket()
+//---------------------------
+{
+    m_ray_set.reserve(MAX_SIZE);
+    clear();
+}
+
+
+//----------------------------
+inline void RayPacket::clear()
+//----------------------------
+{
+    m_ray_set.clear();
+
+    m_coherent = true;
+    m_lowest_t_min = INFINITY;
+}
+
+
+//--------------------------------------------
+inline unsigned int RayPacket::getSize() const
+//--------------------------------------------
+{
+    return m_ray_set.size();
+}
+
+
+//------------------------------------------------
+inline Ray RayPacket::getRay(unsigned int i) const
+//------------------------------------------------
+{
+    Ray ray(m_ray_set[i]);
+    ray.setTMax(m_t_max[i]);
+    return ray;
+}
+
+
+//---------------------------------------------------
+inline float RayPacket::getTMax(unsigned int i) const
+//---------------------------------------------------
+{
+    return m_t_max[i];
+}
+
+
+//-------------------------------------------------
+inline bool RayPacket::hasHit(unsigned int i) const
+//-------------------------------------------------
+{
+    return m_hit[i];
+}
+
+
+//------------------------------------------------
+inline float RayPacket::getT(unsigned int i) const
+//------------------------------------------------
+{
+    return m_t_max[i];
+}
+
+
+//------------------------------------------------
+inline float RayPacket::getU(unsigned int i) const
+//------------------------------------------------
+{
+    return m_u[i];
+}
+
+
+//------------------------------------------------
+inline float RayPacket::getV(unsigned int i) const
+//------------------------------------------------
+{
+    return m_v[i];
+}
+
+
+//-----------------------------------------------------------------
+inline unsigned int RayPacket::getPrimitiveId(unsigned int i) const
+//-----------------------------------------------------------------
+{
+    return m_primitive_id[i];
+}
+
+
+//----------------------------------------------------------------
+inline unsigned int RayPacket::getInstanceId(unsigned int i) const
+//----------------------------------------------------------------
+{
+    return m_instance_id[i];
+}
+
+
+//------------------------------------------------------
+inline void RayPacket::setHit(unsigned int i,
+                              float t,
+                              float u,
+                              float v,
+                              unsigned int aPrimitiveId)
+//------------------------------------------------------
+{
+    m_t_max[i] = t;
+    m_hit[i] = true;
+    m_u[i] = u;
+    m_v[i] = v;
+    m_primitive_id[i] = aPrimitiveId;
+}
+
+
+//-----------------------------------------------------------------------------
+inline void RayPacket::setInstanceId(unsigned int i, unsigned int anInstanceId)
+//-----------------------------------------------------------------------------
+{
+    m_instance_id[i] = anInstanceId;
+}
+
+
+//------------------------------------------------
+inline void RayPacket::setOccluded(unsigned int i)
+//------------------------------------------------
+{
+    m_t_max[i] = -INFINITY;
+    m_hit[i] = true;
+}
+
+
+//---------------------------------------
+inline bool RayPacket::isCoherent() const
+//---------------------------------------
+{
+    return m_coherent;
+}
@@ -0,0 +1,179 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+#ifndef __RayStream_h
+#define __RayStream_h
+
+
+/**
+********************************************************************************
+*
+*   @file       RayStream.h
+*
+*   @brief      Class to trace a large batch of rays as a stream.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <vector>
+
+#ifndef __Ray_h
+#include "Ray.h"
+#endif
+
+
+//==============================================================================
+/**
+*   @class  RayStream
+*   @brief  RayStream is a class to handle a large batch of rays that are
+*           traced together, one stage of a wavefront renderer at a time
+*           (e.g. all the primary rays, then all the shadow rays). Each ray
+*           carries an ID, e.g. its pixel or the index of the ray that
+*           spawned it. The rays are sorted so that consecutive rays are
+*           coherent and visit the same nodes and triangles, which stay in
+*           cache from one ray to the next. The results of the traversal are
+*           written to hit buffers, in the same order as the rays.
+*/
+//==============================================================================
+class RayStream
+//------------------------------------------------------------------------------
+{
+//******************************************************************************
+public:
+    void clear();
+    void reserve(size_t aSize);
+
+    //--------------------------------------------------------------------------
+    /// Add a ray to the stream, it is not hit yet
+    /*
+    *   @param aRay the ray
+    *   @param anId the ID of the ray, e.g. a pixel index
+    */
+    //--------------------------------------------------------------------------
+    void addRay(const Ray& aRay, unsigned int anId);
+
+    size_t getSize() const;
+    const Ray& getRay(unsigned int i) const;
+    unsigned int getId(unsigned int i) const;
+
+    //--------------------------------------------------------------------------
+    /// Sort the rays by octant of their direction, then by the Morton codes
+    /// of their origin and direction. Rays that share their origin, e.g.
+    /// primary rays, are sorted by direction, the others, e.g. shadow rays,
+    /// are mostly sorted by origin. It must be called before the traversal,
+    /// as the hit buffers are not reordered.
+    //--------------------------------------------------------------------------
+    void sort();
+
+    //--------------------------------------------------------------------------
+    /// Sort the rays by octant of their direction, then by the Morton code
+    /// of their direction only, e.g. the shadow rays toward a point light,
+    /// which converge on it whatever their origins. It must be called
+    /// before the traversal, as the hit buffers are not reordered.
+    //--------------------------------------------------------------------------
+    void sortByDirection();
+
+    bool hasHit(unsigned int i) const;
+    float getT(unsigned int i) const;
+    float getU(unsigned int i) const;
+    float getV(unsigned int i) const;
+    unsigned int getInstanceId(unsigned int i) const;
+    unsigned int getTriangleId(unsigned int i) const;
+
+    //--------------------------------------------------------------------------
+    /// Record the intersection of a ray
+    /*
+    *   @param i                the index of the ray in the stream
+    *   @param t                the distance to the intersection
+    *   @param u                the barycentric coordinate of P2
+    *   @param v                the barycentric coordinate of P3
+    *   @param anInstanceId     the ID of the instance that is intersected
+    *   @param aTriangleId      the ID of the triangle that is intersected
+    */
+    //--------------------------------------------------------------------------
+    void setHit(unsigned int i,
+                float t,
+                float u,
+                float v,
+                unsigned int anInstanceId,
+                unsigned int aTriangleId);
+
+    /// Record that a ray is occluded, without its intersection
+    void setOccluded(unsigned int i);
+
+
+//******************************************************************************
+protected:
+    /// Reorder the rays and their IDs, the new i-th ray is the anIndexSet[i]-th one
+    void reorder(const std::vector<unsigned int>& anIndexSet);
+
+    /// The rays and their IDs
+    std::vector<Ray> m_ray_set;
+    std::vector<unsigned int> m_id_set;
+
+    /// The hit buffers
+    std::vector<bool> m_hit_set;
+    std::vector<float> m_t_set;
+    std::vector<float> m_u_set;
+    std::vector<float> m_v_set;
+    std::vector<unsigned int> m_instance_id_set;
+    std::vector<unsigned int> m_triangle_id_set;
+};
+
+
+#include "RayStream.inl"
+
+
+#endif // __RayStream_h
@@ -0,0 +1,211 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       RayStream.inl
+*
+*   @brief      Class to trace a large batch of rays as a stream.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//----------------------------
+inline void RayStream::clear()
+//----------------------------
+{
+    m_ray_set.clear();
+    m_id_set.clear();
+
+    m_hit_set.clear();
+    m_t_set.clear();
+    m_u_set.clear();
+    m_v_set.clear();
+    m_instance_id_set.clear();
+    m_triangle_id_set.clear();
+}
+
+
+//------------------------------------------
+inline void RayStream::reserve(size_t aSize)
+//------------------------------------------
+{
+    m_ray_set.reserve(aSize);
+    m_id_set.reserve(aSize);
+
+    m_hit_set.reserve(aSize);
+    m_t_set.reserve(aSize);
+    m_u_set.reserve(aSize);
+    m_v_set.reserve(aSize);
+    m_instance_id_set.reserve(aSize);
+    m_triangle_id_set.reserve(aSize);
+}
+
+
+//---------------------------------------------------------------
+inline void RayStream::addRay(const Ray& aRay, unsigned int anId)
+//---------------------------------------------------------------
+{
+    m_ray_set.push_back(aRay);
+    m_id_set.push_back(anId);
+
+    m_hit_set.push_back(false);
+    m_t_set.push_back(aRay.getTMax());
+    m_u_set.push_back(0.0);
+    m_v_set.push_back(0.0);
+    m_instance_id_set.push_back(0);
+    m_triangle_id_set.push_back(0);
+}
+
+
+//--------------------------------------
+inline size_t RayStream::getSize() const
+//--------------------------------------
+{
+    return m_ray_set.size();
+}
+
+
+//-------------------------------------------------------
+inline const Ray& RayStream::getRay(unsigned int i) const
+//-------------------------------------------------------
+{
+    return m_ray_set[i];
+}
+
+
+//--------------------------------------------------------
+inline unsigned int RayStream::getId(unsigned int i) const
+//--------------------------------------------------------
+{
+    return m_id_set[i];
+}
+
+
+//-------------------------------------------------
+inline bool RayStream::hasHit(unsigned int i) const
+//-------------------------------------------------
+{
+    return m_hit_set[i];
+}
+
+
+//------------------------------------------------
+inline float RayStream::getT(unsigned int i) const
+//------------------------------------------------
+{
+    return m_t_set[i];
+}
+
+
+//------------------------------------------------
+inline float RayStream::getU(unsigned int i) const
+//------------------------------------------------
+{
+    return m_u_set[i];
+}
+
+
+//------------------------------------------------
+inline float RayStream::getV(unsigned int i) const
+//------------------------------------------------
+{
+    return m_v_set[i];
+}
+
+
+//----------------------------------------------------------------
+inline unsigned int RayStream::getInstanceId(unsigned int i) const
+//----------------------------------------------------------------
+{
+    return m_instance_id_set[i];
+}
+
+
+//----------------------------------------------------------------
+inline unsigned int RayStream::getTriangleId(unsigned int i) const
+//----------------------------------------------------------------
+{
+    return m_triangle_id_set[i];
+}
+
+
+//------------------------------------------------------
+inline void RayStream::setHit(unsigned int i,
+                              float t,
+                              float u,
+                              float v,
+                              unsigned int anInstanceId,
+                              unsigned int aTriangleId)
+//------------------------------------------------------
+{
+    m_hit_set[i] = true;
+    m_t_set[i] = t;
+    m_u_set[i] = u;
+    m_v_set[i] = v;
+    m_instance_id_set[i] = anInstanceId;
+    m_triangle_id_set[i] = aTriangleId;
+}
+
+
+//------------------------------------------------
+inline void RayStream::setOccluded(unsigned int i)
+//------------------------------------------------
+{
+    m_hit_set[i] = true;
+}
@@ -0,0 +1,294 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+#ifndef __Scene_h
+#define __Scene_h
+
+
+/**
+********************************************************************************
+*
+*   @file       Scene.h
+*
+*   @brief      Class to manipulate a scene made of instanced triangle meshes.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <vector>
+
+#ifndef __TriangleMesh_h
+#include "TriangleMesh.h"
+#endif
+
+#ifndef __Instance_h
+#include "Instance.h"
+#endif
+
+#ifndef __BVH_h
+#include "BVH.h"
+#endif
+
+#ifndef __RayStream_h
+#include "RayStream.h"
+#endif
+
+#ifndef __Hit_h
+#include "Hit.h"
+#endif
+
+#ifndef __OccluderCache_h
+#include "OccluderCache.h"
+#endif
+
+
+//==============================================================================
+/**
+*   @class  Scene
+*   @brief  Scene is a class to handle a two-level acceleration structure.
+*           The meshes are stored once, each with its own BVH (bottom level).
+*           The instances reference the meshes, and a BVH is built over the
+*           instances' bounding boxes in world space (top level).
+*/
+//==============================================================================
+class Scene
+//------------------------------------------------------------------------------
+{
+//******************************************************************************
+public:
+    Scene();
+
+    unsigned int addMesh(const TriangleMesh& aMesh);
+    unsigned int addInstance(unsigned int aMeshId,
+                             const Transform& aTransform = Transform());
+
+    //--------------------------------------------------------------------------
+    /// Update the bounding boxes of the instances and build the top-level BVH.
+    /// It must be called after the meshes or the instances are modified.
+    //--------------------------------------------------------------------------
+    void build();
+
+    size_t getNumberOfMeshes() const;
+    TriangleMesh& getMesh(unsigned int i);
+    const TriangleMesh& getMesh(unsigned int i) const;
+
+    size_t getNumberOfInstances() const;
+    const Instance& getInstance(unsigned int i) const;
+    const TriangleMesh& getInstanceMesh(unsigned int i) const;
+
+    const Vec3& getInstanceLowerBBoxCorner(unsigned int i) const;
+    const Vec3& getInstanceUpperBBoxCorner(unsigned int i) const;
+
+    //--------------------------------------------------------------------------
+    /// Find the closest intersection between a ray and the scene
+    /*
+    *   @param aRay             the ray in world space
+    *   @param t                the distance to the intersection in world space
+    *   @param anInstanceId     the ID of the instance that is intersected
+    *   @param aTriangleId      the ID of the triangle that is intersected
+    *                           in the instance's mesh
+    *   @return true if an intersection was found within the ray's interval
+    */
+    //--------------------------------------------------------------------------
+    bool intersect(const Ray& aRay,
+                   float& t,
+                   unsigned int& anInstanceId,
+                   unsigned int& aTriangleId) const;
+
+    //--------------------------------------------------------------------------
+    /// Find the closest intersection between a ray and the scene, and keep
+    /// its barycentric coordinates
+    /*
+    *   @param aRay             the ray in world space
+    *   @param t                the distance to the intersection in world space
+    *   @param u                the barycentric coordinate of P2
+    *   @param v                the barycentric coordinate of P3
+    *   @param anInstanceId     the ID of the instance that is intersected
+    *   @param aTriangleId      the ID of the triangle that is intersected
+    *                           in the instance's mesh
+    *   @return true if an intersection was found within the ray's interval
+    */
+    //--------------------------------------------------------------------------
+    bool intersect(const Ray& aRay,
+                   float& t,
+                   float& u,
+                   float& v,
+                   unsigned int& anInstanceId,
+                   unsigned int& aTriangleId) const;
+
+    //--------------------------------------------------------------------------
+    /// Find the closest intersection between a ray and the scene, with its
+    /// barycentric coordinates to interpolate the attributes of the vertices
+    /*
+    *   @param aRay the ray in world space
+    *   @param aHit the closest intersection (unchanged if none)
+    *   @return true if an intersection was found within the ray's interval
+    */
+    //--------------------------------------------------------------------------
+    bool intersect(const Ray& aRay, Hit& aHit) const;
+
+    //--------------------------------------------------------------------------
+    /// Find the closest intersections between a packet of rays and the scene,
+    /// e.g. the primary rays of a block of pixels. The packet traverses the
+    /// BVHs if it is coherent, otherwise the rays are traced one by one
+    /*
+    *   @param aPacket  the rays in world space, the distances, barycentric
+    *                   coordinates, instance IDs and triangle IDs of their
+    *                   closest intersections are recorded in it
+    */
+    //--------------------------------------------------------------------------
+    void intersect(RayPacket& aPacket) const;
+
+    //--------------------------------------------------------------------------
+    /// Find the closest intersections between a sorted stream of rays and
+    /// the scene. The consecutive rays are traced in packets, which fall
+    /// back to single rays where the stream is not coherent
+    /*
+    *   @param aStream  the rays in world space, their closest intersections
+    *                   are written to its hit buffers
+    */
+    //--------------------------------------------------------------------------
+    void intersect(RayStream& aStream) const;
+
+    //--------------------------------------------------------------------------
+    /// Check if anything in the scene intersects a ray, e.g. for shadow rays.
+    /// The query stops at the first intersection found, which is not
+    /// necessarily the closest one
+    /*
+    *   @param aRay the ray, its interval excludes the intersections beyond
+    *               the light
+    *   @return true if an intersection was found within the ray's interval
+    */
+    //--------------------------------------------------------------------------
+    bool occluded(const Ray& aRay) const;
+
+    //--------------------------------------------------------------------------
+    /// Same as occluded(const Ray&), the triangle found is recorded
+    /*
+    *   @param aRay         the ray
+    *   @param anInstanceId the ID of the instance that occludes the ray
+    *   @param aTriangleId  the ID of the triangle in the instance's mesh
+    *   @return true if an intersection was found within the ray's interval
+    */
+    //--------------------------------------------------------------------------
+    bool occluded(const Ray& aRay,
+                  unsigned int& anInstanceId,
+                  unsigned int& aTriangleId) const;
+
+    //--------------------------------------------------------------------------
+    /// Check if anything in the scene intersects a ray, the last occluder
+    /// found is tested first, before any traversal
+    /*
+    *   @param aRay     the ray
+    *   @param aCache   the last occluder of the calling thread, it is
+    *                   updated, and so are its counters
+    *   @return true if an intersection was found within the ray's interval
+    */
+    //--------------------------------------------------------------------------
+    bool occluded(const Ray& aRay, OccluderCache& aCache) const;
+
+    //--------------------------------------------------------------------------
+    /// Check which rays of a packet are occluded, e.g. the shadow rays of a
+    /// block of pixels toward the same light. The packet traverses the BVHs
+    /// if it is coherent, otherwise the rays are traced one by one
+    /*
+    *   @param aPacket  the rays in world space, the occluded ones are
+    *                   marked as hit in it
+    */
+    //--------------------------------------------------------------------------
+    void occluded(RayPacket& aPacket) const;
+
+    //--------------------------------------------------------------------------
+    /// Check which rays of a sorted stream are occluded, e.g. shadow rays.
+    /// The consecutive rays are traced in packets
+    /*
+    *   @param aStream  the rays in world space, the occluded ones are
+    *                   marked as hit in its hit buffers
+    */
+    //--------------------------------------------------------------------------
+    void occluded(RayStream& aStream) const;
+
+    const BVH& getBVH() const;
+
+//******************************************************************************
+protected:
+    void computeInstanceBBox(unsigned int i);
+
+    /// True if a ray intersects a given triangle within its interval
+    bool intersectTriangle(const Ray& aRay,
+                           unsigned int anInstanceId,
+                           unsigned int aTriangleId) const;
+
+    /// The shared meshes
+    std::vector<TriangleMesh> m_mesh_set;
+
+    /// The instances of the meshes
+    std::vector<Instance> m_instance_set;
+
+    /// The lower corners of the instances' bbox in world space
+    std::vector<Vec3> m_instance_lower_bbox_corner_set;
+
+    /// The upper corners of the instances' bbox in world space
+    std::vector<Vec3> m_instance_upper_bbox_corner_set;
+
+    /// The top-level BVH
+    BVH m_bvh;
+};
+
+
+#include "Scene.inl"
+
+
+#endif // __Scene_h
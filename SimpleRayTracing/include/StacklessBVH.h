@@ -0,0 +1,199 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+#ifndef __StacklessBVH_h
+#define __StacklessBVH_h
+
+
+/**
+********************************************************************************
+*
+*   @file       StacklessBVH.h
+*
+*   @brief      Class to traverse a BVH without stack using skip pointers.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <vector>
+
+#ifndef __Ray_h
+#include "Ray.h"
+#endif
+
+#ifndef __BVH_h
+#include "BVH.h"
+#endif
+
+
+//==============================================================================
+/**
+*   @struct StacklessBVHNode
+*   @brief  StacklessBVHNode is a node of a BVH stored in depth-first order.
+*           It has the same size as BVHNode. The first child of an internal
+*           node is stored right after it, and the skip pointer gives the
+*           node that follows its subtree.
+*/
+//==============================================================================
+struct StacklessBVHNode
+//------------------------------------------------------------------------------
+{
+    bool isLeaf() const;
+
+    /// The lower corner of the node's bounding box
+    Vec3 m_lower_bbox_corner;
+
+    /// The upper corner of the node's bounding box
+    Vec3 m_upper_bbox_corner;
+
+    /// Index of the node that follows the subtree (skip pointer) if the node
+    /// is internal, index of the first primitive otherwise (the node that
+    /// follows a leaf is the next one)
+    unsigned int m_index;
+
+    /// Number of primitives in the leaf, 0 if the node is internal
+    unsigned int m_primitive_count;
+};
+
+
+//==============================================================================
+/**
+*   @class  StacklessBVH
+*   @brief  StacklessBVH is a class to traverse a binary BVH without stack.
+*           The nodes are threaded in depth-first order: when the ray hits a
+*           node, the traversal goes on with the next node, otherwise it
+*           jumps to the node given by the skip pointer. The whole traversal
+*           state is a single index, but the children cannot be visited in
+*           the order of the ray, only the shrinking interval culls the
+*           subtrees.
+*/
+//==============================================================================
+class StacklessBVH
+//------------------------------------------------------------------------------
+{
+//******************************************************************************
+public:
+    StacklessBVH();
+
+    //--------------------------------------------------------------------------
+    /// Build the hierarchy by threading the nodes of a binary BVH
+    /*
+    *   @param aBVH the binary BVH
+    */
+    //--------------------------------------------------------------------------
+    void build(const BVH& aBVH);
+
+    void clear();
+
+    bool isEmpty() const;
+
+    size_t getNumberOfNodes() const;
+    const StacklessBVHNode& getNode(unsigned int i) const;
+
+    size_t getNumberOfPrimitiveIndices() const;
+    unsigned int getPrimitiveIndex(unsigned int i) const;
+
+    //--------------------------------------------------------------------------
+    /// Find the closest intersection between a ray and the primitives
+    /*
+    *   @param aRay             the ray
+    *   @param anIntersector    functor with the signature
+    *                           bool (const Ray&, unsigned int aPrimitiveId, float& t),
+    *                           see BVH::intersect
+    *   @param t                the distance to the closest intersection (if any)
+    *   @param aPrimitiveId     the ID of the closest primitive (if any)
+    *   @return true if an intersection was found within the ray's interval
+    */
+    //-------------------------------------------------------
+    template<typename PrimitiveIntersector>
+    bool intersect(const Ray& aRay,
+                   const PrimitiveIntersector& anIntersector,
+                   float& t,
+                   unsigned int& aPrimitiveId) const;
+
+    //-------------------------------------------------------
+    /// Check if any primitive intersects a ray (any-hit query)
+    /*
+    *   @param aRay             the ray
+    *   @param anOccluder       functor with the signature
+    *                           bool (const Ray&, unsigned int aPrimitiveId),
+    *                           see BVH::occluded
+    *   @return true if an intersection was found within the ray's interval
+    */
+    //--------------------------------------------------------------------------
+    template<typename PrimitiveOccluder>
+    bool occluded(const Ray& aRay,
+                  const PrimitiveOccluder& anOccluder) const;
+
+
+//******************************************************************************
+protected:
+    static bool intersectBBox(const StacklessBVHNode& aNode,
+                              const Ray& aRay);
+
+    void thread(const BVH& aBVH, unsigned int aBinaryNodeId);
+
+    /// The nodes in depth-first order, the root is the first one
+    std::vector<StacklessBVHNode> m_node_set;
+
+    /// The primitive indices referenced by the leaves
+    std::vector<unsigned int> m_primitive_index_set;
+};
+
+
+#include "StacklessBVH.inl"
+
+
+#endif // __StacklessBVH_h
@@ -0,0 +1,241 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       StacklessBVH.inl
+*
+*   @brief      Class to traverse a BVH without stack using skip pointers.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//------------------------------------------
+inline bool StacklessBVHNode::isLeaf() const
+//------------------------------------------
+{
+    return m_primitive_count > 0;
+}
+
+
+//---------------------------------
+inline StacklessBVH::StacklessBVH()
+//---------------------------------
+{
+    // Do nothing
+}
+
+
+//-------------------------------
+inline void StacklessBVH::clear()
+//-------------------------------
+{
+    m_node_set.clear();
+    m_primitive_index_set.clear();
+}
+
+
+//---------------------------------------
+inline bool StacklessBVH::isEmpty() const
+//---------------------------------------
+{
+    return m_node_set.empty();
+}
+
+
+//--------------------------------------------------
+inline size_t StacklessBVH::getNumberOfNodes() const
+//--------------------------------------------------
+{
+    return m_node_set.size();
+}
+
+
+//------------------------------------------------------------------------
+inline const StacklessBVHNode& StacklessBVH::getNode(unsigned int i) const
+//------------------------------------------------------------------------
+{
+    return m_node_set[i];
+}
+
+
+//-------------------------------------------------------------
+inline size_t StacklessBVH::getNumberOfPrimitiveIndices() const
+//-------------------------------------------------------------
+{
+    return m_primitive_index_set.size();
+}
+
+
+//-----------------------------------------------------------------------
+inline unsigned int StacklessBVH::getPrimitiveIndex(unsigned int i) const
+//-----------------------------------------------------------------------
+{
+    return m_primitive_index_set[i];
+}
+
+
+//--------------------------------------------------------------------
+inline bool StacklessBVH::intersectBBox(const StacklessBVHNode& aNode,
+                                        const Ray& aRay)
+//--------------------------------------------------------------------
+{
+    float t_near;
+    float t_far;
+
+    return aRay.intersect(aNode.m_lower_bbox_corner, aNode.m_upper_bbox_corner, t_near, t_far);
+}
+
+
+//---------------------------------------------------------------------
+template<typename PrimitiveIntersector>
+bool StacklessBVH::intersect(const Ray& aRay,
+                             const PrimitiveIntersector& anIntersector,
+                             float& t,
+                             unsigned int& aPrimitiveId) const
+//---------------------------------------------------------------------
+{
+    // The interval of the ray shrinks as closer intersections are found
+    Ray ray(aRay);
+    bool has_hit = false;
+
+    // The traversal ends when the root is skipped or its last leaf is done
+    unsigned int node_id = 0;
+    unsigned int node_count = m_node_set.size();
+
+    while (node_id < node_count)
+    {
+        const StacklessBVHNode& node = m_node_set[node_id];
+
+        // Skip the whole subtree
+        if (!intersectBBox(node, ray))
+        {
+            node_id = node.isLeaf() ? node_id + 1 : node.m_index;
+        }
+        // Test the primitives of the leaf
+        else if (node.isLeaf())
+        {
+            for (unsigned int i = node.m_index; i < node.m_index + node.m_primitive_count; ++i)
+            {
+                unsigned int primitive_id = m_primitive_index_set[i];
+
+                float primitive_t;
+                if (anIntersector(ray, primitive_id, primitive_t))
+                {
+                    ray.setTMax(primitive_t);
+                    aPrimitiveId = primitive_id;
+                    has_hit = true;
+                }
+            }
+
+            ++node_id;
+        }
+        // Go down into the first child
+        else
+        {
+            ++node_id;
+        }
+    }
+
+    if (has_hit)
+    {
+        t = ray.getTMax();
+    }
+
+    return has_hit;
+}
+
+
+//--------------------------------------------------------------------
+template<typename PrimitiveOccluder>
+bool StacklessBVH::occluded(const Ray& aRay,
+                            const PrimitiveOccluder& anOccluder) const
+//--------------------------------------------------------------------
+{
+    unsigned int node_id = 0;
+    unsigned int node_count = m_node_set.size();
+
+    while (node_id < node_count)
+    {
+        const StacklessBVHNode& node = m_node_set[node_id];
+
+        if (!intersectBBox(node, aRay))
+        {
+            node_id = node.isLeaf() ? node_id + 1 : node.m_index;
+        }
+        else if (node.isLeaf())
+        {
+            for (unsigned int i = node.m_index; i < node.m_index + node.m_primitive_count; ++i)
+            {
+                // Any intersection will do
+                if (anOccluder(aRay, m_primitive_index_set[i]))
+                {
+                    return true;
+                }
+            }
+
+            ++node_id;
+        }
+        else
+        {
+            ++node_id;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,127 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+#ifndef __Transform_h
+#define __Transform_h
+
+
+/**
+********************************************************************************
+*
+*   @file       Transform.h
+*
+*   @brief      Class to manipulate an affine transformation.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#ifndef __Vec3_h
+#include "Vec3.h"
+#endif
+
+
+//==============================================================================
+/**
+*   @class  Transform
+*   @brief  Transform is a class to handle an affine transformation stored as
+*           a 3x4 row-major matrix (the last row is always 0 0 0 1).
+*           As with OpenGL, translate(), rotate() and scale() multiply the
+*           current matrix on the right, i.e. the last call is applied first.
+*/
+//==============================================================================
+class Transform
+//------------------------------------------------------------------------------
+{
+//******************************************************************************
+public:
+    Transform();
+
+    void setIdentity();
+    bool isIdentity() const;
+
+    void translate(const Vec3& aTranslationVector);
+    void rotate(float anAngleInDegrees, const Vec3& anAxis);
+    void scale(const Vec3& aScalingFactorSet);
+
+    Transform operator*(const Transform& aTransform) const;
+    Transform& operator*=(const Transform& aTransform);
+
+    float& operator()(unsigned int aRow, unsigned int aColumn);
+    float operator()(unsigned int aRow, unsigned int aColumn) const;
+
+    Transform getInverse() const;
+
+    //--------------------------------------------------------------------------
+    /// Transformation to apply to normal vectors, i.e. the transpose of the
+    /// inverse of the linear part of the matrix (no translation)
+    /*
+    *   @return the normal transformation
+    */
+    //--------------------------------------------------------------------------
+    Transform getNormalTransform() const;
+
+    Vec3 transformPoint(const Vec3& aPoint) const;
+    Vec3 transformVector(const Vec3& aVector) const;
+
+//******************************************************************************
+private:
+    float m_matrix[12];
+};
+
+
+#include "Transform.inl"
+
+
+#endif // __Transform_h
@@ -0,0 +1,288 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       Transform.inl
+*
+*   @brief      Class to manipulate an affine transformation.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <cmath>     // for cos/sin
+#include <stdexcept> // for exceptions
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//---------------------------
+inline Transform::Transform()
+//---------------------------
+{
+    setIdentity();
+}
+
+
+//----------------------------------
+inline void Transform::setIdentity()
+//----------------------------------
+{
+    for (unsigned int i = 0; i < 12; ++i)
+    {
+        m_matrix[i] = 0.0;
+    }
+
+    m_matrix[0] = m_matrix[5] = m_matrix[10] = 1.0;
+}
+
+
+//---------------------------------------
+inline bool Transform::isIdentity() const
+//---------------------------------------
+{
+    return m_matrix[0] == 1.0 && m_matrix[1]  == 0.0 && m_matrix[2]  == 0.0 && m_matrix[3]  == 0.0 &&
+            m_matrix[4] == 0.0 && m_matrix[5]  == 1.0 && m_matrix[6]  == 0.0 && m_matrix[7]  == 0.0 &&
+            m_matrix[8] == 0.0 && m_matrix[9]  == 0.0 && m_matrix[10] == 1.0 && m_matrix[11] == 0.0;
+}
+
+
+//--------------------------------------------------------------
+inline void Transform::translate(const Vec3& aTranslationVector)
+//--------------------------------------------------------------
+{
+    Transform translation;
+    translation.m_matrix[3]  = aTranslationVector.getX();
+    translation.m_matrix[7]  = aTranslationVector.getY();
+    translation.m_matrix[11] = aTranslationVector.getZ();
+
+    *this *= translation;
+}
+
+
+//-----------------------------------------------------------------------
+inline void Transform::rotate(float anAngleInDegrees, const Vec3& anAxis)
+//-----------------------------------------------------------------------
+{
+    // See the documentation of glRotate
+    Vec3 axis(normalise(anAxis));
+    float x = axis.getX();
+    float y = axis.getY();
+    float z = axis.getZ();
+
+    float angle = anAngleInDegrees * M_PI / 180.0;
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+
+    Transform rotation;
+    rotation.m_matrix[0]  = x * x * (1 - c) + c;
+    rotation.m_matrix[1]  = x * y * (1 - c) - z * s;
+    rotation.m_matrix[2]  = x * z * (1 - c) + y * s;
+
+    rotation.m_matrix[4]  = y * x * (1 - c) + z * s;
+    rotation.m_matrix[5]  = y * y * (1 - c) + c;
+    rotation.m_matrix[6]  = y * z * (1 - c) - x * s;
+
+    rotation.m_matrix[8]  = x * z * (1 - c) - y * s;
+    rotation.m_matrix[9]  = y * z * (1 - c) + x * s;
+    rotation.m_matrix[10] = z * z * (1 - c) + c;
+
+    *this *= rotation;
+}
+
+
+//---------------------------------------------------------
+inline void Transform::scale(const Vec3& aScalingFactorSet)
+//---------------------------------------------------------
+{
+    Transform scaling;
+    scaling.m_matrix[0]  = aScalingFactorSet.getX();
+    scaling.m_matrix[5]  = aScalingFactorSet.getY();
+    scaling.m_matrix[10] = aScalingFactorSet.getZ();
+
+    *this *= scaling;
+}
+
+
+//----------------------------------------------------------------------
+inline Transform Transform::operator*(const Transform& aTransform) const
+//----------------------------------------------------------------------
+{
+    Transform product;
+
+    for (unsigned int row = 0; row < 3; ++row)
+    {
+        for (unsigned int col = 0; col < 4; ++col)
+        {
+            product.m_matrix[row * 4 + col] =
+                    m_matrix[row * 4 + 0] * aTransform.m_matrix[0 * 4 + col] +
+                    m_matrix[row * 4 + 1] * aTransform.m_matrix[1 * 4 + col] +
+                    m_matrix[row * 4 + 2] * aTransform.m_matrix[2 * 4 + col];
+        }
+
+        // The implicit last row of aTransform is 0 0 0 1
+        product.m_matrix[row * 4 + 3] += m_matrix[row * 4 + 3];
+    }
+
+    return product;
+}
+
+
+//------------------------------------------------------------------
+inline Transform& Transform::operator*=(const Transform& aTransform)
+//------------------------------------------------------------------
+{
+    *this = *this * aTransform;
+    return *this;
+}
+
+
+//--------------------------------------------------------------------------
+inline float& Transform::operator()(unsigned int aRow, unsigned int aColumn)
+//--------------------------------------------------------------------------
+{
+    return m_matrix[aRow * 4 + aColumn];
+}
+
+
+//-------------------------------------------------------------------------------
+inline float Transform::operator()(unsigned int aRow, unsigned int aColumn) const
+//-------------------------------------------------------------------------------
+{
+    return m_matrix[aRow * 4 + aColumn];
+}
+
+
+//--------------------------------------------
+inline Transform Transform::getInverse() const
+//--------------------------------------------
+{
+    const float* m = m_matrix;
+
+    // Inverse of the linear part using the adjugate matrix
+    float a00 = m[5] * m[10] - m[6] * m[9];
+    float a01 = m[2] * m[9]  - m[1] * m[10];
+    float a02 = m[1] * m[6]  - m[2] * m[5];
+    float a10 = m[6] * m[8]  - m[4] * m[10];
+    float a11 = m[0] * m[10] - m[2] * m[8];
+    float a12 = m[2] * m[4]  - m[0] * m[6];
+    float a20 = m[4] * m[9]  - m[5] * m[8];
+    float a21 = m[1] * m[8]  - m[0] * m[9];
+    float a22 = m[0] * m[5]  - m[1] * m[4];
+
+    float determinant = m[0] * a00 + m[1] * a10 + m[2] * a20;
+    if (std::fpclassify(determinant) == FP_ZERO)
+    {
+        throw std::domain_error("The transformation is not invertible");
+    }
+
+    float inverse_determinant = 1.0 / determinant;
+
+    Transform inverse;
+    float* inv = inverse.m_matrix;
+    inv[0] = a00 * inverse_determinant; inv[1] = a01 * inverse_determinant; inv[2]  = a02 * inverse_determinant;
+    inv[4] = a10 * inverse_determinant; inv[5] = a11 * inverse_determinant; inv[6]  = a12 * inverse_determinant;
+    inv[8] = a20 * inverse_determinant; inv[9] = a21 * inverse_determinant; inv[10] = a22 * inverse_determinant;
+
+    // The inverse translation is -inv(L) * t
+    inv[3]  = -(inv[0] * m[3] + inv[1] * m[7] + inv[2]  * m[11]);
+    inv[7]  = -(inv[4] * m[3] + inv[5] * m[7] + inv[6]  * m[11]);
+    inv[11] = -(inv[8] * m[3] + inv[9] * m[7] + inv[10] * m[11]);
+
+    return inverse;
+}
+
+
+//----------------------------------------------------
+inline Transform Transform::getNormalTransform() const
+//----------------------------------------------------
+{
+    Transform inverse = getInverse();
+    Transform normal_transform;
+
+    for (unsigned int row = 0; row < 3; ++row)
+    {
+        for (unsigned int col = 0; col < 3; ++col)
+        {
+            normal_transform.m_matrix[row * 4 + col] = inverse.m_matrix[col * 4 + row];
+        }
+    }
+
+    return normal_transform;
+}
+
+
+//-------------------------------------------------------------
+inline Vec3 Transform::transformPoint(const Vec3& aPoint) const
+//-------------------------------------------------------------
+{
+    return Vec3(m_matrix[0] * aPoint.getX() + m_matrix[1] * aPoint.getY() + m_matrix[2]  * aPoint.getZ() + m_matrix[3],
+                m_matrix[4] * aPoint.getX() + m_matrix[5] * aPoint.getY() + m_matrix[6]  * aPoint.getZ() + m_matrix[7],
+                m_matrix[8] * aPoint.getX() + m_matrix[9] * aPoint.getY() + m_matrix[10] * aPoint.getZ() + m_matrix[11]);
+}
+
+
+//---------------------------------------------------------------
+inline Vec3 Transform::transformVector(const Vec3& aVector) const
+//---------------------------------------------------------------
+{
+    return Vec3(m_matrix[0] * aVector.getX() + m_matrix[1] * aVector.getY() + m_matrix[2]  * aVector.getZ(),
+                m_matrix[4] * aVector.getX() + m_matrix[5] * aVector.getY() + m_matrix[6]  * aVector.getZ(),
+                m_matrix[8] * aVector.getX() + m_matrix[9] * aVector.getY() + m_matrix[10] * aVector.getZ());
+}
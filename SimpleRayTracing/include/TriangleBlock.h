@@ -0,0 +1,174 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+#ifndef __TriangleBlock_h
+#define __TriangleBlock_h
+
+
+/**
+********************************************************************************
+*
+*   @file       TriangleBlock.h
+*
+*   @brief      Class to test a ray against several triangles at once with SIMD instructions.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#ifndef __Ray_h
+#include "Ray.h"
+#endif
+
+#ifndef __TriangleRecord_h
+#include "TriangleRecord.h"
+#endif
+
+
+//******************************************************************************
+//  Constant global variables
+//******************************************************************************
+
+/// Number of triangles per block in the meshes, one per SIMD lane
+#if defined(__AVX512F__)
+const unsigned int TRIANGLE_BLOCK_SIZE = 16;
+#elif defined(__AVX__)
+const unsigned int TRIANGLE_BLOCK_SIZE = 8;
+#else
+const unsigned int TRIANGLE_BLOCK_SIZE = 4;
+#endif
+
+
+//==============================================================================
+/**
+*   @struct TriangleBlock
+*   @brief  TriangleBlock stores the vertex and edges of N triangles as a
+*           structure of arrays (SoA), so that a ray is tested against the
+*           N triangles at once with the Möller–Trumbore algorithm: SSE for
+*           4 triangles, AVX for 8, AVX-512 for 16. The unused slots have
+*           null edges, which are never hit.
+*/
+//==============================================================================
+template<unsigned int N>
+struct TriangleBlock
+//------------------------------------------------------------------------------
+{
+    void setTriangle(unsigned int i,
+                     const TriangleRecord& aRecord,
+                     unsigned int aTriangleId);
+
+    void clearTriangle(unsigned int i);
+
+    //--------------------------------------------------------------------------
+    /// Find the closest intersection between a ray and the triangles
+    /*
+    *   @param aRay         the ray
+    *   @param t            the distance to the intersection (unchanged if none)
+    *   @param aTriangleId  the ID of the closest triangle (unchanged if none)
+    *   @return true if a triangle is hit strictly between tMin and tMax
+    */
+    //--------------------------------------------------------------------------
+    bool intersect(const Ray& aRay, float& t, unsigned int& aTriangleId) const;
+
+    //--------------------------------------------------------------------------
+    /// Find the closest intersection between a ray and the triangles, and
+    /// keep its barycentric coordinates
+    /*
+    *   @param aRay         the ray
+    *   @param t            the distance to the intersection (unchanged if none)
+    *   @param u            the barycentric coordinate of P2 (unchanged if none)
+    *   @param v            the barycentric coordinate of P3 (unchanged if none)
+    *   @param aTriangleId  the ID of the closest triangle (unchanged if none)
+    *   @return true if a triangle is hit strictly between tMin and tMax
+    */
+    //--------------------------------------------------------------------------
+    bool intersect(const Ray& aRay,
+                   float& t,
+                   float& u,
+                   float& v,
+                   unsigned int& aTriangleId) const;
+
+    //--------------------------------------------------------------------------
+    /// Test a ray against all the triangles
+    /*
+    *   @param aRay         the ray
+    *   @param aT           the distance to the intersection with each triangle
+    *   @param aU           the barycentric coordinate of P2 for each triangle
+    *   @param aV           the barycentric coordinate of P3 for each triangle
+    *   @return a bit mask of the triangles hit within the ray's interval
+    */
+    //--------------------------------------------------------------------------
+    unsigned int intersectTriangles(const Ray& aRay,
+                                    float aT[N],
+                                    float aU[N],
+                                    float aV[N]) const;
+
+    /// The x, y and z coordinates of the first vertex of each triangle
+    float m_p1[3][N];
+
+    /// The x, y and z coordinates of P2 - P1
+    float m_edge1[3][N];
+
+    /// The x, y and z coordinates of P3 - P1
+    float m_edge2[3][N];
+
+    /// The IDs of the triangles in the mesh
+    unsigned int m_triangle_id[N];
+};
+
+
+#include "TriangleBlock.inl"
+
+
+#endif // __TriangleBlock_h
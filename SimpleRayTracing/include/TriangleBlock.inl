@@ -0,0 +1,374 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       TriangleBlock.inl
+*
+*   @brief      Class to test a ray against several triangles at once with SIMD instructions.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#if defined(__SSE2__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//---------------------------------------------------------------
+template<unsigned int N>
+void TriangleBlock<N>::setTriangle(unsigned int i,
+                                   const TriangleRecord& aRecord,
+                                   unsigned int aTriangleId)
+//---------------------------------------------------------------
+{
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        m_p1[axis][i] = aRecord.m_p1[axis];
+        m_edge1[axis][i] = aRecord.m_edge1[axis];
+        m_edge2[axis][i] = aRecord.m_edge2[axis];
+    }
+
+    m_triangle_id[i] = aTriangleId;
+}
+
+
+//--------------------------------------------------
+template<unsigned int N>
+void TriangleBlock<N>::clearTriangle(unsigned int i)
+//--------------------------------------------------
+{
+    // The determinant of a triangle without edges is null, it is never hit
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        m_p1[axis][i] = 0.0;
+        m_edge1[axis][i] = 0.0;
+        m_edge2[axis][i] = 0.0;
+    }
+
+    m_triangle_id[i] = 0;
+}
+
+
+//---------------------------------------------------------------
+template<unsigned int N>
+bool TriangleBlock<N>::intersect(const Ray& aRay,
+                                 float& t,
+                                 unsigned int& aTriangleId) const
+//---------------------------------------------------------------
+{
+    // The barycentric coordinates are dropped
+    float u;
+    float v;
+    return intersect(aRay, t, u, v, aTriangleId);
+}
+
+
+//---------------------------------------------------------------
+template<unsigned int N>
+bool TriangleBlock<N>::intersect(const Ray& aRay,
+                                 float& t,
+                                 float& u,
+                                 float& v,
+                                 unsigned int& aTriangleId) const
+//---------------------------------------------------------------
+{
+    float t_set[N];
+    float u_set[N];
+    float v_set[N];
+    unsigned int hit_mask = intersectTriangles(aRay, t_set, u_set, v_set);
+
+    if (!hit_mask)
+    {
+        return false;
+    }
+
+    // Keep the closest triangle, the first one in case of a tie
+    // as when the triangles are tested one by one
+    unsigned int closest = N;
+    for (unsigned int i = 0; i < N; ++i)
+    {
+        if ((hit_mask & (1 << i)) && (closest == N || t_set[i] < t_set[closest]))
+        {
+            closest = i;
+        }
+    }
+
+    t = t_set[closest];
+    u = u_set[closest];
+    v = v_set[closest];
+    aTriangleId = m_triangle_id[closest];
+    return true;
+}
+
+
+//------------------------------------------------------------------
+template<unsigned int N>
+unsigned int TriangleBlock<N>::intersectTriangles(const Ray& aRay,
+                                                  float aT[N],
+                                                  float aU[N],
+                                                  float aV[N]) const
+//------------------------------------------------------------------
+{
+    // Without SIMD instructions, the triangles are tested one by one
+    unsigned int hit_mask = 0;
+    for (unsigned int i = 0; i < N; ++i)
+    {
+        TriangleRecord record;
+        record.m_p1    = Vec3(m_p1[0][i],    m_p1[1][i],    m_p1[2][i]);
+        record.m_edge1 = Vec3(m_edge1[0][i], m_edge1[1][i], m_edge1[2][i]);
+        record.m_edge2 = Vec3(m_edge2[0][i], m_edge2[1][i], m_edge2[2][i]);
+
+        if (aRay.intersect(record, aT[i], aU[i], aV[i]))
+        {
+            hit_mask |= 1 << i;
+        }
+    }
+
+    return hit_mask;
+}
+
+
+#ifdef __SSE2__
+//-------------------------------------------------------------------------
+template<>
+inline unsigned int TriangleBlock<4>::intersectTriangles(const Ray& aRay,
+                                                         float aT[4],
+                                                         float aU[4],
+                                                         float aV[4]) const
+//-------------------------------------------------------------------------
+{
+    const Vec3& origin = aRay.getOrigin();
+    const Vec3& direction = aRay.getDirection();
+
+    __m128 direction_x = _mm_set1_ps(direction.getX());
+    __m128 direction_y = _mm_set1_ps(direction.getY());
+    __m128 direction_z = _mm_set1_ps(direction.getZ());
+
+    __m128 edge1_x = _mm_loadu_ps(m_edge1[0]);
+    __m128 edge1_y = _mm_loadu_ps(m_edge1[1]);
+    __m128 edge1_z = _mm_loadu_ps(m_edge1[2]);
+
+    __m128 edge2_x = _mm_loadu_ps(m_edge2[0]);
+    __m128 edge2_y = _mm_loadu_ps(m_edge2[1]);
+    __m128 edge2_z = _mm_loadu_ps(m_edge2[2]);
+
+    // Same steps as Ray::intersect, in each lane
+    __m128 pvec_x = _mm_sub_ps(_mm_mul_ps(direction_y, edge2_z), _mm_mul_ps(direction_z, edge2_y));
+    __m128 pvec_y = _mm_sub_ps(_mm_mul_ps(direction_z, edge2_x), _mm_mul_ps(direction_x, edge2_z));
+    __m128 pvec_z = _mm_sub_ps(_mm_mul_ps(direction_x, edge2_y), _mm_mul_ps(direction_y, edge2_x));
+
+    __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edge1_x, pvec_x), _mm_mul_ps(edge1_y, pvec_y)), _mm_mul_ps(edge1_z, pvec_z));
+    __m128 inv_det = _mm_div_ps(_mm_set1_ps(1.0), det);
+
+    __m128 tvec_x = _mm_sub_ps(_mm_set1_ps(origin.getX()), _mm_loadu_ps(m_p1[0]));
+    __m128 tvec_y = _mm_sub_ps(_mm_set1_ps(origin.getY()), _mm_loadu_ps(m_p1[1]));
+    __m128 tvec_z = _mm_sub_ps(_mm_set1_ps(origin.getZ()), _mm_loadu_ps(m_p1[2]));
+
+    __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tvec_x, pvec_x), _mm_mul_ps(tvec_y, pvec_y)), _mm_mul_ps(tvec_z, pvec_z)), inv_det);
+
+    __m128 qvec_x = _mm_sub_ps(_mm_mul_ps(tvec_y, edge1_z), _mm_mul_ps(tvec_z, edge1_y));
+    __m128 qvec_y = _mm_sub_ps(_mm_mul_ps(tvec_z, edge1_x), _mm_mul_ps(tvec_x, edge1_z));
+    __m128 qvec_z = _mm_sub_ps(_mm_mul_ps(tvec_x, edge1_y), _mm_mul_ps(tvec_y, edge1_x));
+
+    __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(edge2_x, qvec_x), _mm_mul_ps(edge2_y, qvec_y)), _mm_mul_ps(edge2_z, qvec_z)), inv_det);
+    __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(direction_x, qvec_x), _mm_mul_ps(direction_y, qvec_y)), _mm_mul_ps(direction_z, qvec_z)), inv_det);
+
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0);
+
+    __m128 hit = _mm_cmpneq_ps(det, zero);
+    hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+    hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpgt_ps(t, _mm_set1_ps(aRay.getTMin())), _mm_cmplt_ps(t, _mm_set1_ps(aRay.getTMax()))));
+    hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+
+    _mm_storeu_ps(aT, t);
+    _mm_storeu_ps(aU, u);
+    _mm_storeu_ps(aV, v);
+    return _mm_movemask_ps(hit);
+}
+#endif
+
+
+#ifdef __AVX__
+//-------------------------------------------------------------------------
+template<>
+inline unsigned int TriangleBlock<8>::intersectTriangles(const Ray& aRay,
+                                                         float aT[8],
+                                                         float aU[8],
+                                                         float aV[8]) const
+//-------------------------------------------------------------------------
+{
+    const Vec3& origin = aRay.getOrigin();
+    const Vec3& direction = aRay.getDirection();
+
+    __m256 direction_x = _mm256_set1_ps(direction.getX());
+    __m256 direction_y = _mm256_set1_ps(direction.getY());
+    __m256 direction_z = _mm256_set1_ps(direction.getZ());
+
+    __m256 edge1_x = _mm256_loadu_ps(m_edge1[0]);
+    __m256 edge1_y = _mm256_loadu_ps(m_edge1[1]);
+    __m256 edge1_z = _mm256_loadu_ps(m_edge1[2]);
+
+    __m256 edge2_x = _mm256_loadu_ps(m_edge2[0]);
+    __m256 edge2_y = _mm256_loadu_ps(m_edge2[1]);
+    __m256 edge2_z = _mm256_loadu_ps(m_edge2[2]);
+
+    // Same steps as Ray::intersect, in each lane
+    __m256 pvec_x = _mm256_sub_ps(_mm256_mul_ps(direction_y, edge2_z), _mm256_mul_ps(direction_z, edge2_y));
+    __m256 pvec_y = _mm256_sub_ps(_mm256_mul_ps(direction_z, edge2_x), _mm256_mul_ps(direction_x, edge2_z));
+    __m256 pvec_z = _mm256_sub_ps(_mm256_mul_ps(direction_x, edge2_y), _mm256_mul_ps(direction_y, edge2_x));
+
+    __m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(edge1_x, pvec_x), _mm256_mul_ps(edge1_y, pvec_y)), _mm256_mul_ps(edge1_z, pvec_z));
+    __m256 inv_det = _mm256_div_ps(_mm256_set1_ps(1.0), det);
+
+    __m256 tvec_x = _mm256_sub_ps(_mm256_set1_ps(origin.getX()), _mm256_loadu_ps(m_p1[0]));
+    __m256 tvec_y = _mm256_sub_ps(_mm256_set1_ps(origin.getY()), _mm256_loadu_ps(m_p1[1]));
+    __m256 tvec_z = _mm256_sub_ps(_mm256_set1_ps(origin.getZ()), _mm256_loadu_ps(m_p1[2]));
+
+    __m256 u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(tvec_x, pvec_x), _mm256_mul_ps(tvec_y, pvec_y)), _mm256_mul_ps(tvec_z, pvec_z)), inv_det);
+
+    __m256 qvec_x = _mm256_sub_ps(_mm256_mul_ps(tvec_y, edge1_z), _mm256_mul_ps(tvec_z, edge1_y));
+    __m256 qvec_y = _mm256_sub_ps(_mm256_mul_ps(tvec_z, edge1_x), _mm256_mul_ps(tvec_x, edge1_z));
+    __m256 qvec_z = _mm256_sub_ps(_mm256_mul_ps(tvec_x, edge1_y), _mm256_mul_ps(tvec_y, edge1_x));
+
+    __m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(edge2_x, qvec_x), _mm256_mul_ps(edge2_y, qvec_y)), _mm256_mul_ps(edge2_z, qvec_z)), inv_det);
+    __m256 v = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(direction_x, qvec_x), _mm256_mul_ps(direction_y, qvec_y)), _mm256_mul_ps(direction_z, qvec_z)), inv_det);
+
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0);
+
+    __m256 hit = _mm256_cmp_ps(det, zero, _CMP_NEQ_UQ);
+    hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(u, one, _CMP_LE_OQ)));
+    hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(t, _mm256_set1_ps(aRay.getTMin()), _CMP_GT_OQ), _mm256_cmp_ps(t, _mm256_set1_ps(aRay.getTMax()), _CMP_LT_OQ)));
+    hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ)));
+
+    _mm256_storeu_ps(aT, t);
+    _mm256_storeu_ps(aU, u);
+    _mm256_storeu_ps(aV, v);
+    return _mm256_movemask_ps(hit);
+}
+#endif
+
+
+#ifdef __AVX512F__
+//---------------------------------------------------------------------------
+template<>
+inline unsigned int TriangleBlock<16>::intersectTriangles(const Ray& aRay,
+                                                          float aT[16],
+                                                          float aU[16],
+                                                          float aV[16]) const
+//---------------------------------------------------------------------------
+{
+    const Vec3& origin = aRay.getOrigin();
+    const Vec3& direction = aRay.getDirection();
+
+    __m512 direction_x = _mm512_set1_ps(direction.getX());
+    __m512 direction_y = _mm512_set1_ps(direction.getY());
+    __m512 direction_z = _mm512_set1_ps(direction.getZ());
+
+    __m512 edge1_x = _mm512_loadu_ps(m_edge1[0]);
+    __m512 edge1_y = _mm512_loadu_ps(m_edge1[1]);
+    __m512 edge1_z = _mm512_loadu_ps(m_edge1[2]);
+
+    __m512 edge2_x = _mm512_loadu_ps(m_edge2[0]);
+    __m512 edge2_y = _mm512_loadu_ps(m_edge2[1]);
+    __m512 edge2_z = _mm512_loadu_ps(m_edge2[2]);
+
+    // Same steps as Ray::intersect, in each lane
+    __m512 pvec_x = _mm512_sub_ps(_mm512_mul_ps(direction_y, edge2_z), _mm512_mul_ps(direction_z, edge2_y));
+    __m512 pvec_y = _mm512_sub_ps(_mm512_mul_ps(direction_z, edge2_x), _mm512_mul_ps(direction_x, edge2_z));
+    __m512 pvec_z = _mm512_sub_ps(_mm512_mul_ps(direction_x, edge2_y), _mm512_mul_ps(direction_y, edge2_x));
+
+    __m512 det = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(edge1_x, pvec_x), _mm512_mul_ps(edge1_y, pvec_y)), _mm512_mul_ps(edge1_z, pvec_z));
+    __m512 inv_det = _mm512_div_ps(_mm512_set1_ps(1.0), det);
+
+    __m512 tvec_x = _mm512_sub_ps(_mm512_set1_ps(origin.getX()), _mm512_loadu_ps(m_p1[0]));
+    __m512 tvec_y = _mm512_sub_ps(_mm512_set1_ps(origin.getY()), _mm512_loadu_ps(m_p1[1]));
+    __m512 tvec_z = _mm512_sub_ps(_mm512_set1_ps(origin.getZ()), _mm512_loadu_ps(m_p1[2]));
+
+    __m512 u = _mm512_mul_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(tvec_x, pvec_x), _mm512_mul_ps(tvec_y, pvec_y)), _mm512_mul_ps(tvec_z, pvec_z)), inv_det);
+
+    __m512 qvec_x = _mm512_sub_ps(_mm512_mul_ps(tvec_y, edge1_z), _mm512_mul_ps(tvec_z, edge1_y));
+    __m512 qvec_y = _mm512_sub_ps(_mm512_mul_ps(tvec_z, edge1_x), _mm512_mul_ps(tvec_x, edge1_z));
+    __m512 qvec_z = _mm512_sub_ps(_mm512_mul_ps(tvec_x, edge1_y), _mm512_mul_ps(tvec_y, edge1_x));
+
+    __m512 t = _mm512_mul_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(edge2_x, qvec_x), _mm512_mul_ps(edge2_y, qvec_y)), _mm512_mul_ps(edge2_z, qvec_z)), inv_det);
+    __m512 v = _mm512_mul_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(direction_x, qvec_x), _mm512_mul_ps(direction_y, qvec_y)), _mm512_mul_ps(direction_z, qvec_z)), inv_det);
+
+    __m512 zero = _mm512_setzero_ps();
+    __m512 one = _mm512_set1_ps(1.0);
+
+    // The comparisons give bit masks directly
+    __mmask16 hit = _mm512_cmp_ps_mask(det, zero, _CMP_NEQ_UQ);
+    hit = _mm512_mask_cmp_ps_mask(hit, u, zero, _CMP_GE_OQ);
+    hit = _mm512_mask_cmp_ps_mask(hit, u, one, _CMP_LE_OQ);
+    hit = _mm512_mask_cmp_ps_mask(hit, t, _mm512_set1_ps(aRay.getTMin()), _CMP_GT_OQ);
+    hit = _mm512_mask_cmp_ps_mask(hit, t, _mm512_set1_ps(aRay.getTMax()), _CMP_LT_OQ);
+    hit = _mm512_mask_cmp_ps_mask(hit, v, zero, _CMP_GE_OQ);
+    hit = _mm512_mask_cmp_ps_mask(hit, _mm512_add_ps(u, v), one, _CMP_LE_OQ);
+
+    _mm512_storeu_ps(aT, t);
+    _mm512_storeu_ps(aU, u);
+    _mm512_storeu_ps(aV, v);
+    return hit;
+}
+#endif
@@ -67,11 +67,16 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <iostream>
 #include <vector>
+#include <stdexcept> // for exceptions
 
 #ifndef __Triangle_h
 #include "Triangle.h"
 #endif
 
+#ifndef __TriangleRecord_h
+#include "TriangleRecord.h"
+#endif
+
 #ifndef __Material
 #include "Material.h"
 #endif
@@ -84,6 +89,30 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Image.h"
 #endif
 
+#ifndef __BVH_h
+#include "BVH.h"
+#endif
+
+#ifndef __WideBVH_h
+#include "WideBVH.h"
+#endif
+
+#ifndef __CompressedWideBVH_h
+#include "CompressedWideBVH.h"
+#endif
+
+#ifndef __StacklessBVH_h
+#include "StacklessBVH.h"
+#endif
+
+#ifndef __TriangleBlock_h
+#include "TriangleBlock.h"
+#endif
+
+#ifndef __Grid_h
+#include "Grid.h"
+#endif
+
 
 //******************************************************************************
 //  Class declaration
@@ -108,6 +137,15 @@ class TriangleMesh
 {
 //******************************************************************************
 public:
+	/// Acceleration structure used to find the triangles hit by a ray
+	enum Accelerator
+	{
+		BVH_ACCELERATOR,              ///< BVH, see setBuildMethod and setBVHWidth
+		GRID_ACCELERATOR,             ///< Uniform grid traversed with 3D-DDA
+		HIERARCHICAL_GRID_ACCELERATOR ///< Grid whose dense cells are subdivided
+	};
+
+
 	TriangleMesh();
 
 	TriangleMesh(const std::vector<float>& aVertexSet);
@@ -137,35 +175,226 @@ public:
 
 	void setGeometry(const std::vector<Triangle>& aTriangleSet);
 
+	void setGeometry(const std::vector<Triangle>& aTriangleSet,
+			const BVH& aBVH);
+
+	void setGeometry(const std::vector<float>& aVertexSet,
+			const std::vector<unsigned int>& anIndexSet,
+			const std::vector<float>& aTextCoordSet,
+			const BVH& aBVH);
+
+	//--------------------------------------------------------------------------
+	/// Move the vertices of the mesh, e.g. for the next frame of an
+	/// animation. The topology must be the same as the one of setGeometry.
+	/// The BVH is refitted, unless its quality degraded too much
+	/// (see setRebuildThreshold)
+	/*
+	*	@param aVertexSet	the new vertices, as many as given to setGeometry
+	*/
+	//--------------------------------------------------------------------------
+	void updateVertices(const std::vector<float>& aVertexSet);
+
+	//--------------------------------------------------------------------------
+	/// Move the vertices of an indexed mesh
+	/*
+	*	@param aVertexSet	the new vertices, 3 floats per vertex
+	*	@param anIndexSet	the indices, the same as given to setGeometry
+	*/
+	//--------------------------------------------------------------------------
+	void updateVertices(const std::vector<float>& aVertexSet,
+			const std::vector<unsigned int>& anIndexSet);
+
+	/// Relative increase of the BVH's SAH cost, since its last build, above
+	/// which updateVertices rebuilds the BVH instead of refitting it
+	/// (0 to always refit)
+	void setRebuildThreshold(float aThreshold);
+	float getRebuildThreshold() const;
+
 	void setMaterial(const Material& aMaterial);
 	Material& getMaterial();
 	const Material& getMaterial() const;
 
+	void setBuildMethod(BVH::BuildMethod aBuildMethod);
+	BVH::BuildMethod getBuildMethod() const;
+
+	/// Lower the SAH cost of the BVH by treelet restructuring after each build
+	void setTreeletRestructuring(bool aRestructuringFlag);
+	bool getTreeletRestructuring() const;
+
+	void setBVHWidth(unsigned int aWidth);
+	unsigned int getBVHWidth() const;
+
+	/// Quantize the child boxes of the wide BVH (widths 4 and 8 only)
+	void setBVHCompression(bool aCompressionFlag);
+	bool getBVHCompression() const;
+
+	/// Traverse the binary BVH with skip pointers instead of a stack (width 2 only)
+	void setStacklessTraversal(bool aStacklessFlag);
+	bool getStacklessTraversal() const;
+
+	/// Pack the triangles of the BVH leaves into blocks that are tested at
+	/// once with SIMD instructions (see TRIANGLE_BLOCK_SIZE)
+	void setTriangleBlocks(bool aBlockFlag);
+	bool getTriangleBlocks() const;
+
+	void setAccelerator(Accelerator anAccelerator);
+	Accelerator getAccelerator() const;
+
 	void setTexture(const Image& anImage);
 	const Image& getTexture() const;
 	Image& getTexture();
 
 	size_t getNumberOfTriangles() const;
-	const Triangle& getTriangle(unsigned int i) const;
+	Triangle getTriangle(unsigned int i) const;
+	void getTriangles(std::vector<Triangle>& aTriangleSet) const;
+
+	// The attributes of the triangles, only needed for shading
+	const Vec3& getVertex(unsigned int aTriangleId, unsigned int i) const;
+	Vec3 getNormal(unsigned int aTriangleId) const;
+	Vec3 getTextCoord(unsigned int aTriangleId, unsigned int i) const;
+
+	// The vertex buffer, shared by the triangles if the mesh is indexed
+	size_t getNumberOfVertices() const;
+	const std::vector<Vec3>& getVertices() const;
+	const std::vector<Vec3>& getTextCoords() const;
+	bool isIndexed() const;
+	bool hasShortIndices() const;
+	unsigned int getVertexIndex(unsigned int aTriangleId, unsigned int i) const;
+
+	/// Memory used by the vertices, the indices and the triangle records, in bytes
+	size_t getGeometryMemorySize() const;
+	const TriangleRecord& getTriangleRecord(unsigned int i) const;
+	size_t getNumberOfTriangleBlocks() const;
 
 	const Vec3& getLowerBBoxCorner() const;
 	const Vec3& getUpperBBoxCorner() const;
 
 	bool intersectBBox(const Ray& aRay) const;
+	bool intersectBBox(const Ray& aRay, float& tNear, float& tFar) const;
+
+	bool intersect(const Ray& aRay, float& t, unsigned int& aTriangleId) const;
 
+	/// Same as intersect(const Ray&, float&, unsigned int&), the barycentric
+	/// coordinates of the closest intersection are kept too
+	bool intersect(const Ray& aRay,
+	               float& t,
+	               float& u,
+	               float& v,
+	               unsigned int& aTriangleId) const;
+
+	/// Record the closer intersections of a packet of rays. The packet
+	/// traverses the binary BVH if it is coherent, otherwise the rays are
+	/// traced one by one
+	void intersect(RayPacket& aPacket) const;
+
+	bool occluded(const Ray& aRay) const;
+
+	/// Same as occluded(const Ray&), the triangle found is recorded, e.g.
+	/// to test it first for the next shadow ray
+	bool occluded(const Ray& aRay, unsigned int& aTriangleId) const;
+
+	/// Mark the rays of a packet that intersect the mesh as occluded, the
+	/// same way as intersect(RayPacket&), but any intersection will do
+	void occluded(RayPacket& aPacket) const;
+
+	const BVH& getBVH() const;
+	const BVH4& getBVH4() const;
+	const BVH8& getBVH8() const;
+	const CompressedBVH4& getCompressedBVH4() const;
+	const CompressedBVH8& getCompressedBVH8() const;
+	const StacklessBVH& getStacklessBVH() const;
+
+	/// Memory used by the nodes that are traversed, in bytes
+	size_t getNodeMemorySize() const;
+	const Grid& getGrid() const;
 
 
 //******************************************************************************
 protected:
 	void computeBoundingBox();
+	void computeTriangleRecords();
+	void setTriangles(const std::vector<Triangle>& aTriangleSet);
+	void setVertices(const std::vector<float>& aVertexSet,
+			const std::vector<unsigned int>& anIndexSet,
+			const std::vector<float>& aTextCoordSet);
+	void setBVH(const BVH& aBVH);
+	void computeTriangleBBoxes(std::vector<Vec3>& aLowerBBoxCornerSet,
+			std::vector<Vec3>& anUpperBBoxCornerSet) const;
+	void buildAccelerator();
+	void updateAccelerator();
+	void collapseBVH();
+	void buildTriangleBlocks();
+
+	template<typename PrimitiveIntersector>
+	bool intersectBVH(const Ray& aRay,
+			const PrimitiveIntersector& anIntersector,
+			float& t,
+			unsigned int& aPrimitiveId) const;
+
+	template<typename PrimitiveOccluder>
+	bool occludedBVH(const Ray& aRay,
+			const PrimitiveOccluder& anOccluder) const;
+
+	// The geometry and the attributes of the triangles are stored in
+	// separate arrays, so that the traversal only brings into cache what
+	// the intersection tests need (hot data), and not what the shading
+	// needs (cold data)
+
+	// What the intersection tests need about each triangle (hot), the only
+	// per-triangle copy of the vertices
+	std::vector<TriangleRecord> m_triangle_record_set;
+
+	// The vertices, for the builds and the shading (cold). They are shared
+	// by the triangles if the mesh is indexed, 3 per triangle otherwise
+	std::vector<Vec3> m_vertex_set;
+
+	// The texture coordinates, 1 per vertex, if any (cold)
+	std::vector<Vec3> m_text_coord_set;
+
+	// The 3 vertex indices of each triangle, in 16 bits if there are fewer
+	// than 65536 vertices. Both are empty if the mesh is not indexed
+	std::vector<unsigned short> m_short_index_set;
+	std::vector<unsigned int> m_index_set;
 
-	std::vector<Triangle> m_p_triangle_set;
 	Material m_material;
 
 	Vec3 m_lower_bbox_corner;
 	Vec3 m_upper_bbox_corner;
 
 	Image m_texture;
+
+	BVH m_bvh;
+	BVH::BuildMethod m_build_method;
+	bool m_treelet_restructuring;
+
+	// SAH cost of the BVH when it was built, and the relative increase
+	// that triggers a rebuild after a refit
+	float m_built_sah_cost;
+	float m_rebuild_threshold;
+
+	// The binary BVH collapsed into 4-wide or 8-wide nodes, if any
+	BVH4 m_bvh4;
+	BVH8 m_bvh8;
+	unsigned int m_bvh_width;
+
+	// The wide BVH with quantized boxes, if any
+	CompressedBVH4 m_compressed_bvh4;
+	CompressedBVH8 m_compressed_bvh8;
+	bool m_bvh_compression;
+
+	// The binary BVH threaded with skip pointers, if any
+	StacklessBVH m_stackless_bvh;
+	bool m_stackless_traversal;
+
+	// The BVH whose leaves reference blocks of triangles instead of
+	// triangles, and the blocks, if any
+	BVH m_block_bvh;
+	std::vector<TriangleBlock<TRIANGLE_BLOCK_SIZE> > m_triangle_block_set;
+	bool m_triangle_blocks;
+
+	// The grid, if it is used instead of the BVH
+	Grid m_grid;
+	Accelerator m_accelerator;
 };
 
 
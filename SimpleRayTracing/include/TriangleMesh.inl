@@ -86,26 +86,56 @@ inline std::ostream& operator<<(std::ostream& anOutput,
 //******************************************************************************
 
 
-//---------------------------------
-inline TriangleMesh::TriangleMesh()
-//---------------------------------
+//----------------------------------
+inline TriangleMesh::TriangleMesh():
+//----------------------------------
+		m_build_method(BVH::SAH),
+		m_treelet_restructuring(false),
+		m_built_sah_cost(0.0),
+		m_rebuild_threshold(0.0),
+		m_bvh_width(4),
+		m_bvh_compression(false),
+		m_stackless_traversal(false),
+		m_triangle_blocks(false),
+		m_accelerator(BVH_ACCELERATOR)
+//----------------------------------
 {
 	// Do nothing
 }
 
 
 //---------------------------------------------------------------------
-inline TriangleMesh::TriangleMesh(const std::vector<float>& aVertexSet)
-//---------------------------------------------------------------------
+inline TriangleMesh::TriangleMesh(const std::vector<float>& aVertexSet):
+//------------------------------------
+		m_build_method(BVH::SAH),
+		m_treelet_restructuring(false),
+		m_built_sah_cost(0.0),
+		m_rebuild_threshold(0.0),
+		m_bvh_width(4),
+		m_bvh_compression(false),
+		m_stackless_traversal(false),
+		m_triangle_blocks(false),
+		m_accelerator(BVH_ACCELERATOR)
+//------------------------------------
 {
 	setGeometry(aVertexSet);
 }
 
 
-//----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
 inline TriangleMesh::TriangleMesh(const std::vector<float>& aVertexSet,
-		                          const std::vector<unsigned int>& anIndexSet)
-//----------------------------------------------------------------------------
+		                          const std::vector<unsigned int>& anIndexSet):
+//-----------------------------------------------------------------------------
+		m_build_method(BVH::SAH),
+		m_treelet_restructuring(false),
+		m_built_sah_cost(0.0),
+		m_rebuild_threshold(0.0),
+		m_bvh_width(4),
+		m_bvh_compression(false),
+		m_stackless_traversal(false),
+		m_triangle_blocks(false),
+		m_accelerator(BVH_ACCELERATOR)
+//-----------------------------------------------------------------------------
 {
 	setGeometry(aVertexSet, anIndexSet);
 }
@@ -113,8 +143,18 @@ inline TriangleMesh::TriangleMesh(const std::vector<float>& aVertexSet,
 
 //------------------------------------------------------------------------
 inline TriangleMesh::TriangleMesh(const std::vector<float>& aVertexSet,
-			                      const std::vector<float>& aTextCoordSet)
-//------------------------------------------------------------------------
+			                      const std::vector<float>& aTextCoordSet):
+//------------------------------------
+		m_build_method(BVH::SAH),
+		m_treelet_restructuring(false),
+		m_built_sah_cost(0.0),
+		m_rebuild_threshold(0.0),
+		m_bvh_width(4),
+		m_bvh_compression(false),
+		m_stackless_traversal(false),
+		m_triangle_blocks(false),
+		m_accelerator(BVH_ACCELERATOR)
+//------------------------------------
 {
 	setGeometry(aVertexSet, aTextCoordSet);
 }
@@ -123,7 +163,17 @@ inline TriangleMesh::TriangleMesh(const std::vector<float>& aVertexSet,
 //----------------------------------------------------------------------------
 inline TriangleMesh::TriangleMesh(const std::vector<float>& aVertexSet,
 		                          const std::vector<unsigned int>& anIndexSet,
-			                      const std::vector<float>& aTextCoordSet)
+			                      const std::vector<float>& aTextCoordSet):
+//----------------------------------------------------------------------------
+		m_build_method(BVH::SAH),
+		m_treelet_restructuring(false),
+		m_built_sah_cost(0.0),
+		m_rebuild_threshold(0.0),
+		m_bvh_width(4),
+		m_bvh_compression(false),
+		m_stackless_traversal(false),
+		m_triangle_blocks(false),
+		m_accelerator(BVH_ACCELERATOR)
 //----------------------------------------------------------------------------
 {
 	setGeometry(aVertexSet, anIndexSet, aTextCoordSet);
@@ -131,8 +181,18 @@ inline TriangleMesh::TriangleMesh(const std::vector<float>& aVertexSet,
 
 
 //--------------------------------------------------------------------------
-inline TriangleMesh::TriangleMesh(const std::vector<Triangle>& aTriangleSet)
-//--------------------------------------------------------------------------
+inline TriangleMesh::TriangleMesh(const std::vector<Triangle>& aTriangleSet):
+//------------------------------------
+		m_build_method(BVH::SAH),
+		m_treelet_restructuring(false),
+		m_built_sah_cost(0.0),
+		m_rebuild_threshold(0.0),
+		m_bvh_width(4),
+		m_bvh_compression(false),
+		m_stackless_traversal(false),
+		m_triangle_blocks(false),
+		m_accelerator(BVH_ACCELERATOR)
+//------------------------------------
 {
 	setGeometry(aTriangleSet);
 }
@@ -142,9 +202,35 @@ inline TriangleMesh::TriangleMesh(const std::vector<Triangle>& aTriangleSet)
 inline void TriangleMesh::setGeometry(const std::vector<Triangle>& aTriangleSet)
 //------------------------------------------------------------------------------
 {
-	m_p_triangle_set = aTriangleSet;
+	setTriangles(aTriangleSet);
 
 	computeBoundingBox();
+	computeTriangleRecords();
+	buildAccelerator();
+}
+
+
+//------------------------------------------------------------------------------
+inline void TriangleMesh::setGeometry(const std::vector<Triangle>& aTriangleSet,
+                                      const BVH& aBVH)
+//------------------------------------------------------------------------------
+{
+	// The BVH was built beforehand over the same triangles
+	setTriangles(aTriangleSet);
+	setBVH(aBVH);
+}
+
+
+//--------------------------------------------------------------------------------
+inline void TriangleMesh::setGeometry(const std::vector<float>& aVertexSet,
+                                      const std::vector<unsigned int>& anIndexSet,
+                                      const std::vector<float>& aTextCoordSet,
+                                      const BVH& aBVH)
+//--------------------------------------------------------------------------------
+{
+	// The BVH was built beforehand over the same triangles
+	setVertices(aVertexSet, anIndexSet, aTextCoordSet);
+	setBVH(aBVH);
 }
 
 
@@ -172,6 +258,202 @@ inline const Material& TriangleMesh::getMaterial() const
 }
 
 
+//---------------------------------------------------------------------
+inline void TriangleMesh::setBuildMethod(BVH::BuildMethod aBuildMethod)
+//---------------------------------------------------------------------
+{
+	// Rebuild the BVH if needed
+	if (m_build_method != aBuildMethod)
+	{
+		m_build_method = aBuildMethod;
+
+		if (m_vertex_set.size() && m_accelerator == BVH_ACCELERATOR)
+		{
+			buildAccelerator();
+		}
+	}
+}
+
+
+//----------------------------------------------------------
+inline BVH::BuildMethod TriangleMesh::getBuildMethod() const
+//----------------------------------------------------------
+{
+	return m_build_method;
+}
+
+
+//--------------------------------------------------------------------------
+inline void TriangleMesh::setTreeletRestructuring(bool aRestructuringFlag)
+//--------------------------------------------------------------------------
+{
+	// Rebuild the BVH if needed
+	if (m_treelet_restructuring != aRestructuringFlag)
+	{
+		m_treelet_restructuring = aRestructuringFlag;
+
+		if (m_vertex_set.size() && m_accelerator == BVH_ACCELERATOR)
+		{
+			buildAccelerator();
+		}
+	}
+}
+
+
+//-------------------------------------------------------
+inline bool TriangleMesh::getTreeletRestructuring() const
+//-------------------------------------------------------
+{
+	return m_treelet_restructuring;
+}
+
+
+//--------------------------------------------------------
+inline void TriangleMesh::setBVHWidth(unsigned int aWidth)
+//--------------------------------------------------------
+{
+	if (aWidth != 2 && aWidth != 4 && aWidth != 8)
+	{
+		throw std::invalid_argument("The BVH width must be 2, 4 or 8");
+	}
+
+	// Collapse the BVH again if needed
+	if (m_bvh_width != aWidth)
+	{
+		m_bvh_width = aWidth;
+
+		if (m_vertex_set.size())
+		{
+			collapseBVH();
+		}
+	}
+}
+
+
+//---------------------------------------------------
+inline unsigned int TriangleMesh::getBVHWidth() const
+//---------------------------------------------------
+{
+	return m_bvh_width;
+}
+
+
+//----------------------------------------------------------------
+inline void TriangleMesh::setBVHCompression(bool aCompressionFlag)
+//----------------------------------------------------------------
+{
+	// Collapse the BVH again if needed
+	if (m_bvh_compression != aCompressionFlag)
+	{
+		m_bvh_compression = aCompressionFlag;
+
+		if (m_vertex_set.size())
+		{
+			collapseBVH();
+		}
+	}
+}
+
+
+//-------------------------------------------------
+inline bool TriangleMesh::getBVHCompression() const
+//-------------------------------------------------
+{
+	return m_bvh_compression;
+}
+
+
+//------------------------------------------------------------------
+inline void TriangleMesh::setStacklessTraversal(bool aStacklessFlag)
+//------------------------------------------------------------------
+{
+	// Thread the BVH again if needed
+	if (m_stackless_traversal != aStacklessFlag)
+	{
+		m_stackless_traversal = aStacklessFlag;
+
+		if (m_vertex_set.size())
+		{
+			collapseBVH();
+		}
+	}
+}
+
+
+//-----------------------------------------------------
+inline bool TriangleMesh::getStacklessTraversal() const
+//-----------------------------------------------------
+{
+	return m_stackless_traversal;
+}
+
+
+//----------------------------------------------------------
+inline void TriangleMesh::setTriangleBlocks(bool aBlockFlag)
+//----------------------------------------------------------
+{
+	// Pack the triangles again if needed
+	if (m_triangle_blocks != aBlockFlag)
+	{
+		m_triangle_blocks = aBlockFlag;
+
+		if (m_vertex_set.size())
+		{
+			collapseBVH();
+		}
+	}
+}
+
+
+//-------------------------------------------------
+inline bool TriangleMesh::getTriangleBlocks() const
+//-------------------------------------------------
+{
+	return m_triangle_blocks;
+}
+
+
+//-------------------------------------------------------------
+inline void TriangleMesh::setRebuildThreshold(float aThreshold)
+//-------------------------------------------------------------
+{
+	m_rebuild_threshold = aThreshold;
+}
+
+
+//----------------------------------------------------
+inline float TriangleMesh::getRebuildThreshold() const
+//----------------------------------------------------
+{
+	return m_rebuild_threshold;
+}
+
+
+//-----------------------------------------------------------------
+inline void TriangleMesh::setAccelerator(Accelerator anAccelerator)
+//-----------------------------------------------------------------
+{
+	// Rebuild the acceleration structure if needed
+	if (m_accelerator != anAccelerator)
+	{
+		m_accelerator = anAccelerator;
+
+		if (m_vertex_set.size())
+		{
+			buildAccelerator();
+		}
+	}
+}
+
+
+//-------------------------------------------------------------------
+inline TriangleMesh::Accelerator TriangleMesh::getAccelerator() const
+//-------------------------------------------------------------------
+{
+	return m_accelerator;
+}
+
+
 //--------------------------------------------------------
 inline void TriangleMesh::setTexture(const Image& anImage)
 //--------------------------------------------------------
@@ -200,15 +482,145 @@ inline Image& TriangleMesh::getTexture()
 inline size_t TriangleMesh::getNumberOfTriangles() const
 //------------------------------------------------------
 {
-	return m_p_triangle_set.size();
+	if (isIndexed())
+	{
+		return (m_short_index_set.size() + m_index_set.size()) / 3;
+	}
+
+	return m_vertex_set.size() / 3;
+}
+
+
+//-------------------------------------------------------------
+inline Triangle TriangleMesh::getTriangle(unsigned int i) const
+//-------------------------------------------------------------
+{
+	if (m_text_coord_set.empty())
+	{
+		return Triangle(getVertex(i, 0), getVertex(i, 1), getVertex(i, 2));
+	}
+
+	return Triangle(getVertex(i, 0), getVertex(i, 1), getVertex(i, 2),
+			getTextCoord(i, 0), getTextCoord(i, 1), getTextCoord(i, 2));
+}
+
+
+//----------------------------------------------------------------------------------------
+inline const Vec3& TriangleMesh::getVertex(unsigned int aTriangleId, unsigned int i) const
+//----------------------------------------------------------------------------------------
+{
+	return m_vertex_set[getVertexIndex(aTriangleId, i)];
+}
+
+
+//-----------------------------------------------------------------
+inline Vec3 TriangleMesh::getNormal(unsigned int aTriangleId) const
+//-----------------------------------------------------------------
+{
+	// Computed as in Triangle, from the same edges
+	const TriangleRecord& record = m_triangle_record_set[aTriangleId];
+
+	Vec3 normal = record.m_edge1.crossProduct(record.m_edge2);
+	normal.normalise();
+
+	return normal;
+}
+
+
+//------------------------------------------------------------------------------------
+inline Vec3 TriangleMesh::getTextCoord(unsigned int aTriangleId, unsigned int i) const
+//------------------------------------------------------------------------------------
+{
+	if (m_text_coord_set.empty())
+	{
+		return Vec3();
+	}
+
+	return m_text_coord_set[getVertexIndex(aTriangleId, i)];
+}
+
+
+//-----------------------------------------------------
+inline size_t TriangleMesh::getNumberOfVertices() const
+//-----------------------------------------------------
+{
+	return m_vertex_set.size();
+}
+
+
+//---------------------------------------------------------------
+inline const std::vector<Vec3>& TriangleMesh::getVertices() const
+//---------------------------------------------------------------
+{
+	return m_vertex_set;
+}
+
+
+//-----------------------------------------------------------------
+inline const std::vector<Vec3>& TriangleMesh::getTextCoords() const
+//-----------------------------------------------------------------
+{
+	return m_text_coord_set;
+}
+
+
+//-----------------------------------------
+inline bool TriangleMesh::isIndexed() const
+//-----------------------------------------
+{
+	return m_short_index_set.size() || m_index_set.size();
+}
+
+
+//-----------------------------------------------
+inline bool TriangleMesh::hasShortIndices() const
+//-----------------------------------------------
+{
+	return m_short_index_set.size();
 }
 
 
-//--------------------------------------------------------------------
-inline const Triangle& TriangleMesh::getTriangle(unsigned int i) const
-//--------------------------------------------------------------------
+//----------------------------------------------------------------------------------------------
+inline unsigned int TriangleMesh::getVertexIndex(unsigned int aTriangleId, unsigned int i) const
+//----------------------------------------------------------------------------------------------
 {
-	return m_p_triangle_set[i];
+	if (m_short_index_set.size())
+	{
+		return m_short_index_set[aTriangleId * 3 + i];
+	}
+	else if (m_index_set.size())
+	{
+		return m_index_set[aTriangleId * 3 + i];
+	}
+
+	return aTriangleId * 3 + i;
+}
+
+
+//-------------------------------------------------------
+inline size_t TriangleMesh::getGeometryMemorySize() const
+//-------------------------------------------------------
+{
+	return m_triangle_record_set.size() * sizeof(TriangleRecord) +
+			(m_vertex_set.size() + m_text_coord_set.size()) * sizeof(Vec3) +
+			m_short_index_set.size() * sizeof(unsigned short) +
+			m_index_set.size() * sizeof(unsigned int);
+}
+
+
+//--------------------------------------------------------------------------------
+inline const TriangleRecord& TriangleMesh::getTriangleRecord(unsigned int i) const
+//--------------------------------------------------------------------------------
+{
+	return m_triangle_record_set[i];
+}
+
+
+//-----------------------------------------------------------
+inline size_t TriangleMesh::getNumberOfTriangleBlocks() const
+//-----------------------------------------------------------
+{
+	return m_triangle_block_set.size();
 }
 
 
@@ -232,5 +644,317 @@ inline const Vec3& TriangleMesh::getUpperBBoxCorner() const
 inline bool TriangleMesh::intersectBBox(const Ray& aRay) const
 //------------------------------------------------------------
 {
-	return true;
+	float t_near;
+	float t_far;
+
+	return intersectBBox(aRay, t_near, t_far);
+}
+
+
+//--------------------------------------------------------
+inline bool TriangleMesh::intersectBBox(const Ray& aRay,
+                                        float& tNear,
+                                        float& tFar) const
+//--------------------------------------------------------
+{
+	// The box overlaps the ray's interval
+	return aRay.intersect(m_lower_bbox_corner, m_upper_bbox_corner, tNear, tFar);
+}
+
+
+//------------------------------------------------------------------
+inline bool TriangleMesh::intersect(const Ray& aRay,
+                                    float& t,
+                                    unsigned int& aTriangleId) const
+//------------------------------------------------------------------
+{
+	// The barycentric coordinates are dropped
+	float u;
+	float v;
+	return intersect(aRay, t, u, v, aTriangleId);
+}
+
+
+//------------------------------------------------------------------
+inline bool TriangleMesh::intersect(const Ray& aRay,
+                                    float& t,
+                                    float& u,
+                                    float& v,
+                                    unsigned int& aTriangleId) const
+//------------------------------------------------------------------
+{
+	if (m_accelerator == BVH_ACCELERATOR && m_triangle_blocks)
+	{
+		const std::vector<TriangleBlock<TRIANGLE_BLOCK_SIZE> >& triangle_block_set = m_triangle_block_set;
+
+		// The leaves reference blocks, the last block that is hit holds the
+		// closest triangle, as the ray's interval shrinks after each hit
+		unsigned int triangle_id = 0;
+		auto block_intersector = [&triangle_block_set, &triangle_id, &u, &v](const Ray& aRay, unsigned int aBlockId, float& t)
+		{
+			return triangle_block_set[aBlockId].intersect(aRay, t, u, v, triangle_id);
+		};
+
+		unsigned int block_id;
+		if (intersectBVH(aRay, block_intersector, t, block_id))
+		{
+			aTriangleId = triangle_id;
+			return true;
+		}
+
+		return false;
+	}
+
+	const std::vector<TriangleRecord>& triangle_record_set = m_triangle_record_set;
+
+	// The BVH shrinks the ray's interval as closer triangles are found,
+	// the barycentric coordinates of the last one that is hit are kept
+	auto intersector = [&triangle_record_set, &u, &v](const Ray& aRay, unsigned int aTriangleId, float& t)
+	{
+		return aRay.intersect(triangle_record_set[aTriangleId], t, u, v);
+	};
+
+	if (m_accelerator != BVH_ACCELERATOR)
+	{
+		return m_grid.intersect(aRay, intersector, t, aTriangleId);
+	}
+
+	return intersectBVH(aRay, intersector, t, aTriangleId);
+}
+
+
+//------------------------------------------------------------
+inline void TriangleMesh::intersect(RayPacket& aPacket) const
+//------------------------------------------------------------
+{
+	if (m_accelerator != BVH_ACCELERATOR || !aPacket.isCoherent())
+	{
+		for (unsigned int i = 0; i < aPacket.getSize(); ++i)
+		{
+			float t;
+			float u;
+			float v;
+			unsigned int triangle_id;
+			if (intersect(aPacket.getRay(i), t, u, v, triangle_id))
+			{
+				aPacket.setHit(i, t, u, v, triangle_id);
+			}
+		}
+		return;
+	}
+
+	const std::vector<TriangleRecord>& triangle_record_set = m_triangle_record_set;
+
+	auto packet_intersector = [&triangle_record_set](RayPacket& aPacket, unsigned int aTriangleId, unsigned int aFirstRay)
+	{
+		aPacket.intersect(triangle_record_set[aTriangleId], aTriangleId, aFirstRay);
+	};
+
+	m_bvh.intersect(aPacket, packet_intersector);
+}
+
+
+//-------------------------------------------------------
+inline bool TriangleMesh::occluded(const Ray& aRay) const
+//-------------------------------------------------------
+{
+	unsigned int triangle_id;
+	return occluded(aRay, triangle_id);
+}
+
+
+//----------------------------------------------------------------------------------
+inline bool TriangleMesh::occluded(const Ray& aRay, unsigned int& aTriangleId) const
+//----------------------------------------------------------------------------------
+{
+	if (m_accelerator == BVH_ACCELERATOR && m_triangle_blocks)
+	{
+		const std::vector<TriangleBlock<TRIANGLE_BLOCK_SIZE> >& triangle_block_set = m_triangle_block_set;
+
+		auto block_occluder = [&triangle_block_set, &aTriangleId](const Ray& aRay, unsigned int aBlockId)
+		{
+			float t;
+			return triangle_block_set[aBlockId].intersect(aRay, t, aTriangleId);
+		};
+
+		return occludedBVH(aRay, block_occluder);
+	}
+
+	const std::vector<TriangleRecord>& triangle_record_set = m_triangle_record_set;
+
+	auto occluder = [&triangle_record_set, &aTriangleId](const Ray& aRay, unsigned int aPrimitiveId)
+	{
+		float t;
+		if (aRay.intersect(triangle_record_set[aPrimitiveId], t))
+		{
+			aTriangleId = aPrimitiveId;
+			return true;
+		}
+		return false;
+	};
+
+	if (m_accelerator != BVH_ACCELERATOR)
+	{
+		return m_grid.occluded(aRay, occluder);
+	}
+
+	return occludedBVH(aRay, occluder);
+}
+
+
+//----------------------------------------------------------
+inline void TriangleMesh::occluded(RayPacket& aPacket) const
+//----------------------------------------------------------
+{
+	if (m_accelerator != BVH_ACCELERATOR || !aPacket.isCoherent())
+	{
+		for (unsigned int i = 0; i < aPacket.getSize(); ++i)
+		{
+			if (!aPacket.hasHit(i) && occluded(aPacket.getRay(i)))
+			{
+				aPacket.setOccluded(i);
+			}
+		}
+		return;
+	}
+
+	const std::vector<TriangleRecord>& triangle_record_set = m_triangle_record_set;
+
+	// The occluded rays drop out of the traversal, as their interval is empty
+	auto packet_occluder = [&triangle_record_set](RayPacket& aPacket, unsigned int aTriangleId, unsigned int aFirstRay)
+	{
+		aPacket.occlude(triangle_record_set[aTriangleId], aFirstRay);
+	};
+
+	m_bvh.intersect(aPacket, packet_occluder);
+}
+
+
+//------------------------------------------------------------------------
+template<typename PrimitiveIntersector>
+bool TriangleMesh::intersectBVH(const Ray& aRay,
+                                const PrimitiveIntersector& anIntersector,
+                                float& t,
+                                unsigned int& aPrimitiveId) const
+//------------------------------------------------------------------------
+{
+	switch (m_bvh_width)
+	{
+	case 4:
+		if (m_bvh_compression)
+		{
+			return m_compressed_bvh4.intersect(aRay, anIntersector, t, aPrimitiveId);
+		}
+		return m_bvh4.intersect(aRay, anIntersector, t, aPrimitiveId);
+
+	case 8:
+		if (m_bvh_compression)
+		{
+			return m_compressed_bvh8.intersect(aRay, anIntersector, t, aPrimitiveId);
+		}
+		return m_bvh8.intersect(aRay, anIntersector, t, aPrimitiveId);
+
+	default:
+		if (m_stackless_traversal)
+		{
+			return m_stackless_bvh.intersect(aRay, anIntersector, t, aPrimitiveId);
+		}
+		else if (m_triangle_blocks)
+		{
+			return m_block_bvh.intersect(aRay, anIntersector, t, aPrimitiveId);
+		}
+		return m_bvh.intersect(aRay, anIntersector, t, aPrimitiveId);
+	}
+}
+
+
+//-----------------------------------------------------------------------
+template<typename PrimitiveOccluder>
+bool TriangleMesh::occludedBVH(const Ray& aRay,
+                               const PrimitiveOccluder& anOccluder) const
+//-----------------------------------------------------------------------
+{
+	switch (m_bvh_width)
+	{
+	case 4:
+		if (m_bvh_compression)
+		{
+			return m_compressed_bvh4.occluded(aRay, anOccluder);
+		}
+		return m_bvh4.occluded(aRay, anOccluder);
+
+	case 8:
+		if (m_bvh_compression)
+		{
+			return m_compressed_bvh8.occluded(aRay, anOccluder);
+		}
+		return m_bvh8.occluded(aRay, anOccluder);
+
+	default:
+		if (m_stackless_traversal)
+		{
+			return m_stackless_bvh.occluded(aRay, anOccluder);
+		}
+		else if (m_triangle_blocks)
+		{
+			return m_block_bvh.occluded(aRay, anOccluder);
+		}
+		return m_bvh.occluded(aRay, anOccluder);
+	}
+}
+
+
+//--------------------------------------------
+inline const BVH& TriangleMesh::getBVH() const
+//--------------------------------------------
+{
+	return m_bvh;
+}
+
+
+//----------------------------------------------
+inline const BVH4& TriangleMesh::getBVH4() const
+//----------------------------------------------
+{
+	return m_bvh4;
+}
+
+
+//----------------------------------------------
+inline const BVH8& TriangleMesh::getBVH8() const
+//----------------------------------------------
+{
+	return m_bvh8;
+}
+
+
+//------------------------------------------------------------------
+inline const CompressedBVH4& TriangleMesh::getCompressedBVH4() const
+//------------------------------------------------------------------
+{
+	return m_compressed_bvh4;
+}
+
+
+//------------------------------------------------------------------
+inline const CompressedBVH8& TriangleMesh::getCompressedBVH8() const
+//------------------------------------------------------------------
+{
+	return m_compressed_bvh8;
+}
+
+
+//-------------------------------------------------------------
+inline const StacklessBVH& TriangleMesh::getStacklessBVH() const
+//-------------------------------------------------------------
+{
+	return m_stackless_bvh;
+}
+
+
+//----------------------------------------------
+inline const Grid& TriangleMesh::getGrid() const
+//----------------------------------------------
+{
+	return m_grid;
 }
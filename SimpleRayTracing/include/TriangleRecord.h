@@ -32,16 +32,21 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 
+
+#ifndef __TriangleRecord_h
+#define __TriangleRecord_h
+
+
 /**
 ********************************************************************************
 *
-*   @file       Ray.cxx
+*   @file       TriangleRecord.h
 *
-*   @brief      Class to manipulate a ray.
+*   @brief      Precomputed data to intersect a ray with a triangle.
 *
 *   @version    1.0
 *
-*   @date       11/09/2020
+*   @date       17/10/2026
 *
 *   @author     Dr Franck P. Vidal
 *
@@ -53,7 +58,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *
 *   Copyright
 *   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
-*   http://www.fpvidal.net/, Sept 2020, 2020, version 1.0, BSD 3-Clause License
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
 *
 ********************************************************************************
 */
@@ -62,64 +67,43 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //******************************************************************************
 //  Include
 //******************************************************************************
-#ifndef __Ray_h
-#include "Ray.h"
+#ifndef __Vec3_h
+#include "Vec3.h"
 #endif
 
+#ifndef __Triangle_h
+#include "Triangle.h"
+#endif
 
 
-//------------------------------------------------------------
-bool Ray::intersect(const Triangle& aTriangle, float& t) const
-//------------------------------------------------------------
+//==============================================================================
+/**
+*   @struct TriangleRecord
+*   @brief  TriangleRecord holds what the Möller–Trumbore test needs about a
+*           triangle: its first vertex and its two edges from this vertex.
+*           The edges are computed once per triangle instead of once per
+*           ray/triangle test, and a record is 36 bytes instead of the 84
+*           bytes of a Triangle, most of which is only needed for shading.
+*/
+//==============================================================================
+struct TriangleRecord
+//------------------------------------------------------------------------------
 {
-		//	ARTICLE
-		//    Fast, minimum storage ray/triangle intersection
-		//    Share on
-		//	Authors:
-		//    Tomas Möller profile imageTomas Möller, Ben  Trumbore profile imageBen Trumbore
-		//
-		// Publication: SIGGRAPH '05: ACM SIGGRAPH 2005 CoursesJuly 2005 Pages 7–eshttps://doi.org/10.1145/1198555.1198746
-
-		// See https://cadxfem.org/inf/Fast%20MinimumStorage%20RayTriangle%20Intersection.pdf
-
-		// Find vectors for two edges sharing vert
-		Vec3 edge1 = aTriangle.getP2() - aTriangle.getP1();
-		Vec3 edge2 = aTriangle.getP3() - aTriangle.getP1();
-
-		// Begin calculating determinant - also used to calculate U parameter
-		Vec3 pvec = m_direction.crossProduct(edge2);
-
-		// If determinant is near zero, ray lies in plane of triangle
-		float det = edge1.dotProduct(pvec);
-		if (std::fpclassify(det) == FP_ZERO)
-		{
-				return false;
-		}
-
-		float inv_det = 1.0 / det;
-
-		// Calculate distance from vert P1 to ray origin
-		Vec3 tvec = m_origin - aTriangle.getP1();
-
-		// Calculate V parameter and test bounds
-		float u = tvec.dotProduct(pvec) * inv_det;
-		if (u < 0.0 || u > 1.0)
-		{
-				return false;
-		}
-
-		// Prepare to test V parameter
-		Vec3 qvec = tvec.crossProduct(edge1);
-
-		// Calculate V parameter and test bounds
-		float v = m_direction.dotProduct(qvec) * inv_det;
-		if (v < 0.0 || u + v > 1.0)
-		{
-				return false;
-		}
-
-		// Calculate t, ray intersects triangle
-		t = edge2.dotProduct(qvec) * inv_det;
-
-		return true;
-}
+    TriangleRecord();
+    TriangleRecord(const Triangle& aTriangle);
+
+    /// The first vertex
+    Vec3 m_p1;
+
+    /// P2 - P1
+    Vec3 m_edge1;
+
+    /// P3 - P1
+    Vec3 m_edge2;
+};
+
+
+#include "TriangleRecord.inl"
+
+
+#endif // __TriangleRecord_h
@@ -0,0 +1,211 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+#ifndef __WideBVH_h
+#define __WideBVH_h
+
+
+/**
+********************************************************************************
+*
+*   @file       WideBVH.h
+*
+*   @brief      Class to manipulate a wide (4 or 8 children per node) BVH.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <vector>
+
+#ifndef __Ray_h
+#include "Ray.h"
+#endif
+
+#ifndef __BVH_h
+#include "BVH.h"
+#endif
+
+
+//==============================================================================
+/**
+*   @struct WideBVHNode
+*   @brief  WideBVHNode is a node of a wide BVH. The bounding boxes of its
+*           N children are stored in structure of arrays (SoA) layout so that
+*           a single sequence of SIMD instructions tests a ray against all of
+*           them. Unused child slots have an empty (inverted) bounding box.
+*/
+//==============================================================================
+template<unsigned int N>
+struct WideBVHNode
+//------------------------------------------------------------------------------
+{
+    /// The bounding boxes of the children: lower x, y, z, then upper x, y, z
+    float m_bbox[6][N];
+
+    /// Index of the child node if the child is internal,
+    /// index of its first primitive otherwise
+    unsigned int m_child[N];
+
+    /// Number of primitives in the child, 0 if the child is internal or empty
+    unsigned int m_primitive_count[N];
+};
+
+
+//==============================================================================
+/**
+*   @class  WideBVH
+*   @brief  WideBVH is a class to traverse a BVH collapsed into nodes of
+*           N children: BVH4 uses SSE and BVH8 uses AVX to test the children's
+*           boxes. It reduces the number of nodes visited per ray, and
+*           therefore the pointer chasing and the cache misses.
+*/
+//==============================================================================
+template<unsigned int N>
+class WideBVH
+//------------------------------------------------------------------------------
+{
+//******************************************************************************
+public:
+    WideBVH();
+
+    //--------------------------------------------------------------------------
+    /// Build the hierarchy by collapsing a binary BVH
+    /*
+    *   @param aBVH the binary BVH
+    */
+    //--------------------------------------------------------------------------
+    void build(const BVH& aBVH);
+
+    void clear();
+
+    bool isEmpty() const;
+
+    size_t getNumberOfNodes() const;
+    const WideBVHNode<N>& getNode(unsigned int i) const;
+
+    size_t getNumberOfPrimitiveIndices() const;
+    unsigned int getPrimitiveIndex(unsigned int i) const;
+
+    //--------------------------------------------------------------------------
+    /// Find the closest intersection between a ray and the primitives
+    /*
+    *   @param aRay             the ray
+    *   @param anIntersector    functor with the signature
+    *                           bool (const Ray&, unsigned int aPrimitiveId, float& t),
+    *                           see BVH::intersect
+    *   @param t                the distance to the closest intersection (if any)
+    *   @param aPrimitiveId     the ID of the closest primitive (if any)
+    *   @return true if an intersection was found within the ray's interval
+    */
+    //-------------------------------------------------------
+    template<typename PrimitiveIntersector>
+    bool intersect(const Ray& aRay,
+                   const PrimitiveIntersector& anIntersector,
+                   float& t,
+                   unsigned int& aPrimitiveId) const;
+
+    //-------------------------------------------------------
+    /// Check if any primitive intersects a ray (any-hit query)
+    /*
+    *   @param aRay             the ray
+    *   @param anOccluder       functor with the signature
+    *                           bool (const Ray&, unsigned int aPrimitiveId),
+    *                           see BVH::occluded
+    *   @return true if an intersection was found within the ray's interval
+    */
+    //--------------------------------------------------------------------------
+    template<typename PrimitiveOccluder>
+    bool occluded(const Ray& aRay,
+                  const PrimitiveOccluder& anOccluder) const;
+
+
+//******************************************************************************
+protected:
+    static const unsigned int MAX_STACK_SIZE = 64 * N;
+
+    //--------------------------------------------------------------------------
+    /// Test a ray against the bounding boxes of all the children of a node
+    /*
+    *   @param aNode        the node
+    *   @param aRay         the ray
+    *   @param aTNear       the entry distance of the ray in each child's box
+    *   @return a bit mask of the children hit within the ray's interval
+    */
+    //--------------------------------------------------------------------------
+    static unsigned int intersectChildren(const WideBVHNode<N>& aNode,
+                                          const Ray& aRay,
+                                          float aTNear[N]);
+
+    unsigned int collapse(const BVH& aBVH, unsigned int aBinaryNodeId);
+
+    /// The nodes, the root is the first one
+    std::vector<WideBVHNode<N> > m_node_set;
+
+    /// The primitive indices referenced by the leaves
+    std::vector<unsigned int> m_primitive_index_set;
+};
+
+
+/// BVH with 4 children per node, the boxes are tested with SSE
+typedef WideBVH<4> BVH4;
+
+/// BVH with 8 children per node, the boxes are tested with AVX
+typedef WideBVH<8> BVH8;
+
+
+#include "WideBVH.inl"
+
+
+#endif // __WideBVH_h
@@ -0,0 +1,527 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       WideBVH.inl
+*
+*   @brief      Class to manipulate a wide (4 or 8 children per node) BVH.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <algorithm> // for min/max
+#include <limits>    // for inf
+
+#if defined(__SSE2__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//--------------------------
+template<unsigned int N>
+inline WideBVH<N>::WideBVH()
+//--------------------------
+{
+    // Do nothing
+}
+
+
+//-------------------------------------
+template<unsigned int N>
+void WideBVH<N>::build(const BVH& aBVH)
+//-------------------------------------
+{
+    clear();
+
+    if (aBVH.isEmpty())
+    {
+        return;
+    }
+
+    // The leaves reference the same primitive ranges as in the binary BVH
+    m_primitive_index_set.resize(aBVH.getNumberOfPrimitiveIndices());
+    for (unsigned int i = 0; i < m_primitive_index_set.size(); ++i)
+    {
+        m_primitive_index_set[i] = aBVH.getPrimitiveIndex(i);
+    }
+
+    // Every wide node replaces up to N - 1 binary internal nodes
+    m_node_set.reserve(aBVH.getNumberOfNodes() / (N - 1) + 1);
+    collapse(aBVH, 0);
+}
+
+
+//-----------------------------
+template<unsigned int N>
+inline void WideBVH<N>::clear()
+//-----------------------------
+{
+    m_node_set.clear();
+    m_primitive_index_set.clear();
+}
+
+
+//-------------------------------------
+template<unsigned int N>
+inline bool WideBVH<N>::isEmpty() const
+//-------------------------------------
+{
+    return m_node_set.empty();
+}
+
+
+//------------------------------------------------
+template<unsigned int N>
+inline size_t WideBVH<N>::getNumberOfNodes() const
+//------------------------------------------------
+{
+    return m_node_set.size();
+}
+
+
+//--------------------------------------------------------------------
+template<unsigned int N>
+inline const WideBVHNode<N>& WideBVH<N>::getNode(unsigned int i) const
+//--------------------------------------------------------------------
+{
+    return m_node_set[i];
+}
+
+
+//-----------------------------------------------------------
+template<unsigned int N>
+inline size_t WideBVH<N>::getNumberOfPrimitiveIndices() const
+//-----------------------------------------------------------
+{
+    return m_primitive_index_set.size();
+}
+
+
+//---------------------------------------------------------------------
+template<unsigned int N>
+inline unsigned int WideBVH<N>::getPrimitiveIndex(unsigned int i) const
+//---------------------------------------------------------------------
+{
+    return m_primitive_index_set[i];
+}
+
+
+//----------------------------------------------------------------------------
+template<unsigned int N>
+unsigned int WideBVH<N>::collapse(const BVH& aBVH, unsigned int aBinaryNodeId)
+//----------------------------------------------------------------------------
+{
+    // Gather up to N binary nodes below aBinaryNodeId: repeatedly replace
+    // the internal node with the largest surface area by its two children
+    unsigned int child_set[N];
+    unsigned int child_count = 0;
+
+    const BVHNode& binary_node = aBVH.getNode(aBinaryNodeId);
+    if (binary_node.isLeaf())
+    {
+        child_set[child_count++] = aBinaryNodeId;
+    }
+    else
+    {
+        child_set[child_count++] = binary_node.m_first;
+        child_set[child_count++] = binary_node.m_first + 1;
+
+        while (child_count < N)
+        {
+            int best_child = -1;
+            float best_area = -1.0;
+
+            for (unsigned int i = 0; i < child_count; ++i)
+            {
+                const BVHNode& child = aBVH.getNode(child_set[i]);
+
+                if (!child.isLeaf())
+                {
+                    Vec3 range = child.m_upper_bbox_corner - child.m_lower_bbox_corner;
+                    float area = range.getX() * range.getY() +
+                            range.getY() * range.getZ() +
+                            range.getZ() * range.getX();
+
+                    if (best_area < area)
+                    {
+                        best_area = area;
+                        best_child = i;
+                    }
+                }
+            }
+
+            // All the children are leaves
+            if (best_child < 0)
+            {
+                break;
+            }
+
+            unsigned int first = aBVH.getNode(child_set[best_child]).m_first;
+            child_set[best_child] = first;
+            child_set[child_count++] = first + 1;
+        }
+    }
+
+    // Create the node. The children are created recursively after it,
+    // so it must be accessed by index as m_node_set may be reallocated
+    unsigned int node_id = m_node_set.size();
+    m_node_set.push_back(WideBVHNode<N>());
+
+    float inf = std::numeric_limits<float>::infinity();
+    for (unsigned int i = 0; i < N; ++i)
+    {
+        WideBVHNode<N>& node = m_node_set[node_id];
+
+        // Empty slot, its inverted box is never hit
+        if (i >= child_count)
+        {
+            node.m_bbox[0][i] = node.m_bbox[1][i] = node.m_bbox[2][i] =  inf;
+            node.m_bbox[3][i] = node.m_bbox[4][i] = node.m_bbox[5][i] = -inf;
+            node.m_child[i] = 0;
+            node.m_primitive_count[i] = 0;
+        }
+        else
+        {
+            const BVHNode& child = aBVH.getNode(child_set[i]);
+
+            node.m_bbox[0][i] = child.m_lower_bbox_corner.getX();
+            node.m_bbox[1][i] = child.m_lower_bbox_corner.getY();
+            node.m_bbox[2][i] = child.m_lower_bbox_corner.getZ();
+            node.m_bbox[3][i] = child.m_upper_bbox_corner.getX();
+            node.m_bbox[4][i] = child.m_upper_bbox_corner.getY();
+            node.m_bbox[5][i] = child.m_upper_bbox_corner.getZ();
+            node.m_primitive_count[i] = child.m_primitive_count;
+
+            if (child.isLeaf())
+            {
+                node.m_child[i] = child.m_first;
+            }
+            else
+            {
+                unsigned int child_id = collapse(aBVH, child_set[i]);
+                m_node_set[node_id].m_child[i] = child_id;
+            }
+        }
+    }
+
+    return node_id;
+}
+
+
+//----------------------------------------------------------------------------
+template<unsigned int N>
+inline unsigned int WideBVH<N>::intersectChildren(const WideBVHNode<N>& aNode,
+                                                  const Ray& aRay,
+                                                  float aTNear[N])
+//----------------------------------------------------------------------------
+{
+    // Same slab test as Ray::intersect, one child at a time
+    const Vec3& origin = aRay.getOrigin();
+    const Vec3& inverse_direction = aRay.getInverseDirection();
+
+    unsigned int near_x = aRay.getDirectionSign(0) * 3;
+    unsigned int near_y = aRay.getDirectionSign(1) * 3 + 1;
+    unsigned int near_z = aRay.getDirectionSign(2) * 3 + 2;
+
+    unsigned int hit_mask = 0;
+    for (unsigned int i = 0; i < N; ++i)
+    {
+        float tx_near = (aNode.m_bbox[near_x    ][i] - origin.getX()) * inverse_direction.getX();
+        float tx_far  = (aNode.m_bbox[3 - near_x][i] - origin.getX()) * inverse_direction.getX();
+        float ty_near = (aNode.m_bbox[near_y    ][i] - origin.getY()) * inverse_direction.getY();
+        float ty_far  = (aNode.m_bbox[5 - near_y][i] - origin.getY()) * inverse_direction.getY();
+        float tz_near = (aNode.m_bbox[near_z    ][i] - origin.getZ()) * inverse_direction.getZ();
+        float tz_far  = (aNode.m_bbox[7 - near_z][i] - origin.getZ()) * inverse_direction.getZ();
+
+        float t_near = std::max(std::max(std::max(tx_near, ty_near), tz_near), aRay.getTMin());
+        float t_far  = std::min(std::min(std::min(tx_far,  ty_far),  tz_far),  aRay.getTMax());
+
+        aTNear[i] = t_near;
+        if (t_near <= t_far)
+        {
+            hit_mask |= 1 << i;
+        }
+    }
+
+    return hit_mask;
+}
+
+
+#ifdef __SSE2__
+//----------------------------------------------------------------------------
+template<>
+inline unsigned int WideBVH<4>::intersectChildren(const WideBVHNode<4>& aNode,
+                                                  const Ray& aRay,
+                                                  float aTNear[4])
+//----------------------------------------------------------------------------
+{
+    const Vec3& origin = aRay.getOrigin();
+    const Vec3& inverse_direction = aRay.getInverseDirection();
+
+    unsigned int near_x = aRay.getDirectionSign(0) * 3;
+    unsigned int near_y = aRay.getDirectionSign(1) * 3 + 1;
+    unsigned int near_z = aRay.getDirectionSign(2) * 3 + 2;
+
+    __m128 origin_x = _mm_set1_ps(origin.getX());
+    __m128 origin_y = _mm_set1_ps(origin.getY());
+    __m128 origin_z = _mm_set1_ps(origin.getZ());
+
+    __m128 inverse_direction_x = _mm_set1_ps(inverse_direction.getX());
+    __m128 inverse_direction_y = _mm_set1_ps(inverse_direction.getY());
+    __m128 inverse_direction_z = _mm_set1_ps(inverse_direction.getZ());
+
+    __m128 tx_near = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(aNode.m_bbox[near_x    ]), origin_x), inverse_direction_x);
+    __m128 tx_far  = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(aNode.m_bbox[3 - near_x]), origin_x), inverse_direction_x);
+    __m128 ty_near = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(aNode.m_bbox[near_y    ]), origin_y), inverse_direction_y);
+    __m128 ty_far  = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(aNode.m_bbox[5 - near_y]), origin_y), inverse_direction_y);
+    __m128 tz_near = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(aNode.m_bbox[near_z    ]), origin_z), inverse_direction_z);
+    __m128 tz_far  = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(aNode.m_bbox[7 - near_z]), origin_z), inverse_direction_z);
+
+    __m128 t_near = _mm_max_ps(_mm_max_ps(tx_near, ty_near), _mm_max_ps(tz_near, _mm_set1_ps(aRay.getTMin())));
+    __m128 t_far  = _mm_min_ps(_mm_min_ps(tx_far,  ty_far),  _mm_min_ps(tz_far,  _mm_set1_ps(aRay.getTMax())));
+
+    _mm_storeu_ps(aTNear, t_near);
+    return _mm_movemask_ps(_mm_cmple_ps(t_near, t_far));
+}
+#endif
+
+
+#ifdef __AVX__
+//----------------------------------------------------------------------------
+template<>
+inline unsigned int WideBVH<8>::intersectChildren(const WideBVHNode<8>& aNode,
+                                                  const Ray& aRay,
+                                                  float aTNear[8])
+//----------------------------------------------------------------------------
+{
+    const Vec3& origin = aRay.getOrigin();
+    const Vec3& inverse_direction = aRay.getInverseDirection();
+
+    unsigned int near_x = aRay.getDirectionSign(0) * 3;
+    unsigned int near_y = aRay.getDirectionSign(1) * 3 + 1;
+    unsigned int near_z = aRay.getDirectionSign(2) * 3 + 2;
+
+    __m256 origin_x = _mm256_set1_ps(origin.getX());
+    __m256 origin_y = _mm256_set1_ps(origin.getY());
+    __m256 origin_z = _mm256_set1_ps(origin.getZ());
+
+    __m256 inverse_direction_x = _mm256_set1_ps(inverse_direction.getX());
+    __m256 inverse_direction_y = _mm256_set1_ps(inverse_direction.getY());
+    __m256 inverse_direction_z = _mm256_set1_ps(inverse_direction.getZ());
+
+    __m256 tx_near = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(aNode.m_bbox[near_x    ]), origin_x), inverse_direction_x);
+    __m256 tx_far  = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(aNode.m_bbox[3 - near_x]), origin_x), inverse_direction_x);
+    __m256 ty_near = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(aNode.m_bbox[near_y    ]), origin_y), inverse_direction_y);
+    __m256 ty_far  = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(aNode.m_bbox[5 - near_y]), origin_y), inverse_direction_y);
+    __m256 tz_near = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(aNode.m_bbox[near_z    ]), origin_z), inverse_direction_z);
+    __m256 tz_far  = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(aNode.m_bbox[7 - near_z]), origin_z), inverse_direction_z);
+
+    __m256 t_near = _mm256_max_ps(_mm256_max_ps(tx_near, ty_near), _mm256_max_ps(tz_near, _mm256_set1_ps(aRay.getTMin())));
+    __m256 t_far  = _mm256_min_ps(_mm256_min_ps(tx_far,  ty_far),  _mm256_min_ps(tz_far,  _mm256_set1_ps(aRay.getTMax())));
+
+    _mm256_storeu_ps(aTNear, t_near);
+    return _mm256_movemask_ps(_mm256_cmp_ps(t_near, t_far, _CMP_LE_OQ));
+}
+#endif
+
+
+//-------------------------------------------------------------------
+template<unsigned int N>
+template<typename PrimitiveIntersector>
+bool WideBVH<N>::intersect(const Ray& aRay,
+                           const PrimitiveIntersector& anIntersector,
+                           float& t,
+                           unsigned int& aPrimitiveId) const
+//-------------------------------------------------------------------
+{
+    if (m_node_set.empty())
+    {
+        return false;
+    }
+
+    // The interval of the ray shrinks as closer intersections are found
+    Ray ray(aRay);
+    bool has_hit = false;
+
+    // Each node pushes at most N children. The entry distance of the ray
+    // in a child is stored along with it, so that the child is skipped if a
+    // closer intersection is found before it is popped
+    unsigned int stack[MAX_STACK_SIZE];
+    float stack_t_near[MAX_STACK_SIZE];
+    unsigned int stack_size = 0;
+    stack[stack_size] = 0;
+    stack_t_near[stack_size++] = ray.getTMin();
+
+    while (stack_size)
+    {
+        --stack_size;
+        if (stack_t_near[stack_size] > ray.getTMax())
+        {
+            continue;
+        }
+
+        const WideBVHNode<N>& node = m_node_set[stack[stack_size]];
+
+        // Test all the children at once
+        float t_near[N];
+        unsigned int hit_mask = intersectChildren(node, ray, t_near);
+        unsigned int first_pushed = stack_size;
+
+        for (unsigned int i = 0; hit_mask; ++i, hit_mask >>= 1)
+        {
+            if (hit_mask & 1)
+            {
+                // Test the primitives of the leaf straight away
+                if (node.m_primitive_count[i])
+                {
+                    unsigned int first = node.m_child[i];
+                    for (unsigned int j = first; j < first + node.m_primitive_count[i]; ++j)
+                    {
+                        unsigned int primitive_id = m_primitive_index_set[j];
+
+                        float primitive_t;
+                        if (anIntersector(ray, primitive_id, primitive_t))
+                        {
+                            ray.setTMax(primitive_t);
+                            aPrimitiveId = primitive_id;
+                            has_hit = true;
+                        }
+                    }
+                }
+                // Visit the internal node later. The children are sorted
+                // by decreasing distance on the stack (insertion sort, there
+                // are only a few), so that the nearest one is popped first
+                else
+                {
+                    unsigned int j = stack_size++;
+                    while (j > first_pushed && stack_t_near[j - 1] < t_near[i])
+                    {
+                        stack[j] = stack[j - 1];
+                        stack_t_near[j] = stack_t_near[j - 1];
+                        --j;
+                    }
+
+                    stack[j] = node.m_child[i];
+                    stack_t_near[j] = t_near[i];
+                }
+            }
+        }
+    }
+
+    if (has_hit)
+    {
+        t = ray.getTMax();
+    }
+
+    return has_hit;
+}
+
+
+//------------------------------------------------------------------
+template<unsigned int N>
+template<typename PrimitiveOccluder>
+bool WideBVH<N>::occluded(const Ray& aRay,
+                          const PrimitiveOccluder& anOccluder) const
+//------------------------------------------------------------------
+{
+    if (m_node_set.empty())
+    {
+        return false;
+    }
+
+    unsigned int stack[MAX_STACK_SIZE];
+    unsigned int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size)
+    {
+        const WideBVHNode<N>& node = m_node_set[stack[--stack_size]];
+
+        float t_near[N];
+        unsigned int hit_mask = intersectChildren(node, aRay, t_near);
+
+        for (unsigned int i = 0; hit_mask; ++i, hit_mask >>= 1)
+        {
+            if (hit_mask & 1)
+            {
+                if (node.m_primitive_count[i])
+                {
+                    unsigned int first = node.m_child[i];
+                    for (unsigned int j = first; j < first + node.m_primitive_count[i]; ++j)
+                    {
+                        // Any intersection will do
+                        if (anOccluder(aRay, m_primitive_index_set[j]))
+                        {
+                            return true;
+                        }
+                    }
+                }
+                else
+                {
+                    stack[stack_size++] = node.m_child[i];
+                }
+            }
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,1780 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       BVH.cxx
+*
+*   @brief      Class to manipulate a bounding volume hierarchy (BVH).
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <limits>    // for inf
+#include <algorithm> // for min/max/partition
+#include <stdexcept> // for exceptions
+#include <chrono>    // for the build time
+#include <atomic>    // for the bottom-up pass of the LBVH build
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifndef __BVH_h
+#include "BVH.h"
+#endif
+
+
+//******************************************************************************
+//  Type declarations
+//******************************************************************************
+
+/// A reference to a primitive in the SBVH build: a primitive split by
+/// spatial splits has one reference per part, each with its own bbox
+struct BVHReference
+{
+    Vec3 m_lower_bbox_corner;
+    Vec3 m_upper_bbox_corner;
+    unsigned int m_primitive_id;
+};
+
+
+/// A node of the SBVH that still needs to be split, with its references
+struct SBVHTask
+{
+    unsigned int m_node_id;
+    std::vector<BVHReference> m_reference_set;
+};
+
+
+//******************************************************************************
+//  Constant global variables
+//******************************************************************************
+const float g_traversal_cost = 1.0;
+const float g_intersection_cost = 1.0;
+
+/// Spatial splits are only tried if the children of the best object split
+/// overlap more than this fraction of the root's surface area
+/// (see Stich et al., "Spatial Splits in Bounding Volume Hierarchies", 2009)
+const float g_sbvh_overlap_threshold = 1.0e-5;
+
+/// Maximum number of references in the SBVH, relative to the number of
+/// primitives
+const float g_sbvh_reference_budget = 2.0;
+
+
+//******************************************************************************
+//  Function declarations
+//******************************************************************************
+float getSurfaceArea(const Vec3& aLowerBBoxCorner, const Vec3& anUpperBBoxCorner);
+
+void growBBox(Vec3& aLowerBBoxCorner, Vec3& anUpperBBoxCorner,
+              const Vec3& aLowerCorner, const Vec3& anUpperCorner);
+
+bool clipTriangle(const Triangle& aTriangle,
+                  unsigned int anAxis, float aMinPosition, float aMaxPosition,
+                  const BVHReference& aReference,
+                  Vec3& aLowerBBoxCorner, Vec3& anUpperBBoxCorner);
+
+unsigned int expandBits(unsigned int aValue);
+
+unsigned int getMortonCode(const Vec3& aPoint);
+
+int countLeadingZeros(unsigned int aValue);
+
+int getCommonPrefixLength(const std::vector<unsigned int>& aMortonCodeSet,
+                          int i, int j);
+
+void radixSort(std::vector<unsigned int>& aKeySet,
+               std::vector<unsigned int>& aValueSet);
+
+
+//******************************************************************************
+//  Function definitions
+//******************************************************************************
+
+
+//-------------------------------------------------
+float getSurfaceArea(const Vec3& aLowerBBoxCorner,
+                     const Vec3& anUpperBBoxCorner)
+//-------------------------------------------------
+{
+    Vec3 range = anUpperBBoxCorner - aLowerBBoxCorner;
+
+    // The box is empty
+    if (range.getX() < 0 || range.getY() < 0 || range.getZ() < 0)
+    {
+        return 0.0;
+    }
+
+    return 2.0 * (range.getX() * range.getY() +
+                  range.getY() * range.getZ() +
+                  range.getZ() * range.getX());
+}
+
+
+//----------------------------------------------------------------
+void growBBox(Vec3& aLowerBBoxCorner, Vec3& anUpperBBoxCorner,
+              const Vec3& aLowerCorner, const Vec3& anUpperCorner)
+//----------------------------------------------------------------
+{
+    aLowerBBoxCorner.setX(std::min(aLowerBBoxCorner.getX(), aLowerCorner.getX()));
+    aLowerBBoxCorner.setY(std::min(aLowerBBoxCorner.getY(), aLowerCorner.getY()));
+    aLowerBBoxCorner.setZ(std::min(aLowerBBoxCorner.getZ(), aLowerCorner.getZ()));
+
+    anUpperBBoxCorner.setX(std::max(anUpperBBoxCorner.getX(), anUpperCorner.getX()));
+    anUpperBBoxCorner.setY(std::max(anUpperBBoxCorner.getY(), anUpperCorner.getY()));
+    anUpperBBoxCorner.setZ(std::max(anUpperBBoxCorner.getZ(), anUpperCorner.getZ()));
+}
+
+
+//----------------------------------------------------------------------------
+bool clipTriangle(const Triangle& aTriangle,
+                  unsigned int anAxis, float aMinPosition, float aMaxPosition,
+                  const BVHReference& aReference,
+                  Vec3& aLowerBBoxCorner, Vec3& anUpperBBoxCorner)
+//----------------------------------------------------------------------------
+{
+    // Compute the bbox of the part of the triangle between the two planes
+    // orthogonal to anAxis, and clip it by the bbox of the reference
+    float inf = std::numeric_limits<float>::infinity();
+    aLowerBBoxCorner = Vec3( inf,  inf,  inf);
+    anUpperBBoxCorner = Vec3(-inf, -inf, -inf);
+
+    const Vec3* p_vertex_set[3] = {&aTriangle.getP1(), &aTriangle.getP2(), &aTriangle.getP3()};
+    float plane_set[2] = {aMinPosition, aMaxPosition};
+
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        const Vec3& a = *p_vertex_set[i];
+        const Vec3& b = *p_vertex_set[(i + 1) % 3];
+        float a_position = a[anAxis];
+        float b_position = b[anAxis];
+
+        // The vertex is between the planes
+        if (aMinPosition <= a_position && a_position <= aMaxPosition)
+        {
+            growBBox(aLowerBBoxCorner, anUpperBBoxCorner, a, a);
+        }
+
+        // The edge crosses a plane
+        for (unsigned int j = 0; j < 2; ++j)
+        {
+            float plane = plane_set[j];
+            if ((a_position < plane && plane < b_position) ||
+                    (b_position < plane && plane < a_position))
+            {
+                Vec3 point = a + (b - a) * ((plane - a_position) / (b_position - a_position));
+                point[anAxis] = plane;
+                growBBox(aLowerBBoxCorner, anUpperBBoxCorner, point, point);
+            }
+        }
+    }
+
+    aLowerBBoxCorner.setX(std::max(aLowerBBoxCorner.getX(), aReference.m_lower_bbox_corner.getX()));
+    aLowerBBoxCorner.setY(std::max(aLowerBBoxCorner.getY(), aReference.m_lower_bbox_corner.getY()));
+    aLowerBBoxCorner.setZ(std::max(aLowerBBoxCorner.getZ(), aReference.m_lower_bbox_corner.getZ()));
+
+    anUpperBBoxCorner.setX(std::min(anUpperBBoxCorner.getX(), aReference.m_upper_bbox_corner.getX()));
+    anUpperBBoxCorner.setY(std::min(anUpperBBoxCorner.getY(), aReference.m_upper_bbox_corner.getY()));
+    anUpperBBoxCorner.setZ(std::min(anUpperBBoxCorner.getZ(), aReference.m_upper_bbox_corner.getZ()));
+
+    // The clipped part may be empty
+    return aLowerBBoxCorner.getX() <= anUpperBBoxCorner.getX() &&
+            aLowerBBoxCorner.getY() <= anUpperBBoxCorner.getY() &&
+            aLowerBBoxCorner.getZ() <= anUpperBBoxCorner.getZ();
+}
+
+
+//------------------------------------------
+unsigned int expandBits(unsigned int aValue)
+//------------------------------------------
+{
+    // Insert two 0 bits after each of the 10 low bits of aValue
+    aValue = (aValue * 0x00010001u) & 0xFF0000FFu;
+    aValue = (aValue * 0x00000101u) & 0x0F00F00Fu;
+    aValue = (aValue * 0x00000011u) & 0xC30C30C3u;
+    aValue = (aValue * 0x00000005u) & 0x49249249u;
+
+    return aValue;
+}
+
+
+//--------------------------------------------
+unsigned int getMortonCode(const Vec3& aPoint)
+//--------------------------------------------
+{
+    // aPoint is in the unit cube, quantise every coordinate on 10 bits
+    unsigned int x = std::min(std::max(aPoint.getX() * 1024.0f, 0.0f), 1023.0f);
+    unsigned int y = std::min(std::max(aPoint.getY() * 1024.0f, 0.0f), 1023.0f);
+    unsigned int z = std::min(std::max(aPoint.getZ() * 1024.0f, 0.0f), 1023.0f);
+
+    return (expandBits(x) << 2) | (expandBits(y) << 1) | expandBits(z);
+}
+
+
+//----------------------------------------
+int countLeadingZeros(unsigned int aValue)
+//----------------------------------------
+{
+#if defined(__GNUC__)
+    return aValue ? __builtin_clz(aValue) : 32;
+#else
+    int count = 0;
+    for (unsigned int mask = 0x80000000u; mask && !(aValue & mask); mask >>= 1)
+    {
+        ++count;
+    }
+    return count;
+#endif
+}
+
+
+//------------------------------------------------------------------------
+int getCommonPrefixLength(const std::vector<unsigned int>& aMortonCodeSet,
+                          int i, int j)
+//------------------------------------------------------------------------
+{
+    if (j < 0 || j >= int(aMortonCodeSet.size()))
+    {
+        return -1;
+    }
+
+    // Duplicate codes are made unique by appending the index to the code
+    if (aMortonCodeSet[i] == aMortonCodeSet[j])
+    {
+        return 32 + countLeadingZeros(i ^ j);
+    }
+
+    return countLeadingZeros(aMortonCodeSet[i] ^ aMortonCodeSet[j]);
+}
+
+
+//--------------------------------------------------
+void radixSort(std::vector<unsigned int>& aKeySet,
+               std::vector<unsigned int>& aValueSet)
+//--------------------------------------------------
+{
+    // Parallel least-significant-digit radix sort, 8 bits per pass.
+    // Every thread sorts a contiguous chunk, which keeps the sort stable.
+    const unsigned int number_of_buckets = 256;
+    int size = aKeySet.size();
+
+    std::vector<unsigned int> temp_key_set(size);
+    std::vector<unsigned int> temp_value_set(size);
+
+#ifdef _OPENMP
+    int max_number_of_threads = omp_get_max_threads();
+#else
+    int max_number_of_threads = 1;
+#endif
+
+    std::vector<unsigned int> histogram_set(max_number_of_threads * number_of_buckets);
+
+    for (unsigned int shift = 0; shift < 32; shift += 8)
+    {
+        #pragma omp parallel num_threads(max_number_of_threads)
+        {
+#ifdef _OPENMP
+            int number_of_threads = omp_get_num_threads();
+            int thread_id = omp_get_thread_num();
+#else
+            int number_of_threads = 1;
+            int thread_id = 0;
+#endif
+            int first = (long(size) * thread_id) / number_of_threads;
+            int last = (long(size) * (thread_id + 1)) / number_of_threads;
+
+            unsigned int* p_histogram = &histogram_set[thread_id * number_of_buckets];
+            std::fill(p_histogram, p_histogram + number_of_buckets, 0);
+
+            // Count the digits of the chunk
+            for (int i = first; i < last; ++i)
+            {
+                ++p_histogram[(aKeySet[i] >> shift) & 0xFF];
+            }
+
+            #pragma omp barrier
+
+            // Turn the counts into offsets (bucket first, then thread)
+            #pragma omp single
+            {
+                unsigned int offset = 0;
+                for (unsigned int bucket = 0; bucket < number_of_buckets; ++bucket)
+                {
+                    for (int thread = 0; thread < number_of_threads; ++thread)
+                    {
+                        unsigned int count = histogram_set[thread * number_of_buckets + bucket];
+                        histogram_set[thread * number_of_buckets + bucket] = offset;
+                        offset += count;
+                    }
+                }
+            }
+
+            // Scatter the chunk
+            for (int i = first; i < last; ++i)
+            {
+                unsigned int index = p_histogram[(aKeySet[i] >> shift) & 0xFF]++;
+                temp_key_set[index] = aKeySet[i];
+                temp_value_set[index] = aValueSet[i];
+            }
+        }
+
+        aKeySet.swap(temp_key_set);
+        aValueSet.swap(temp_value_set);
+    }
+}
+
+
+//******************************************************************************
+//  Static member definitions
+//******************************************************************************
+const unsigned int BVH::NO_PRIMITIVE;
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//------------------------------------------------------------
+void BVH::build(const std::vector<Vec3>& aLowerBBoxCornerSet,
+                const std::vector<Vec3>& anUpperBBoxCornerSet,
+                BuildMethod aBuildMethod)
+//------------------------------------------------------------
+{
+    if (aLowerBBoxCornerSet.size() != anUpperBBoxCornerSet.size())
+    {
+        throw std::length_error("buffer size error");
+    }
+
+    float inf = std::numeric_limits<float>::infinity();
+    Vec3 lower_bbox_corner( inf,  inf,  inf);
+    Vec3 upper_bbox_corner(-inf, -inf, -inf);
+
+    for (unsigned int i = 0; i < aLowerBBoxCornerSet.size(); ++i)
+    {
+        growBBox(lower_bbox_corner, upper_bbox_corner,
+                 aLowerBBoxCornerSet[i], anUpperBBoxCornerSet[i]);
+    }
+
+    build(aLowerBBoxCornerSet, anUpperBBoxCornerSet,
+          lower_bbox_corner, upper_bbox_corner,
+          aBuildMethod);
+}
+
+
+//------------------------------------------------------------
+void BVH::build(const std::vector<Vec3>& aLowerBBoxCornerSet,
+                const std::vector<Vec3>& anUpperBBoxCornerSet,
+                const Vec3& aLowerBBoxCorner,
+                const Vec3& anUpperBBoxCorner,
+                BuildMethod aBuildMethod)
+//------------------------------------------------------------
+{
+    if (aLowerBBoxCornerSet.size() != anUpperBBoxCornerSet.size())
+    {
+        throw std::length_error("buffer size error");
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    clear();
+    m_build_method = aBuildMethod;
+
+    if (aLowerBBoxCornerSet.size())
+    {
+        switch (aBuildMethod)
+        {
+        case SAH:
+            buildSAH(aLowerBBoxCornerSet, anUpperBBoxCornerSet);
+            break;
+
+        case LBVH:
+            buildLBVH(aLowerBBoxCornerSet, anUpperBBoxCornerSet,
+                      aLowerBBoxCorner, anUpperBBoxCorner);
+            break;
+
+        case SBVH:
+            throw std::invalid_argument("The SBVH build needs the triangles");
+
+        default:
+            throw std::invalid_argument("Unknown BVH build method");
+        }
+    }
+
+    m_build_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+//------------------------------------------------------------
+void BVH::build(const std::vector<Triangle>& aTriangleSet,
+                const std::vector<Vec3>& aLowerBBoxCornerSet,
+                const std::vector<Vec3>& anUpperBBoxCornerSet,
+                const Vec3& aLowerBBoxCorner,
+                const Vec3& anUpperBBoxCorner,
+                BuildMethod aBuildMethod)
+//------------------------------------------------------------
+{
+    // Only the SBVH build needs more than the bboxes
+    if (aBuildMethod != SBVH)
+    {
+        build(aLowerBBoxCornerSet, anUpperBBoxCornerSet,
+              aLowerBBoxCorner, anUpperBBoxCorner,
+              aBuildMethod);
+        return;
+    }
+
+    if (aTriangleSet.size() != aLowerBBoxCornerSet.size() ||
+            aLowerBBoxCornerSet.size() != anUpperBBoxCornerSet.size())
+    {
+        throw std::length_error("buffer size error");
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    clear();
+    m_build_method = aBuildMethod;
+
+    if (aTriangleSet.size())
+    {
+        buildSBVH(aTriangleSet, aLowerBBoxCornerSet, anUpperBBoxCornerSet);
+    }
+
+    m_build_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+//------------------------------------------------------------
+void BVH::refit(const std::vector<Vec3>& aLowerBBoxCornerSet,
+                const std::vector<Vec3>& anUpperBBoxCornerSet)
+//------------------------------------------------------------
+{
+    if (aLowerBBoxCornerSet.size() != anUpperBBoxCornerSet.size())
+    {
+        throw std::length_error("buffer size error");
+    }
+
+    if (m_node_set.empty())
+    {
+        return;
+    }
+
+    for (unsigned int i = 0; i < m_primitive_index_set.size(); ++i)
+    {
+        if (m_primitive_index_set[i] >= aLowerBBoxCornerSet.size())
+        {
+            throw std::out_of_range("The BVH does not match the primitives");
+        }
+    }
+
+    // Find the parent of every node. The leaves of an SBVH get the bbox of
+    // their whole primitives, which is conservative but loses the clipping.
+    int number_of_nodes = m_node_set.size();
+    std::vector<unsigned int> parent_set(number_of_nodes, 0);
+    std::vector<unsigned int> leaf_set;
+
+    for (int node_id = 0; node_id < number_of_nodes; ++node_id)
+    {
+        const BVHNode& node = m_node_set[node_id];
+
+        if (node.isLeaf())
+        {
+            leaf_set.push_back(node_id);
+        }
+        else
+        {
+            parent_set[node.m_first] = node_id;
+            parent_set[node.m_first + 1] = node_id;
+        }
+    }
+
+    // Refit the leaves, then their ancestors bottom-up as in the LBVH build.
+    // The second thread to reach an internal node processes it.
+    std::vector<std::atomic<int> > visit_count_set(number_of_nodes);
+    for (unsigned int i = 0; i < visit_count_set.size(); ++i)
+    {
+        visit_count_set[i] = 0;
+    }
+
+    int number_of_leaves = leaf_set.size();
+    float inf = std::numeric_limits<float>::infinity();
+
+    #pragma omp parallel for
+    for (int i = 0; i < number_of_leaves; ++i)
+    {
+        unsigned int node_id = leaf_set[i];
+
+        BVHNode& leaf = m_node_set[node_id];
+        leaf.m_lower_bbox_corner = Vec3( inf,  inf,  inf);
+        leaf.m_upper_bbox_corner = Vec3(-inf, -inf, -inf);
+
+        for (unsigned int j = leaf.m_first; j < leaf.m_first + leaf.m_primitive_count; ++j)
+        {
+            unsigned int primitive_id = m_primitive_index_set[j];
+            growBBox(leaf.m_lower_bbox_corner, leaf.m_upper_bbox_corner,
+                     aLowerBBoxCornerSet[primitive_id], anUpperBBoxCornerSet[primitive_id]);
+        }
+
+        while (node_id)
+        {
+            node_id = parent_set[node_id];
+
+            // The sibling is not ready yet
+            if (visit_count_set[node_id].fetch_add(1) == 0)
+            {
+                break;
+            }
+
+            BVHNode& node = m_node_set[node_id];
+            const BVHNode& left_child = m_node_set[node.m_first];
+            const BVHNode& right_child = m_node_set[node.m_first + 1];
+
+            node.m_lower_bbox_corner = left_child.m_lower_bbox_corner;
+            node.m_upper_bbox_corner = left_child.m_upper_bbox_corner;
+            growBBox(node.m_lower_bbox_corner, node.m_upper_bbox_corner,
+                     right_child.m_lower_bbox_corner, right_child.m_upper_bbox_corner);
+        }
+    }
+}
+
+
+//---------------------------
+float BVH::getSAHCost() const
+//---------------------------
+{
+    if (m_node_set.empty())
+    {
+        return 0.0;
+    }
+
+    float root_area = getSurfaceArea(m_node_set[0].m_lower_bbox_corner,
+                                     m_node_set[0].m_upper_bbox_corner);
+
+    // A flat root (e.g. a single quad) is never tested before its primitives
+    if (root_area <= 0.0)
+    {
+        return g_traversal_cost + g_intersection_cost * m_primitive_index_set.size();
+    }
+
+    // Expected cost of a random ray hitting the root
+    float cost = 0.0;
+    for (std::vector<BVHNode>::const_iterator ite = m_node_set.begin();
+            ite != m_node_set.end();
+            ++ite)
+    {
+        float area = getSurfaceArea(ite->m_lower_bbox_corner, ite->m_upper_bbox_corner);
+
+        if (ite->isLeaf())
+        {
+            cost += g_intersection_cost * ite->m_primitive_count * area / root_area;
+        }
+        else
+        {
+            cost += g_traversal_cost * area / root_area;
+        }
+    }
+
+    return cost;
+}
+
+
+//--------------------------------------
+BVHStatistics BVH::getStatistics() const
+//--------------------------------------
+{
+    BVHStatistics statistics;
+    statistics.m_sah_cost = getSAHCost();
+    statistics.m_number_of_nodes = m_node_set.size();
+    statistics.m_number_of_leaves = 0;
+
+    if (m_node_set.empty())
+    {
+        return statistics;
+    }
+
+    // Depth-first traversal of the whole tree, with the depth of the nodes
+    std::vector<std::pair<unsigned int, unsigned int> > stack;
+    stack.push_back(std::make_pair(0, 0));
+
+    while (!stack.empty())
+    {
+        unsigned int node_id = stack.back().first;
+        unsigned int depth = stack.back().second;
+        stack.pop_back();
+
+        const BVHNode& node = m_node_set[node_id];
+
+        if (node.isLeaf())
+        {
+            ++statistics.m_number_of_leaves;
+
+            if (statistics.m_depth_histogram.size() <= depth)
+            {
+                statistics.m_depth_histogram.resize(depth + 1, 0);
+            }
+            ++statistics.m_depth_histogram[depth];
+
+            if (statistics.m_leaf_size_histogram.size() <= node.m_primitive_count)
+            {
+                statistics.m_leaf_size_histogram.resize(node.m_primitive_count + 1, 0);
+            }
+            ++statistics.m_leaf_size_histogram[node.m_primitive_count];
+        }
+        else
+        {
+            stack.push_back(std::make_pair(node.m_first, depth + 1));
+            stack.push_back(std::make_pair(node.m_first + 1, depth + 1));
+        }
+    }
+
+    return statistics;
+}
+
+
+//-------------------------------------------------
+void BVH::restructure(unsigned int aNumberOfPasses)
+//-------------------------------------------------
+{
+    if (m_node_set.empty())
+    {
+        return;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // SAH cost of the subtree of each node, not normalised by the root's area
+    std::vector<float> subtree_cost_set(m_node_set.size());
+
+    for (unsigned int pass = 0; pass < aNumberOfPasses; ++pass)
+    {
+        restructureSubtree(0, subtree_cost_set);
+    }
+
+    // The restructuring is part of the build
+    m_build_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+//--------------------------------------------------------------------------------
+void BVH::groupPrimitivesIntoBlocks(unsigned int aBlockSize,
+                                    std::vector<unsigned int>& aBlockPrimitiveSet)
+//--------------------------------------------------------------------------------
+{
+    aBlockPrimitiveSet.clear();
+
+    if (m_node_set.empty())
+    {
+        return;
+    }
+
+    // Number of primitive references in the subtree of each node
+    std::vector<unsigned int> primitive_count_set(m_node_set.size());
+    countPrimitives(0, primitive_count_set);
+
+    std::vector<BVHNode> node_set(1);
+    std::vector<unsigned int> block_index_set;
+    std::vector<unsigned int> primitive_set;
+
+    // Top-down, with the ID of each node in the new tree. The left child is
+    // popped first, so that the blocks follow the order of the leaves
+    std::vector<std::pair<unsigned int, unsigned int> > stack;
+    stack.push_back(std::make_pair(0, 0));
+
+    while (!stack.empty())
+    {
+        unsigned int node_id = stack.back().first;
+        unsigned int new_node_id = stack.back().second;
+        stack.pop_back();
+
+        const BVHNode& node = m_node_set[node_id];
+        node_set[new_node_id].m_lower_bbox_corner = node.m_lower_bbox_corner;
+        node_set[new_node_id].m_upper_bbox_corner = node.m_upper_bbox_corner;
+
+        // The whole subtree becomes a leaf
+        if (node.isLeaf() || primitive_count_set[node_id] <= aBlockSize)
+        {
+            primitive_set.clear();
+            gatherPrimitives(node_id, primitive_set);
+
+            unsigned int number_of_blocks = (primitive_set.size() + aBlockSize - 1) / aBlockSize;
+            node_set[new_node_id].m_first = block_index_set.size();
+            node_set[new_node_id].m_primitive_count = number_of_blocks;
+
+            for (unsigned int i = 0; i < number_of_blocks * aBlockSize; ++i)
+            {
+                if (i % aBlockSize == 0)
+                {
+                    block_index_set.push_back(aBlockPrimitiveSet.size() / aBlockSize);
+                }
+
+                aBlockPrimitiveSet.push_back(i < primitive_set.size() ? primitive_set[i] : NO_PRIMITIVE);
+            }
+        }
+        else
+        {
+            unsigned int first = node_set.size();
+            node_set[new_node_id].m_first = first;
+            node_set[new_node_id].m_primitive_count = 0;
+            node_set.resize(first + 2);
+
+            stack.push_back(std::make_pair(node.m_first + 1, first + 1));
+            stack.push_back(std::make_pair(node.m_first, first));
+        }
+    }
+
+    m_node_set.swap(node_set);
+    m_primitive_index_set.swap(block_index_set);
+}
+
+
+//---------------------------------------------------------------
+void BVH::restructureSubtree(unsigned int aNodeId,
+                             std::vector<float>& aSubtreeCostSet)
+//---------------------------------------------------------------
+{
+    const BVHNode& node = m_node_set[aNodeId];
+    float area = getSurfaceArea(node.m_lower_bbox_corner, node.m_upper_bbox_corner);
+
+    if (node.isLeaf())
+    {
+        aSubtreeCostSet[aNodeId] = g_intersection_cost * node.m_primitive_count * area;
+        return;
+    }
+
+    // Bottom-up, the treelets below are restructured first
+    unsigned int first = node.m_first;
+    restructureSubtree(first, aSubtreeCostSet);
+    restructureSubtree(first + 1, aSubtreeCostSet);
+
+    aSubtreeCostSet[aNodeId] = g_traversal_cost * area +
+            aSubtreeCostSet[first] + aSubtreeCostSet[first + 1];
+
+    restructureTreelet(aNodeId, aSubtreeCostSet);
+}
+
+
+//---------------------------------------------------------------
+void BVH::restructureTreelet(unsigned int aRootId,
+                             std::vector<float>& aSubtreeCostSet)
+//---------------------------------------------------------------
+{
+    // Form the treelet: repeatedly replace its leaf with the largest
+    // surface area by the two children of that node. Every internal node
+    // of the treelet owns a pair of consecutive nodes for its children,
+    // the pairs are reused for the new topology
+    unsigned int leaf_set[TREELET_SIZE];
+    unsigned int pair_set[TREELET_SIZE - 1];
+    unsigned int leaf_count = 0;
+    unsigned int pair_count = 0;
+
+    pair_set[pair_count++] = m_node_set[aRootId].m_first;
+    leaf_set[leaf_count++] = m_node_set[aRootId].m_first;
+    leaf_set[leaf_count++] = m_node_set[aRootId].m_first + 1;
+
+    while (leaf_count < TREELET_SIZE)
+    {
+        int best_leaf = -1;
+        float best_area = -1.0;
+
+        for (unsigned int i = 0; i < leaf_count; ++i)
+        {
+            const BVHNode& node = m_node_set[leaf_set[i]];
+
+            if (!node.isLeaf())
+            {
+                float area = getSurfaceArea(node.m_lower_bbox_corner, node.m_upper_bbox_corner);
+
+                if (best_area < area)
+                {
+                    best_area = area;
+                    best_leaf = i;
+                }
+            }
+        }
+
+        // All the leaves of the treelet are leaves of the BVH
+        if (best_leaf < 0)
+        {
+            break;
+        }
+
+        unsigned int first = m_node_set[leaf_set[best_leaf]].m_first;
+        pair_set[pair_count++] = first;
+        leaf_set[best_leaf] = first;
+        leaf_set[leaf_count++] = first + 1;
+    }
+
+    // Two subtrees can only be combined one way
+    if (leaf_count < 3)
+    {
+        return;
+    }
+
+    // Optimal cost of every subset of the treelet's leaves, by increasing
+    // subset: the subsets of a subset are smaller numbers
+    const unsigned int MAX_SUBSETS = 1 << TREELET_SIZE;
+    Vec3 lower_bbox_corner_set[MAX_SUBSETS];
+    Vec3 upper_bbox_corner_set[MAX_SUBSETS];
+    float cost_set[MAX_SUBSETS];
+    unsigned int partition_set[MAX_SUBSETS];
+
+    unsigned int subset_count = 1 << leaf_count;
+    for (unsigned int subset = 1; subset < subset_count; ++subset)
+    {
+        unsigned int lowest_bit = subset & (~subset + 1);
+
+        // A single leaf keeps its own subtree
+        if (subset == lowest_bit)
+        {
+            unsigned int i = 0;
+            while (!(lowest_bit & (1 << i)))
+            {
+                ++i;
+            }
+
+            const BVHNode& node = m_node_set[leaf_set[i]];
+            lower_bbox_corner_set[subset] = node.m_lower_bbox_corner;
+            upper_bbox_corner_set[subset] = node.m_upper_bbox_corner;
+            cost_set[subset] = aSubtreeCostSet[leaf_set[i]];
+            partition_set[subset] = 0;
+            continue;
+        }
+
+        lower_bbox_corner_set[subset] = lower_bbox_corner_set[lowest_bit];
+        upper_bbox_corner_set[subset] = upper_bbox_corner_set[lowest_bit];
+        growBBox(lower_bbox_corner_set[subset], upper_bbox_corner_set[subset],
+                 lower_bbox_corner_set[subset ^ lowest_bit], upper_bbox_corner_set[subset ^ lowest_bit]);
+
+        // Best split into two subsets, each partition is tried once
+        // as the first part holds the lowest bit
+        float best_cost = std::numeric_limits<float>::infinity();
+        unsigned int best_partition = 0;
+        for (unsigned int part = (subset - 1) & subset; part; part = (part - 1) & subset)
+        {
+            if (part & lowest_bit)
+            {
+                float cost = cost_set[part] + cost_set[subset ^ part];
+
+                if (cost < best_cost)
+                {
+                    best_cost = cost;
+                    best_partition = part;
+                }
+            }
+        }
+
+        cost_set[subset] = g_traversal_cost *
+                getSurfaceArea(lower_bbox_corner_set[subset], upper_bbox_corner_set[subset]) +
+                best_cost;
+        partition_set[subset] = best_partition;
+    }
+
+    // Keep the current topology unless it is noticeably worse
+    unsigned int full_set = subset_count - 1;
+    if (cost_set[full_set] >= aSubtreeCostSet[aRootId] * (1.0 - 1.0e-5))
+    {
+        return;
+    }
+
+    // The leaves of the treelet are copied first,
+    // as their nodes are overwritten by the new topology
+    BVHNode leaf_node_set[TREELET_SIZE];
+    for (unsigned int i = 0; i < leaf_count; ++i)
+    {
+        leaf_node_set[i] = m_node_set[leaf_set[i]];
+    }
+
+    // Rebuild the treelet top-down
+    unsigned int stack_node_id[2 * TREELET_SIZE];
+    unsigned int stack_subset[2 * TREELET_SIZE];
+    unsigned int stack_size = 0;
+    unsigned int next_pair = 0;
+
+    stack_node_id[stack_size] = aRootId;
+    stack_subset[stack_size++] = full_set;
+
+    while (stack_size)
+    {
+        --stack_size;
+        unsigned int node_id = stack_node_id[stack_size];
+        unsigned int subset = stack_subset[stack_size];
+
+        aSubtreeCostSet[node_id] = cost_set[subset];
+
+        if (!partition_set[subset])
+        {
+            unsigned int i = 0;
+            while (!(subset & (1 << i)))
+            {
+                ++i;
+            }
+
+            m_node_set[node_id] = leaf_node_set[i];
+        }
+        else
+        {
+            BVHNode& node = m_node_set[node_id];
+            node.m_lower_bbox_corner = lower_bbox_corner_set[subset];
+            node.m_upper_bbox_corner = upper_bbox_corner_set[subset];
+            node.m_first = pair_set[next_pair++];
+            node.m_primitive_count = 0;
+
+            stack_node_id[stack_size] = node.m_first;
+            stack_subset[stack_size++] = partition_set[subset];
+            stack_node_id[stack_size] = node.m_first + 1;
+            stack_subset[stack_size++] = subset ^ partition_set[subset];
+        }
+    }
+}
+
+
+//---------------------------------------------------------------
+void BVH::buildSAH(const std::vector<Vec3>& aLowerBBoxCornerSet,
+                   const std::vector<Vec3>& anUpperBBoxCornerSet)
+//---------------------------------------------------------------
+{
+    float inf = std::numeric_limits<float>::infinity();
+    unsigned int number_of_primitives = aLowerBBoxCornerSet.size();
+
+    // Compute the centroid of every primitive
+    std::vector<Vec3> centroid_set(number_of_primitives);
+    m_primitive_index_set.resize(number_of_primitives);
+    for (unsigned int i = 0; i < number_of_primitives; ++i)
+    {
+        centroid_set[i] = (aLowerBBoxCornerSet[i] + anUpperBBoxCornerSet[i]) * 0.5f;
+        m_primitive_index_set[i] = i;
+    }
+
+    // A binary tree with one primitive per leaf has 2N-1 nodes
+    m_node_set.reserve(2 * number_of_primitives - 1);
+
+    // Create the root
+    BVHNode root;
+    root.m_first = 0;
+    root.m_primitive_count = number_of_primitives;
+    m_node_set.push_back(root);
+
+    // Nodes that still need to be split
+    std::vector<unsigned int> node_stack(1, 0);
+
+    while (!node_stack.empty())
+    {
+        unsigned int node_id = node_stack.back();
+        node_stack.pop_back();
+
+        unsigned int first = m_node_set[node_id].m_first;
+        unsigned int count = m_node_set[node_id].m_primitive_count;
+
+        // Compute the bbox of the node and the bbox of the centroids
+        Vec3 lower_bbox_corner( inf,  inf,  inf);
+        Vec3 upper_bbox_corner(-inf, -inf, -inf);
+        Vec3 lower_centroid( inf,  inf,  inf);
+        Vec3 upper_centroid(-inf, -inf, -inf);
+        for (unsigned int i = first; i < first + count; ++i)
+        {
+            unsigned int primitive_id = m_primitive_index_set[i];
+            growBBox(lower_bbox_corner, upper_bbox_corner,
+                     aLowerBBoxCornerSet[primitive_id], anUpperBBoxCornerSet[primitive_id]);
+            growBBox(lower_centroid, upper_centroid,
+                     centroid_set[primitive_id], centroid_set[primitive_id]);
+        }
+
+        m_node_set[node_id].m_lower_bbox_corner = lower_bbox_corner;
+        m_node_set[node_id].m_upper_bbox_corner = upper_bbox_corner;
+
+        if (count == 1)
+        {
+            continue;
+        }
+
+        // Find the best split plane amongst the bin boundaries of every axis
+        float node_area = getSurfaceArea(lower_bbox_corner, upper_bbox_corner);
+        float best_cost = inf;
+        int best_axis = -1;
+        unsigned int best_bin = 0;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float lower_bound = lower_centroid[axis];
+            float extent = upper_centroid[axis] - lower_bound;
+
+            // All the centroids are on the same plane
+            if (extent <= 0.0)
+            {
+                continue;
+            }
+
+            float scale = NUMBER_OF_BINS / extent;
+
+            // Fill the bins
+            unsigned int bin_count[NUMBER_OF_BINS] = {0};
+            Vec3 bin_lower[NUMBER_OF_BINS];
+            Vec3 bin_upper[NUMBER_OF_BINS];
+            for (unsigned int b = 0; b < NUMBER_OF_BINS; ++b)
+            {
+                bin_lower[b] = Vec3( inf,  inf,  inf);
+                bin_upper[b] = Vec3(-inf, -inf, -inf);
+            }
+
+            for (unsigned int i = first; i < first + count; ++i)
+            {
+                unsigned int primitive_id = m_primitive_index_set[i];
+                unsigned int b = std::min(NUMBER_OF_BINS - 1,
+                        (unsigned int)((centroid_set[primitive_id][axis] - lower_bound) * scale));
+
+                ++bin_count[b];
+                growBBox(bin_lower[b], bin_upper[b],
+                         aLowerBBoxCornerSet[primitive_id], anUpperBBoxCornerSet[primitive_id]);
+            }
+
+            // Sweep from the right to get the area and count of the right-hand side
+            float right_area[NUMBER_OF_BINS];
+            unsigned int right_count[NUMBER_OF_BINS];
+            Vec3 lower( inf,  inf,  inf);
+            Vec3 upper(-inf, -inf, -inf);
+            unsigned int sum = 0;
+            for (unsigned int b = NUMBER_OF_BINS - 1; b > 0; --b)
+            {
+                growBBox(lower, upper, bin_lower[b], bin_upper[b]);
+                sum += bin_count[b];
+                right_area[b] = getSurfaceArea(lower, upper);
+                right_count[b] = sum;
+            }
+
+            // Sweep from the left and evaluate the cost of every split
+            lower = Vec3( inf,  inf,  inf);
+            upper = Vec3(-inf, -inf, -inf);
+            sum = 0;
+            for (unsigned int b = 0; b < NUMBER_OF_BINS - 1; ++b)
+            {
+                growBBox(lower, upper, bin_lower[b], bin_upper[b]);
+                sum += bin_count[b];
+
+                float cost = getSurfaceArea(lower, upper) * sum +
+                        right_area[b + 1] * right_count[b + 1];
+
+                if (sum && right_count[b + 1] && cost < best_cost)
+                {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_bin = b;
+                }
+            }
+        }
+
+        // Compare the cost of the best split with the cost of a leaf
+        float leaf_cost = g_intersection_cost * count;
+        float split_cost = inf;
+        if (best_axis >= 0 && node_area > 0.0)
+        {
+            split_cost = g_traversal_cost + g_intersection_cost * best_cost / node_area;
+        }
+
+        if (count <= MAX_PRIMITIVES_PER_LEAF && leaf_cost <= split_cost)
+        {
+            continue;
+        }
+
+        // Partition the primitives
+        unsigned int* p_begin = &m_primitive_index_set[first];
+        unsigned int* p_end = p_begin + count;
+        unsigned int* p_middle = p_begin + count / 2;
+
+        if (best_axis >= 0)
+        {
+            float lower_bound = lower_centroid[best_axis];
+            float scale = NUMBER_OF_BINS / (upper_centroid[best_axis] - lower_bound);
+
+            p_middle = std::partition(p_begin, p_end, [&](unsigned int aPrimitiveId)
+            {
+                unsigned int b = std::min(NUMBER_OF_BINS - 1,
+                        (unsigned int)((centroid_set[aPrimitiveId][best_axis] - lower_bound) * scale));
+                return b <= best_bin;
+            });
+
+            // Rounding errors may put every primitive on the same side
+            if (p_middle == p_begin || p_middle == p_end)
+            {
+                p_middle = p_begin + count / 2;
+            }
+        }
+
+        // Create the children
+        unsigned int left_count = p_middle - p_begin;
+
+        BVHNode left_child;
+        left_child.m_first = first;
+        left_child.m_primitive_count = left_count;
+
+        BVHNode right_child;
+        right_child.m_first = first + left_count;
+        right_child.m_primitive_count = count - left_count;
+
+        m_node_set[node_id].m_first = m_node_set.size();
+        m_node_set[node_id].m_primitive_count = 0;
+
+        node_stack.push_back(m_node_set.size());
+        m_node_set.push_back(left_child);
+
+        node_stack.push_back(m_node_set.size());
+        m_node_set.push_back(right_child);
+    }
+}
+
+
+//----------------------------------------------------------------
+void BVH::buildSBVH(const std::vector<Triangle>& aTriangleSet,
+                    const std::vector<Vec3>& aLowerBBoxCornerSet,
+                    const std::vector<Vec3>& anUpperBBoxCornerSet)
+//----------------------------------------------------------------
+{
+    // See "Spatial Splits in Bounding Volume Hierarchies" by Stich et al.,
+    // High Performance Graphics, 2009. Every node is split either by
+    // partitioning its references (object split, as in buildSAH), or by
+    // a plane that clips the references it crosses (spatial split).
+    // A primitive may then be referenced by several leaves.
+    float inf = std::numeric_limits<float>::infinity();
+    unsigned int number_of_primitives = aTriangleSet.size();
+
+    size_t max_number_of_references = g_sbvh_reference_budget * number_of_primitives;
+    size_t number_of_references = number_of_primitives;
+
+    // Create the root
+    SBVHTask root_task;
+    root_task.m_node_id = 0;
+    root_task.m_reference_set.resize(number_of_primitives);
+    for (unsigned int i = 0; i < number_of_primitives; ++i)
+    {
+        root_task.m_reference_set[i].m_lower_bbox_corner = aLowerBBoxCornerSet[i];
+        root_task.m_reference_set[i].m_upper_bbox_corner = anUpperBBoxCornerSet[i];
+        root_task.m_reference_set[i].m_primitive_id = i;
+    }
+
+    m_node_set.reserve(2 * number_of_primitives - 1);
+    m_node_set.push_back(BVHNode());
+
+    // Nodes that still need to be split
+    std::vector<SBVHTask> task_stack;
+    task_stack.push_back(std::move(root_task));
+
+    float root_area = -1.0;
+
+    while (!task_stack.empty())
+    {
+        SBVHTask task = std::move(task_stack.back());
+        task_stack.pop_back();
+
+        std::vector<BVHReference>& reference_set = task.m_reference_set;
+        unsigned int count = reference_set.size();
+
+        // Compute the bbox of the node and the bbox of the centroids
+        Vec3 lower_bbox_corner( inf,  inf,  inf);
+        Vec3 upper_bbox_corner(-inf, -inf, -inf);
+        Vec3 lower_centroid( inf,  inf,  inf);
+        Vec3 upper_centroid(-inf, -inf, -inf);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            const BVHReference& reference = reference_set[i];
+            Vec3 centroid = (reference.m_lower_bbox_corner + reference.m_upper_bbox_corner) * 0.5f;
+
+            growBBox(lower_bbox_corner, upper_bbox_corner,
+                     reference.m_lower_bbox_corner, reference.m_upper_bbox_corner);
+            growBBox(lower_centroid, upper_centroid, centroid, centroid);
+        }
+
+        m_node_set[task.m_node_id].m_lower_bbox_corner = lower_bbox_corner;
+        m_node_set[task.m_node_id].m_upper_bbox_corner = upper_bbox_corner;
+
+        float node_area = getSurfaceArea(lower_bbox_corner, upper_bbox_corner);
+        if (root_area < 0.0)
+        {
+            root_area = node_area;
+        }
+
+        // Find the best object split, as in buildSAH
+        float best_object_cost = inf;
+        int best_object_axis = -1;
+        unsigned int best_object_bin = 0;
+        Vec3 best_object_lower[2];
+        Vec3 best_object_upper[2];
+
+        for (int axis = 0; axis < 3 && count > 1; ++axis)
+        {
+            float lower_bound = lower_centroid[axis];
+            float extent = upper_centroid[axis] - lower_bound;
+
+            if (extent <= 0.0)
+            {
+                continue;
+            }
+
+            float scale = NUMBER_OF_BINS / extent;
+
+            unsigned int bin_count[NUMBER_OF_BINS] = {0};
+            Vec3 bin_lower[NUMBER_OF_BINS];
+            Vec3 bin_upper[NUMBER_OF_BINS];
+            for (unsigned int b = 0; b < NUMBER_OF_BINS; ++b)
+            {
+                bin_lower[b] = Vec3( inf,  inf,  inf);
+                bin_upper[b] = Vec3(-inf, -inf, -inf);
+            }
+
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                const BVHReference& reference = reference_set[i];
+                float centroid = (reference.m_lower_bbox_corner[axis] + reference.m_upper_bbox_corner[axis]) * 0.5f;
+                unsigned int b = std::min(NUMBER_OF_BINS - 1,
+                        (unsigned int)((centroid - lower_bound) * scale));
+
+                ++bin_count[b];
+                growBBox(bin_lower[b], bin_upper[b],
+                         reference.m_lower_bbox_corner, reference.m_upper_bbox_corner);
+            }
+
+            Vec3 right_lower[NUMBER_OF_BINS];
+            Vec3 right_upper[NUMBER_OF_BINS];
+            unsigned int right_count[NUMBER_OF_BINS];
+            Vec3 lower( inf,  inf,  inf);
+            Vec3 upper(-inf, -inf, -inf);
+            unsigned int sum = 0;
+            for (unsigned int b = NUMBER_OF_BINS - 1; b > 0; --b)
+            {
+                growBBox(lower, upper, bin_lower[b], bin_upper[b]);
+                sum += bin_count[b];
+                right_lower[b] = lower;
+                right_upper[b] = upper;
+                right_count[b] = sum;
+            }
+
+            lower = Vec3( inf,  inf,  inf);
+            upper = Vec3(-inf, -inf, -inf);
+            sum = 0;
+            for (unsigned int b = 0; b < NUMBER_OF_BINS - 1; ++b)
+            {
+                growBBox(lower, upper, bin_lower[b], bin_upper[b]);
+                sum += bin_count[b];
+
+                float cost = getSurfaceArea(lower, upper) * sum +
+                        getSurfaceArea(right_lower[b + 1], right_upper[b + 1]) * right_count[b + 1];
+
+                if (sum && right_count[b + 1] && cost < best_object_cost)
+                {
+                    best_object_cost = cost;
+                    best_object_axis = axis;
+                    best_object_bin = b;
+                    best_object_lower[0] = lower;
+                    best_object_upper[0] = upper;
+                    best_object_lower[1] = right_lower[b + 1];
+                    best_object_upper[1] = right_upper[b + 1];
+                }
+            }
+        }
+
+        // Find the best spatial split if the children of the object split
+        // overlap significantly, and if the reference budget allows it
+        float best_spatial_cost = inf;
+        int best_spatial_axis = -1;
+        float best_spatial_position = 0.0;
+
+        bool try_spatial_split = count > 1 && number_of_references < max_number_of_references;
+        if (try_spatial_split && best_object_axis >= 0)
+        {
+            Vec3 overlap_lower(std::max(best_object_lower[0].getX(), best_object_lower[1].getX()),
+                               std::max(best_object_lower[0].getY(), best_object_lower[1].getY()),
+                               std::max(best_object_lower[0].getZ(), best_object_lower[1].getZ()));
+            Vec3 overlap_upper(std::min(best_object_upper[0].getX(), best_object_upper[1].getX()),
+                               std::min(best_object_upper[0].getY(), best_object_upper[1].getY()),
+                               std::min(best_object_upper[0].getZ(), best_object_upper[1].getZ()));
+
+            try_spatial_split = getSurfaceArea(overlap_lower, overlap_upper) >
+                    g_sbvh_overlap_threshold * root_area;
+        }
+
+        for (int axis = 0; axis < 3 && try_spatial_split; ++axis)
+        {
+            float lower_bound = lower_bbox_corner[axis];
+            float extent = upper_bbox_corner[axis] - lower_bound;
+
+            if (extent <= 0.0)
+            {
+                continue;
+            }
+
+            float bin_width = extent / NUMBER_OF_BINS;
+            float scale = NUMBER_OF_BINS / extent;
+
+            unsigned int entry_count[NUMBER_OF_BINS] = {0};
+            unsigned int exit_count[NUMBER_OF_BINS] = {0};
+            Vec3 bin_lower[NUMBER_OF_BINS];
+            Vec3 bin_upper[NUMBER_OF_BINS];
+            for (unsigned int b = 0; b < NUMBER_OF_BINS; ++b)
+            {
+                bin_lower[b] = Vec3( inf,  inf,  inf);
+                bin_upper[b] = Vec3(-inf, -inf, -inf);
+            }
+
+            // Clip every reference into the bins it overlaps
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                const BVHReference& reference = reference_set[i];
+                unsigned int first_bin = std::min(NUMBER_OF_BINS - 1,
+                        (unsigned int)(std::max(0.0f, reference.m_lower_bbox_corner[axis] - lower_bound) * scale));
+                unsigned int last_bin = std::min(NUMBER_OF_BINS - 1,
+                        (unsigned int)(std::max(0.0f, reference.m_upper_bbox_corner[axis] - lower_bound) * scale));
+
+                ++entry_count[first_bin];
+                ++exit_count[last_bin];
+
+                for (unsigned int b = first_bin; b <= last_bin; ++b)
+                {
+                    Vec3 lower;
+                    Vec3 upper;
+                    if (first_bin == last_bin)
+                    {
+                        lower = reference.m_lower_bbox_corner;
+                        upper = reference.m_upper_bbox_corner;
+                    }
+                    else if (!clipTriangle(aTriangleSet[reference.m_primitive_id], axis,
+                                           lower_bound + b * bin_width,
+                                           lower_bound + (b + 1) * bin_width,
+                                           reference, lower, upper))
+                    {
+                        continue;
+                    }
+
+                    growBBox(bin_lower[b], bin_upper[b], lower, upper);
+                }
+            }
+
+            // Sweep from the right to get the area and count of the right-hand side
+            float right_area[NUMBER_OF_BINS];
+            unsigned int right_count[NUMBER_OF_BINS];
+            Vec3 lower( inf,  inf,  inf);
+            Vec3 upper(-inf, -inf, -inf);
+            unsigned int sum = 0;
+            for (unsigned int b = NUMBER_OF_BINS - 1; b > 0; --b)
+            {
+                growBBox(lower, upper, bin_lower[b], bin_upper[b]);
+                sum += exit_count[b];
+                right_area[b] = getSurfaceArea(lower, upper);
+                right_count[b] = sum;
+            }
+
+            // Sweep from the left and evaluate the cost of every plane
+            lower = Vec3( inf,  inf,  inf);
+            upper = Vec3(-inf, -inf, -inf);
+            sum = 0;
+            for (unsigned int b = 0; b < NUMBER_OF_BINS - 1; ++b)
+            {
+                growBBox(lower, upper, bin_lower[b], bin_upper[b]);
+                sum += entry_count[b];
+
+                float cost = getSurfaceArea(lower, upper) * sum +
+                        right_area[b + 1] * right_count[b + 1];
+
+                if (sum && right_count[b + 1] && cost < best_spatial_cost)
+                {
+                    best_spatial_cost = cost;
+                    best_spatial_axis = axis;
+                    best_spatial_position = lower_bound + (b + 1) * bin_width;
+                }
+            }
+        }
+
+        // Compare the cost of the best split with the cost of a leaf
+        float best_cost = std::min(best_object_cost, best_spatial_cost);
+        float leaf_cost = g_intersection_cost * count;
+        float split_cost = inf;
+        if (best_cost < inf && node_area > 0.0)
+        {
+            split_cost = g_traversal_cost + g_intersection_cost * best_cost / node_area;
+        }
+
+        std::vector<BVHReference> child_reference_set[2];
+
+        // Spatial split: the references crossing the plane go on both sides
+        if (best_spatial_cost < best_object_cost &&
+                !(count <= MAX_PRIMITIVES_PER_LEAF && leaf_cost <= split_cost))
+        {
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                const BVHReference& reference = reference_set[i];
+
+                if (reference.m_upper_bbox_corner[best_spatial_axis] <= best_spatial_position)
+                {
+                    child_reference_set[0].push_back(reference);
+                }
+                else if (reference.m_lower_bbox_corner[best_spatial_axis] >= best_spatial_position)
+                {
+                    child_reference_set[1].push_back(reference);
+                }
+                else
+                {
+                    BVHReference part = reference;
+
+                    if (clipTriangle(aTriangleSet[reference.m_primitive_id], best_spatial_axis,
+                                     -inf, best_spatial_position, reference,
+                                     part.m_lower_bbox_corner, part.m_upper_bbox_corner))
+                    {
+                        child_reference_set[0].push_back(part);
+                    }
+
+                    if (clipTriangle(aTriangleSet[reference.m_primitive_id], best_spatial_axis,
+                                     best_spatial_position, inf, reference,
+                                     part.m_lower_bbox_corner, part.m_upper_bbox_corner))
+                    {
+                        child_reference_set[1].push_back(part);
+                    }
+                }
+            }
+
+            // Rounding errors may put every reference on the same side
+            if (child_reference_set[0].empty() || child_reference_set[1].empty())
+            {
+                child_reference_set[0].clear();
+                child_reference_set[1].clear();
+            }
+            else
+            {
+                number_of_references += child_reference_set[0].size() + child_reference_set[1].size() - count;
+            }
+        }
+
+        // Object split
+        if (child_reference_set[0].empty() &&
+                !(count <= MAX_PRIMITIVES_PER_LEAF && leaf_cost <= split_cost) &&
+                count > 1)
+        {
+            if (best_object_axis >= 0)
+            {
+                float lower_bound = lower_centroid[best_object_axis];
+                float scale = NUMBER_OF_BINS / (upper_centroid[best_object_axis] - lower_bound);
+
+                for (unsigned int i = 0; i < count; ++i)
+                {
+                    const BVHReference& reference = reference_set[i];
+                    float centroid = (reference.m_lower_bbox_corner[best_object_axis] +
+                            reference.m_upper_bbox_corner[best_object_axis]) * 0.5f;
+                    unsigned int b = std::min(NUMBER_OF_BINS - 1,
+                            (unsigned int)((centroid - lower_bound) * scale));
+
+                    child_reference_set[b <= best_object_bin ? 0 : 1].push_back(reference);
+                }
+            }
+
+            // Rounding errors may put every reference on the same side
+            if (child_reference_set[0].empty() || child_reference_set[1].empty())
+            {
+                child_reference_set[0].assign(reference_set.begin(), reference_set.begin() + count / 2);
+                child_reference_set[1].assign(reference_set.begin() + count / 2, reference_set.end());
+            }
+        }
+
+        // Create a leaf
+        if (child_reference_set[0].empty())
+        {
+            m_node_set[task.m_node_id].m_first = m_primitive_index_set.size();
+            m_node_set[task.m_node_id].m_primitive_count = count;
+
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                m_primitive_index_set.push_back(reference_set[i].m_primitive_id);
+            }
+            continue;
+        }
+
+        // Create the children
+        m_node_set[task.m_node_id].m_first = m_node_set.size();
+        m_node_set[task.m_node_id].m_primitive_count = 0;
+
+        for (unsigned int i = 0; i < 2; ++i)
+        {
+            SBVHTask child_task;
+            child_task.m_node_id = m_node_set.size();
+            child_task.m_reference_set.swap(child_reference_set[i]);
+
+            m_node_set.push_back(BVHNode());
+            task_stack.push_back(std::move(child_task));
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------------
+unsigned int BVH::countPrimitives(unsigned int aNodeId,
+                                  std::vector<unsigned int>& aPrimitiveCountSet) const
+//------------------------------------------------------------------------------------
+{
+    const BVHNode& node = m_node_set[aNodeId];
+
+    if (node.isLeaf())
+    {
+        aPrimitiveCountSet[aNodeId] = node.m_primitive_count;
+    }
+    else
+    {
+        aPrimitiveCountSet[aNodeId] = countPrimitives(node.m_first, aPrimitiveCountSet) +
+                countPrimitives(node.m_first + 1, aPrimitiveCountSet);
+    }
+
+    return aPrimitiveCountSet[aNodeId];
+}
+
+
+//------------------------------------------------------------------------
+void BVH::gatherPrimitives(unsigned int aNodeId,
+                           std::vector<unsigned int>& aPrimitiveSet) const
+//------------------------------------------------------------------------
+{
+    const BVHNode& node = m_node_set[aNodeId];
+
+    if (!node.isLeaf())
+    {
+        gatherPrimitives(node.m_first, aPrimitiveSet);
+        gatherPrimitives(node.m_first + 1, aPrimitiveSet);
+        return;
+    }
+
+    // With spatial splits, a primitive may be referenced by several leaves
+    for (unsigned int i = node.m_first; i < node.m_first + node.m_primitive_count; ++i)
+    {
+        unsigned int primitive_id = m_primitive_index_set[i];
+
+        if (std::find(aPrimitiveSet.begin(), aPrimitiveSet.end(), primitive_id) == aPrimitiveSet.end())
+        {
+            aPrimitiveSet.push_back(primitive_id);
+        }
+    }
+}
+
+
+//----------------------------------------------------------------
+void BVH::buildLBVH(const std::vector<Vec3>& aLowerBBoxCornerSet,
+                    const std::vector<Vec3>& anUpperBBoxCornerSet,
+                    const Vec3& aLowerBBoxCorner,
+                    const Vec3& anUpperBBoxCorner)
+//----------------------------------------------------------------
+{
+    // See "Maximizing Parallelism in the Construction of BVHs, Octrees,
+    // and k-d Trees" by Tero Karras, High Performance Graphics 2012
+    int number_of_primitives = aLowerBBoxCornerSet.size();
+
+    // Compute the Morton code of every centroid in the bbox of the primitives
+    Vec3 range = anUpperBBoxCorner - aLowerBBoxCorner;
+    Vec3 scale(range.getX() > 0.0 ? 1.0 / range.getX() : 0.0,
+               range.getY() > 0.0 ? 1.0 / range.getY() : 0.0,
+               range.getZ() > 0.0 ? 1.0 / range.getZ() : 0.0);
+
+    std::vector<unsigned int> morton_code_set(number_of_primitives);
+    m_primitive_index_set.resize(number_of_primitives);
+
+    #pragma omp parallel for
+    for (int i = 0; i < number_of_primitives; ++i)
+    {
+        Vec3 centroid = (aLowerBBoxCornerSet[i] + anUpperBBoxCornerSet[i]) * 0.5f;
+        morton_code_set[i] = getMortonCode((centroid - aLowerBBoxCorner) * scale);
+        m_primitive_index_set[i] = i;
+    }
+
+    // Sort the primitives along the Z-order curve
+    radixSort(morton_code_set, m_primitive_index_set);
+
+    // A single primitive: the root is a leaf
+    m_node_set.resize(2 * number_of_primitives - 1);
+    if (number_of_primitives == 1)
+    {
+        m_node_set[0].m_first = 0;
+        m_node_set[0].m_primitive_count = 1;
+        m_node_set[0].m_lower_bbox_corner = aLowerBBoxCornerSet[0];
+        m_node_set[0].m_upper_bbox_corner = anUpperBBoxCornerSet[0];
+        return;
+    }
+
+    // Internal node i splits its range of sorted primitives after the
+    // gamma-th one. Its children are stored at 2*gamma+1 and 2*gamma+2,
+    // so that siblings are contiguous as in the SAH build.
+    // The root is stored at 0.
+    int number_of_internal_nodes = number_of_primitives - 1;
+    std::vector<unsigned int> internal_node_index_set(number_of_internal_nodes);
+    std::vector<unsigned int> leaf_node_index_set(number_of_primitives);
+    std::vector<unsigned int> parent_set(m_node_set.size());
+    std::vector<int> split_set(number_of_internal_nodes);
+
+    internal_node_index_set[0] = 0;
+
+    // Find the range and split position of every internal node
+    #pragma omp parallel for
+    for (int i = 0; i < number_of_internal_nodes; ++i)
+    {
+        // Direction of the range
+        int d = (getCommonPrefixLength(morton_code_set, i, i + 1) -
+                getCommonPrefixLength(morton_code_set, i, i - 1)) < 0 ? -1 : 1;
+
+        // Upper bound for the length of the range
+        int min_prefix_length = getCommonPrefixLength(morton_code_set, i, i - d);
+        int max_length = 2;
+        while (getCommonPrefixLength(morton_code_set, i, i + max_length * d) > min_prefix_length)
+        {
+            max_length *= 2;
+        }
+
+        // Other end of the range using binary search
+        int length = 0;
+        for (int t = max_length / 2; t >= 1; t /= 2)
+        {
+            if (getCommonPrefixLength(morton_code_set, i, i + (length + t) * d) > min_prefix_length)
+            {
+                length += t;
+            }
+        }
+        int j = i + length * d;
+
+        // Split position using binary search
+        int node_prefix_length = getCommonPrefixLength(morton_code_set, i, j);
+        int split = 0;
+        int divisor = 2;
+        int t;
+        do
+        {
+            t = (length + divisor - 1) / divisor;
+            if (getCommonPrefixLength(morton_code_set, i, i + (split + t) * d) > node_prefix_length)
+            {
+                split += t;
+            }
+            divisor *= 2;
+        }
+        while (t > 1);
+
+        int gamma = i + split * d + std::min(d, 0);
+        split_set[i] = gamma;
+
+        // The left child covers [min(i, j), gamma]
+        if (std::min(i, j) == gamma)
+        {
+            leaf_node_index_set[gamma] = 2 * gamma + 1;
+        }
+        else
+        {
+            internal_node_index_set[gamma] = 2 * gamma + 1;
+        }
+
+        // The right child covers [gamma + 1, max(i, j)]
+        if (std::max(i, j) == gamma + 1)
+        {
+            leaf_node_index_set[gamma + 1] = 2 * gamma + 2;
+        }
+        else
+        {
+            internal_node_index_set[gamma + 1] = 2 * gamma + 2;
+        }
+    }
+
+    // Emit the internal nodes
+    #pragma omp parallel for
+    for (int i = 0; i < number_of_internal_nodes; ++i)
+    {
+        unsigned int node_id = internal_node_index_set[i];
+        unsigned int left_child_id = 2 * split_set[i] + 1;
+
+        m_node_set[node_id].m_first = left_child_id;
+        m_node_set[node_id].m_primitive_count = 0;
+
+        parent_set[left_child_id] = node_id;
+        parent_set[left_child_id + 1] = node_id;
+    }
+
+    // Emit the leaves and compute the bboxes bottom-up. The second thread
+    // to reach an internal node processes it, once both children are ready.
+    std::vector<std::atomic<int> > visit_count_set(m_node_set.size());
+    for (unsigned int i = 0; i < visit_count_set.size(); ++i)
+    {
+        visit_count_set[i] = 0;
+    }
+
+    #pragma omp parallel for
+    for (int i = 0; i < number_of_primitives; ++i)
+    {
+        unsigned int node_id = leaf_node_index_set[i];
+        unsigned int primitive_id = m_primitive_index_set[i];
+
+        BVHNode& leaf = m_node_set[node_id];
+        leaf.m_first = i;
+        leaf.m_primitive_count = 1;
+        leaf.m_lower_bbox_corner = aLowerBBoxCornerSet[primitive_id];
+        leaf.m_upper_bbox_corner = anUpperBBoxCornerSet[primitive_id];
+
+        while (node_id)
+        {
+            node_id = parent_set[node_id];
+
+            // The sibling is not ready yet
+            if (visit_count_set[node_id].fetch_add(1) == 0)
+            {
+                break;
+            }
+
+            BVHNode& node = m_node_set[node_id];
+            const BVHNode& left_child = m_node_set[node.m_first];
+            const BVHNode& right_child = m_node_set[node.m_first + 1];
+
+            node.m_lower_bbox_corner = left_child.m_lower_bbox_corner;
+            node.m_upper_bbox_corner = left_child.m_upper_bbox_corner;
+            growBBox(node.m_lower_bbox_corner, node.m_upper_bbox_corner,
+                     right_child.m_lower_bbox_corner, right_child.m_upper_bbox_corner);
+        }
+    }
+}
@@ -0,0 +1,114 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       GBuffer.cxx
+*
+*   @brief      Class to store the visible surfaces of a tile of pixels for deferred shading.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#ifndef __GBuffer_h
+#include "GBuffer.h"
+#endif
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//-----------------------------------------------------
+void GBuffer::groupByMesh(unsigned int aNumberOfMeshes)
+//-----------------------------------------------------
+{
+    // Count the pixels of each mesh
+    std::vector<unsigned int> count_set(aNumberOfMeshes, 0);
+    for (unsigned int i = 0; i < getSize(); ++i)
+    {
+        if (hasHit(i))
+        {
+            ++count_set[m_mesh_id_set[i]];
+        }
+    }
+
+    // Only the meshes that are hit get a group
+    m_group_offset_set.assign(1, 0);
+    m_group_mesh_id_set.clear();
+
+    std::vector<unsigned int> next_set(aNumberOfMeshes, 0);
+    for (unsigned int mesh_id = 0; mesh_id < aNumberOfMeshes; ++mesh_id)
+    {
+        if (count_set[mesh_id])
+        {
+            next_set[mesh_id] = m_group_offset_set.back();
+            m_group_offset_set.push_back(m_group_offset_set.back() + count_set[mesh_id]);
+            m_group_mesh_id_set.push_back(mesh_id);
+        }
+    }
+
+    // Scatter the pixels, they stay in scanline order within a group
+    m_group_pixel_set.resize(m_group_offset_set.back());
+    for (unsigned int i = 0; i < getSize(); ++i)
+    {
+        if (hasHit(i))
+        {
+            m_group_pixel_set[next_set[m_mesh_id_set[i]]++] = i;
+        }
+    }
+}
@@ -0,0 +1,352 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       Grid.cxx
+*
+*   @brief      Class to manipulate a uniform or hierarchical grid traversed with 3D-DDA.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <cmath>     // for cbrt/ceil
+#include <limits>    // for inf
+#include <algorithm> // for min/max
+#include <stdexcept> // for exceptions
+#include <chrono>    // for the build time
+
+#ifndef __Grid_h
+#include "Grid.h"
+#endif
+
+
+//******************************************************************************
+//  Constant global variables
+//******************************************************************************
+
+/// Number of cells per primitive, see "Ray Tracing Animated Scenes using
+/// Coherent Grid Traversal" by Wald et al. (2006)
+const float g_grid_density = 4.0;
+
+/// Number of cells per primitive of the top-level grid of a hierarchical
+/// grid, its dense cells are refined by sub-grids
+const float g_coarse_grid_density = 1.0;
+
+
+//******************************************************************************
+//  Function declarations
+//******************************************************************************
+void getCellRange(const GridLevel& aGrid,
+                  const Vec3& aLowerBBoxCorner,
+                  const Vec3& anUpperBBoxCorner,
+                  unsigned int aLowerCell[3],
+                  unsigned int anUpperCell[3]);
+
+
+//******************************************************************************
+//  Function definitions
+//******************************************************************************
+
+
+//----------------------------------------------
+void getCellRange(const GridLevel& aGrid,
+                  const Vec3& aLowerBBoxCorner,
+                  const Vec3& anUpperBBoxCorner,
+                  unsigned int aLowerCell[3],
+                  unsigned int anUpperCell[3])
+//----------------------------------------------
+{
+    // Cells overlapped by a bbox, clamped to the grid
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        int resolution = aGrid.m_resolution[axis];
+        float cell_size = aGrid.m_cell_size[axis];
+
+        if (cell_size > 0.0)
+        {
+            float lower_bound = aGrid.m_lower_bbox_corner[axis];
+            aLowerCell[axis] = std::min(resolution - 1, std::max(0,
+                    int((aLowerBBoxCorner[axis] - lower_bound) / cell_size)));
+            anUpperCell[axis] = std::min(resolution - 1, std::max(0,
+                    int((anUpperBBoxCorner[axis] - lower_bound) / cell_size)));
+        }
+        else
+        {
+            aLowerCell[axis] = 0;
+            anUpperCell[axis] = 0;
+        }
+    }
+}
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//-------------------------------------------------------------
+void Grid::build(const std::vector<Vec3>& aLowerBBoxCornerSet,
+                 const std::vector<Vec3>& anUpperBBoxCornerSet,
+                 const Vec3& aLowerBBoxCorner,
+                 const Vec3& anUpperBBoxCorner,
+                 unsigned int aNumberOfLevels)
+//-------------------------------------------------------------
+{
+    if (aLowerBBoxCornerSet.size() != anUpperBBoxCornerSet.size())
+    {
+        throw std::length_error("buffer size error");
+    }
+
+    if (!aNumberOfLevels)
+    {
+        throw std::invalid_argument("A grid has at least one level");
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    clear();
+    m_number_of_levels = aNumberOfLevels;
+
+    if (aLowerBBoxCornerSet.size())
+    {
+        std::vector<unsigned int> primitive_id_set(aLowerBBoxCornerSet.size());
+        for (unsigned int i = 0; i < primitive_id_set.size(); ++i)
+        {
+            primitive_id_set[i] = i;
+        }
+
+        buildLevel(aLowerBBoxCornerSet, anUpperBBoxCornerSet,
+                   primitive_id_set,
+                   aLowerBBoxCorner, anUpperBBoxCorner,
+                   0);
+    }
+
+    m_build_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+//-----------------------------------------------------------------------------
+unsigned int Grid::buildLevel(const std::vector<Vec3>& aLowerBBoxCornerSet,
+                              const std::vector<Vec3>& anUpperBBoxCornerSet,
+                              const std::vector<unsigned int>& aPrimitiveIdSet,
+                              const Vec3& aLowerBBoxCorner,
+                              const Vec3& anUpperBBoxCorner,
+                              unsigned int aLevel)
+//-----------------------------------------------------------------------------
+{
+    unsigned int grid_id = m_grid_set.size();
+    unsigned int number_of_primitives = aPrimitiveIdSet.size();
+
+    GridLevel grid;
+    grid.m_lower_bbox_corner = aLowerBBoxCorner;
+    grid.m_upper_bbox_corner = anUpperBBoxCorner;
+
+    // Choose about g_grid_density cells per primitive, with cells as cubic
+    // as possible. A flat axis (e.g. a planar mesh) has a single cell.
+    Vec3 extent = anUpperBBoxCorner - aLowerBBoxCorner;
+    float max_extent = std::max(std::max(extent.getX(), extent.getY()), extent.getZ());
+    float min_extent = max_extent / MAX_RESOLUTION;
+    float volume = std::max(extent.getX(), min_extent) *
+            std::max(extent.getY(), min_extent) *
+            std::max(extent.getZ(), min_extent);
+
+    float cells_per_unit = 0.0;
+    if (volume > 0.0)
+    {
+        float density = (aLevel == 0 && m_number_of_levels > 1) ? g_coarse_grid_density : g_grid_density;
+        cells_per_unit = std::cbrt(density * number_of_primitives / volume);
+    }
+
+    unsigned int number_of_cells = 1;
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        grid.m_resolution[axis] = 1;
+        if (extent[axis] > min_extent)
+        {
+            grid.m_resolution[axis] = std::min(float(MAX_RESOLUTION),
+                    std::max(1.0f, std::ceil(extent[axis] * cells_per_unit)));
+        }
+
+        grid.m_cell_size[axis] = extent[axis] / grid.m_resolution[axis];
+        number_of_cells *= grid.m_resolution[axis];
+    }
+
+    grid.m_first_cell = m_cell_set.size();
+    m_grid_set.push_back(grid);
+
+    GridCell empty_cell;
+    empty_cell.m_first = 0;
+    empty_cell.m_primitive_count = 0;
+    empty_cell.m_sub_grid = 0;
+    m_cell_set.resize(m_cell_set.size() + number_of_cells, empty_cell);
+
+    GridCell* p_cell_set = &m_cell_set[grid.m_first_cell];
+
+    // Count the primitives overlapping every cell
+    unsigned int lower_cell[3];
+    unsigned int upper_cell[3];
+    for (unsigned int i = 0; i < number_of_primitives; ++i)
+    {
+        unsigned int primitive_id = aPrimitiveIdSet[i];
+        getCellRange(grid,
+                     aLowerBBoxCornerSet[primitive_id], anUpperBBoxCornerSet[primitive_id],
+                     lower_cell, upper_cell);
+
+        for (unsigned int z = lower_cell[2]; z <= upper_cell[2]; ++z)
+        {
+            for (unsigned int y = lower_cell[1]; y <= upper_cell[1]; ++y)
+            {
+                for (unsigned int x = lower_cell[0]; x <= upper_cell[0]; ++x)
+                {
+                    ++p_cell_set[x + grid.m_resolution[0] * (y + grid.m_resolution[1] * z)].m_primitive_count;
+                }
+            }
+        }
+    }
+
+    // Give every cell its range of primitive indices
+    unsigned int first = m_primitive_index_set.size();
+    for (unsigned int i = 0; i < number_of_cells; ++i)
+    {
+        p_cell_set[i].m_first = first;
+        first += p_cell_set[i].m_primitive_count;
+        p_cell_set[i].m_primitive_count = 0;
+    }
+
+    m_primitive_index_set.resize(first);
+
+    // Fill the ranges
+    for (unsigned int i = 0; i < number_of_primitives; ++i)
+    {
+        unsigned int primitive_id = aPrimitiveIdSet[i];
+        getCellRange(grid,
+                     aLowerBBoxCornerSet[primitive_id], anUpperBBoxCornerSet[primitive_id],
+                     lower_cell, upper_cell);
+
+        for (unsigned int z = lower_cell[2]; z <= upper_cell[2]; ++z)
+        {
+            for (unsigned int y = lower_cell[1]; y <= upper_cell[1]; ++y)
+            {
+                for (unsigned int x = lower_cell[0]; x <= upper_cell[0]; ++x)
+                {
+                    GridCell& cell = p_cell_set[x + grid.m_resolution[0] * (y + grid.m_resolution[1] * z)];
+                    m_primitive_index_set[cell.m_first + cell.m_primitive_count++] = primitive_id;
+                }
+            }
+        }
+    }
+
+    // Subdivide the dense cells
+    if (aLevel + 1 < m_number_of_levels)
+    {
+        float inf = std::numeric_limits<float>::infinity();
+
+        for (unsigned int z = 0; z < grid.m_resolution[2]; ++z)
+        {
+            for (unsigned int y = 0; y < grid.m_resolution[1]; ++y)
+            {
+                for (unsigned int x = 0; x < grid.m_resolution[0]; ++x)
+                {
+                    // The cells may move as sub-grids are added
+                    unsigned int cell_id = grid.m_first_cell + x + grid.m_resolution[0] * (y + grid.m_resolution[1] * z);
+                    GridCell cell = m_cell_set[cell_id];
+
+                    if (cell.m_primitive_count <= MAX_PRIMITIVES_PER_CELL)
+                    {
+                        continue;
+                    }
+
+                    std::vector<unsigned int> primitive_id_set(
+                            m_primitive_index_set.begin() + cell.m_first,
+                            m_primitive_index_set.begin() + cell.m_first + cell.m_primitive_count);
+
+                    // The sub-grid covers the part of the cell overlapped by its primitives
+                    Vec3 cell_lower = aLowerBBoxCorner + Vec3(x * grid.m_cell_size[0],
+                                                              y * grid.m_cell_size[1],
+                                                              z * grid.m_cell_size[2]);
+                    Vec3 cell_upper = cell_lower + grid.m_cell_size;
+
+                    Vec3 lower( inf,  inf,  inf);
+                    Vec3 upper(-inf, -inf, -inf);
+                    for (unsigned int i = 0; i < primitive_id_set.size(); ++i)
+                    {
+                        for (unsigned int axis = 0; axis < 3; ++axis)
+                        {
+                            lower[axis] = std::min(lower[axis], aLowerBBoxCornerSet[primitive_id_set[i]][axis]);
+                            upper[axis] = std::max(upper[axis], anUpperBBoxCornerSet[primitive_id_set[i]][axis]);
+                        }
+                    }
+
+                    for (unsigned int axis = 0; axis < 3; ++axis)
+                    {
+                        lower[axis] = std::max(lower[axis], cell_lower[axis]);
+                        upper[axis] = std::min(upper[axis], cell_upper[axis]);
+                    }
+
+                    unsigned int sub_grid_id = buildLevel(aLowerBBoxCornerSet, anUpperBBoxCornerSet,
+                                                          primitive_id_set,
+                                                          lower, upper,
+                                                          aLevel + 1);
+
+                    m_cell_set[cell_id].m_sub_grid = sub_grid_id;
+                }
+            }
+        }
+    }
+
+    return grid_id;
+}
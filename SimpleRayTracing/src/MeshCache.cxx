@@ -0,0 +1,789 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       MeshCache.cxx
+*
+*   @brief      Class to save and load triangle meshes with their BVH in binary cache files.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <cstdio>   // for FILE
+#include <cstring>  // for memcpy
+#include <chrono>   // for unique temporary file names
+#include <iomanip>  // for setw
+#include <iostream>
+#include <sstream>
+
+#include <sys/stat.h> // for stat
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define HAS_POSIX_IO
+#endif
+
+#ifndef __MeshCache_h
+#include "MeshCache.h"
+#endif
+
+
+//******************************************************************************
+//  Type declarations
+//******************************************************************************
+
+// The files are written in the native byte order with 32-bit indices
+static_assert(sizeof(unsigned int) == 4, "32-bit unsigned int required");
+static_assert(sizeof(float) == 4, "32-bit float required");
+
+
+/// Header of a mesh file, followed by the vertices and the texture
+/// coordinates (3 floats each), the vertex indices of the triangles (none if
+/// the mesh is not indexed), the BVH nodes and the primitive indices
+struct MeshFileHeader
+{
+    char m_magic[8];
+    uint32_t m_version;
+    uint32_t m_byte_order;
+    uint64_t m_key;
+    uint32_t m_build_method;
+    uint32_t m_number_of_vertices;
+    uint32_t m_number_of_text_coords;
+    uint32_t m_number_of_vertex_indices;
+    uint32_t m_number_of_nodes;
+    uint32_t m_number_of_primitive_indices;
+
+    /// Ambient, diffuse and specular colours, and shininess
+    float m_material[10];
+};
+
+
+/// A BVH node as stored in a mesh file
+struct MeshFileNode
+{
+    float m_bbox[6];
+    uint32_t m_first;
+    uint32_t m_primitive_count;
+};
+
+
+/// Header of an index file, followed by the keys of the meshes
+struct IndexFileHeader
+{
+    char m_magic[8];
+    uint32_t m_version;
+    uint32_t m_byte_order;
+    uint64_t m_file_size;
+    int64_t m_modification_time;
+    uint64_t m_number_of_meshes;
+};
+
+
+//==============================================================================
+/**
+*   @class  MappedFile
+*   @brief  MappedFile is a class to map a file in memory (read only). The
+*           file is read in a buffer if mmap is not available.
+*/
+//==============================================================================
+class MappedFile
+//------------------------------------------------------------------------------
+{
+public:
+    MappedFile(const std::string& aFileName);
+    ~MappedFile();
+
+    const char* getData() const;
+    size_t getSize() const;
+
+private:
+    // Not copyable
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* m_p_data;
+    size_t m_size;
+    bool m_is_mapped;
+    std::vector<char> m_buffer;
+};
+
+
+//******************************************************************************
+//  Constant variables
+//******************************************************************************
+const char g_mesh_magic[8]  = "SRTMESH";
+const char g_index_magic[8] = "SRTINDX";
+
+/// Detects files written on a machine with a different byte order
+const uint32_t g_byte_order = 0x01020304;
+
+
+//******************************************************************************
+//  Function declarations
+//******************************************************************************
+uint64_t hashBytes(uint64_t aHash, const void* apData, size_t aSize);
+
+bool getFileStatus(const std::string& aFileName,
+                   uint64_t& aSize,
+                   int64_t& aModificationTime);
+
+bool isValidBVH(const std::vector<BVHNode>& aNodeSet,
+                const std::vector<unsigned int>& aPrimitiveIndexSet,
+                unsigned int aNumberOfPrimitives);
+
+
+//******************************************************************************
+//  Function definitions
+//******************************************************************************
+
+
+//------------------------------------------------------------------
+uint64_t hashBytes(uint64_t aHash, const void* apData, size_t aSize)
+//------------------------------------------------------------------
+{
+    // 64-bit FNV-1a
+    const unsigned char* p_byte = static_cast<const unsigned char*>(apData);
+
+    for (size_t i = 0; i < aSize; ++i)
+    {
+        aHash ^= p_byte[i];
+        aHash *= 1099511628211ULL;
+    }
+
+    return aHash;
+}
+
+
+//----------------------------------------------
+bool getFileStatus(const std::string& aFileName,
+                   uint64_t& aSize,
+                   int64_t& aModificationTime)
+//----------------------------------------------
+{
+    struct stat file_status;
+
+    if (stat(aFileName.c_str(), &file_status))
+    {
+        return false;
+    }
+
+    aSize = file_status.st_size;
+    aModificationTime = file_status.st_mtime;
+
+    return true;
+}
+
+
+//------------------------------------------------------------------
+bool isValidBVH(const std::vector<BVHNode>& aNodeSet,
+                const std::vector<unsigned int>& aPrimitiveIndexSet,
+                unsigned int aNumberOfPrimitives)
+//------------------------------------------------------------------
+{
+    // There is a root if there are primitives
+    if (aNodeSet.empty() != !aNumberOfPrimitives)
+    {
+        return false;
+    }
+
+    // The children may be stored before their parent (e.g. LBVH, treelet
+    // restructuring), but each node is the child of one node at most and
+    // the root of none: the traversal from the root cannot loop
+    std::vector<bool> is_child_set(aNodeSet.size(), false);
+    for (size_t i = 0; i < aNodeSet.size(); ++i)
+    {
+        const BVHNode& node = aNodeSet[i];
+
+        // The primitives of a leaf
+        if (node.isLeaf())
+        {
+            if (uint64_t(node.m_first) + node.m_primitive_count > aPrimitiveIndexSet.size())
+            {
+                return false;
+            }
+        }
+        // The two children of an inner node
+        else
+        {
+            if (node.m_first == 0 || uint64_t(node.m_first) + 1 >= aNodeSet.size() ||
+                    is_child_set[node.m_first] || is_child_set[node.m_first + 1])
+            {
+                return false;
+            }
+
+            is_child_set[node.m_first] = true;
+            is_child_set[node.m_first + 1] = true;
+        }
+    }
+
+    for (size_t i = 0; i < aPrimitiveIndexSet.size(); ++i)
+    {
+        if (aPrimitiveIndexSet[i] >= aNumberOfPrimitives)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//---------------------------------------------------
+MappedFile::MappedFile(const std::string& aFileName):
+//---------------------------------------------------
+        m_p_data(0),
+        m_size(0),
+        m_is_mapped(false)
+//------------------------------------------------------
+{
+#ifdef HAS_POSIX_IO
+    int file_descriptor = open(aFileName.c_str(), O_RDONLY);
+
+    if (file_descriptor >= 0)
+    {
+        struct stat file_status;
+
+        if (!fstat(file_descriptor, &file_status) && file_status.st_size > 0)
+        {
+            void* p_mapping = mmap(0, file_status.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+
+            if (p_mapping != MAP_FAILED)
+            {
+                m_p_data = static_cast<const char*>(p_mapping);
+                m_size = file_status.st_size;
+                m_is_mapped = true;
+            }
+        }
+
+        // The mapping stays valid after the file is closed
+        close(file_descriptor);
+    }
+#else
+    FILE* p_file = fopen(aFileName.c_str(), "rb");
+
+    if (p_file)
+    {
+        char buffer[65536];
+        size_t count;
+
+        while ((count = fread(buffer, 1, sizeof(buffer), p_file)) > 0)
+        {
+            m_buffer.insert(m_buffer.end(), buffer, buffer + count);
+        }
+
+        fclose(p_file);
+
+        m_p_data = m_buffer.data();
+        m_size = m_buffer.size();
+    }
+#endif
+}
+
+
+//-----------------------
+MappedFile::~MappedFile()
+//-----------------------
+{
+#ifdef HAS_POSIX_IO
+    if (m_is_mapped)
+    {
+        munmap(const_cast<char*>(m_p_data), m_size);
+    }
+#endif
+}
+
+
+//-------------------------------------
+const char* MappedFile::getData() const
+//-------------------------------------
+{
+    return m_p_data;
+}
+
+
+//--------------------------------
+size_t MappedFile::getSize() const
+//--------------------------------
+{
+    return m_size;
+}
+
+
+//-------------------------------------------------------------------------
+uint64_t MeshCache::computeKey(const std::vector<float>& aVertexSet,
+                               const std::vector<unsigned int>& anIndexSet,
+                               const Material& aMaterial)
+//-------------------------------------------------------------------------
+{
+    uint64_t number_of_vertices = aVertexSet.size();
+    uint64_t number_of_indices = anIndexSet.size();
+
+    uint64_t hash = 14695981039346656037ULL;
+    hash = hashBytes(hash, &number_of_vertices, sizeof(number_of_vertices));
+    hash = hashBytes(hash, aVertexSet.data(), aVertexSet.size() * sizeof(float));
+    hash = hashBytes(hash, &number_of_indices, sizeof(number_of_indices));
+    hash = hashBytes(hash, anIndexSet.data(), anIndexSet.size() * sizeof(unsigned int));
+
+    // The same geometry with another material is another mesh
+    float material[10] = {
+        aMaterial.getAmbient().getX(), aMaterial.getAmbient().getY(), aMaterial.getAmbient().getZ(),
+        aMaterial.getDiffuse().getX(), aMaterial.getDiffuse().getY(), aMaterial.getDiffuse().getZ(),
+        aMaterial.getSpecular().getX(), aMaterial.getSpecular().getY(), aMaterial.getSpecular().getZ(),
+        aMaterial.getShininess()
+    };
+    hash = hashBytes(hash, material, sizeof(material));
+
+    return hash;
+}
+
+
+//------------------------------------------------------------
+bool MeshCache::load(uint64_t aKey, TriangleMesh& aMesh) const
+//------------------------------------------------------------
+{
+    if (!isEnabled())
+    {
+        return false;
+    }
+
+    MappedFile file(getMeshFileName(aKey, aMesh.getBuildMethod(), aMesh.getTreeletRestructuring()));
+
+    // Check the header
+    MeshFileHeader header;
+    if (file.getSize() < sizeof(header))
+    {
+        return false;
+    }
+
+    memcpy(&header, file.getData(), sizeof(header));
+
+    if (memcmp(header.m_magic, g_mesh_magic, sizeof(g_mesh_magic)) ||
+            header.m_version != VERSION ||
+            header.m_byte_order != g_byte_order ||
+            header.m_key != aKey ||
+            header.m_build_method != aMesh.getBuildMethod())
+    {
+        return false;
+    }
+
+    size_t file_size = sizeof(header) +
+            (size_t(header.m_number_of_vertices) + header.m_number_of_text_coords) * 3 * sizeof(float) +
+            size_t(header.m_number_of_vertex_indices) * sizeof(unsigned int) +
+            size_t(header.m_number_of_nodes) * sizeof(MeshFileNode) +
+            size_t(header.m_number_of_primitive_indices) * sizeof(unsigned int);
+
+    // The file is truncated
+    if (file.getSize() != file_size)
+    {
+        return false;
+    }
+
+    // The buffers are not consistent: one texture coordinate per vertex if
+    // any, and whole triangles, indexed or not
+    if ((header.m_number_of_text_coords && header.m_number_of_text_coords != header.m_number_of_vertices) ||
+            header.m_number_of_vertex_indices % 3 ||
+            (!header.m_number_of_vertex_indices && header.m_number_of_vertices % 3))
+    {
+        return false;
+    }
+
+    unsigned int number_of_triangles = header.m_number_of_vertex_indices ?
+            header.m_number_of_vertex_indices / 3 :
+            header.m_number_of_vertices / 3;
+
+    const char* p_data = file.getData() + sizeof(header);
+
+    // Load the vertices and the triangles
+    std::vector<float> vertex_set(size_t(header.m_number_of_vertices) * 3);
+    std::vector<float> text_coord_set(size_t(header.m_number_of_text_coords) * 3);
+    std::vector<unsigned int> vertex_index_set(header.m_number_of_vertex_indices);
+
+    if (vertex_set.size())
+    {
+        memcpy(vertex_set.data(), p_data, vertex_set.size() * sizeof(float));
+        p_data += vertex_set.size() * sizeof(float);
+    }
+
+    if (text_coord_set.size())
+    {
+        memcpy(text_coord_set.data(), p_data, text_coord_set.size() * sizeof(float));
+        p_data += text_coord_set.size() * sizeof(float);
+    }
+
+    if (vertex_index_set.size())
+    {
+        memcpy(vertex_index_set.data(), p_data, vertex_index_set.size() * sizeof(unsigned int));
+        p_data += vertex_index_set.size() * sizeof(unsigned int);
+    }
+
+    for (size_t i = 0; i < vertex_index_set.size(); ++i)
+    {
+        if (vertex_index_set[i] >= header.m_number_of_vertices)
+        {
+            return false;
+        }
+    }
+
+    // Load the BVH
+    std::vector<BVHNode> node_set(header.m_number_of_nodes);
+
+    for (unsigned int i = 0; i < header.m_number_of_nodes; ++i)
+    {
+        MeshFileNode node;
+        memcpy(&node, p_data, sizeof(node));
+        p_data += sizeof(node);
+
+        node_set[i].m_lower_bbox_corner = Vec3(node.m_bbox[0], node.m_bbox[1], node.m_bbox[2]);
+        node_set[i].m_upper_bbox_corner = Vec3(node.m_bbox[3], node.m_bbox[4], node.m_bbox[5]);
+        node_set[i].m_first = node.m_first;
+        node_set[i].m_primitive_count = node.m_primitive_count;
+    }
+
+    std::vector<unsigned int> primitive_index_set(header.m_number_of_primitive_indices);
+    if (primitive_index_set.size())
+    {
+        memcpy(primitive_index_set.data(), p_data, primitive_index_set.size() * sizeof(unsigned int));
+    }
+
+    // A stale or corrupt file would make the traversal read out of bounds,
+    // the mesh is rebuilt instead
+    if (!isValidBVH(node_set, primitive_index_set, number_of_triangles))
+    {
+        return false;
+    }
+
+    BVH bvh;
+    bvh.setNodes(node_set, primitive_index_set, aMesh.getBuildMethod());
+
+    // Load the material
+    Material material;
+    material.setAmbient(Vec3(header.m_material[0], header.m_material[1], header.m_material[2]));
+    material.setDiffuse(Vec3(header.m_material[3], header.m_material[4], header.m_material[5]));
+    material.setSpecular(Vec3(header.m_material[6], header.m_material[7], header.m_material[8]));
+    material.setShininess(header.m_material[9]);
+
+    aMesh.setMaterial(material);
+    aMesh.setGeometry(vertex_set, vertex_index_set, text_coord_set, bvh);
+
+    return true;
+}
+
+
+//------------------------------------------------------------------
+bool MeshCache::save(uint64_t aKey, const TriangleMesh& aMesh) const
+//------------------------------------------------------------------
+{
+    if (!isEnabled())
+    {
+        return false;
+    }
+
+    const BVH& bvh = aMesh.getBVH();
+    const Material& material = aMesh.getMaterial();
+
+    // The mesh uses a grid, there is no BVH to save
+    if (aMesh.getNumberOfTriangles() && bvh.isEmpty())
+    {
+        return false;
+    }
+
+    MeshFileHeader header;
+    memcpy(header.m_magic, g_mesh_magic, sizeof(g_mesh_magic));
+    header.m_version = VERSION;
+    header.m_byte_order = g_byte_order;
+    header.m_key = aKey;
+    header.m_build_method = bvh.getBuildMethod();
+    header.m_number_of_vertices = aMesh.getNumberOfVertices();
+    header.m_number_of_text_coords = aMesh.getTextCoords().size();
+    header.m_number_of_vertex_indices = aMesh.isIndexed() ? aMesh.getNumberOfTriangles() * 3 : 0;
+    header.m_number_of_nodes = bvh.getNumberOfNodes();
+    header.m_number_of_primitive_indices = bvh.getNumberOfPrimitiveIndices();
+
+    header.m_material[0] = material.getAmbient().getX();
+    header.m_material[1] = material.getAmbient().getY();
+    header.m_material[2] = material.getAmbient().getZ();
+    header.m_material[3] = material.getDiffuse().getX();
+    header.m_material[4] = material.getDiffuse().getY();
+    header.m_material[5] = material.getDiffuse().getZ();
+    header.m_material[6] = material.getSpecular().getX();
+    header.m_material[7] = material.getSpecular().getY();
+    header.m_material[8] = material.getSpecular().getZ();
+    header.m_material[9] = material.getShininess();
+
+    std::vector<char> buffer(sizeof(header) +
+            (header.m_number_of_vertices + header.m_number_of_text_coords) * 3 * sizeof(float) +
+            header.m_number_of_vertex_indices * sizeof(unsigned int) +
+            header.m_number_of_nodes * sizeof(MeshFileNode) +
+            header.m_number_of_primitive_indices * sizeof(unsigned int));
+
+    char* p_data = buffer.data();
+    memcpy(p_data, &header, sizeof(header));
+    p_data += sizeof(header);
+
+    // Save the vertices and the triangles
+    const std::vector<Vec3>* p_attribute_set[2] = {&aMesh.getVertices(), &aMesh.getTextCoords()};
+
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        for (std::vector<Vec3>::const_iterator ite = p_attribute_set[i]->begin();
+                ite != p_attribute_set[i]->end();
+                ++ite)
+        {
+            float v[3] = {ite->getX(), ite->getY(), ite->getZ()};
+            memcpy(p_data, v, sizeof(v));
+            p_data += sizeof(v);
+        }
+    }
+
+    for (unsigned int i = 0; i < header.m_number_of_vertex_indices; ++i)
+    {
+        unsigned int vertex_index = aMesh.getVertexIndex(i / 3, i % 3);
+        memcpy(p_data, &vertex_index, sizeof(vertex_index));
+        p_data += sizeof(vertex_index);
+    }
+
+    // Save the BVH
+    for (unsigned int i = 0; i < header.m_number_of_nodes; ++i)
+    {
+        const BVHNode& bvh_node = bvh.getNode(i);
+
+        MeshFileNode node;
+        node.m_bbox[0] = bvh_node.m_lower_bbox_corner.getX();
+        node.m_bbox[1] = bvh_node.m_lower_bbox_corner.getY();
+        node.m_bbox[2] = bvh_node.m_lower_bbox_corner.getZ();
+        node.m_bbox[3] = bvh_node.m_upper_bbox_corner.getX();
+        node.m_bbox[4] = bvh_node.m_upper_bbox_corner.getY();
+        node.m_bbox[5] = bvh_node.m_upper_bbox_corner.getZ();
+        node.m_first = bvh_node.m_first;
+        node.m_primitive_count = bvh_node.m_primitive_count;
+
+        memcpy(p_data, &node, sizeof(node));
+        p_data += sizeof(node);
+    }
+
+    for (unsigned int i = 0; i < header.m_number_of_primitive_indices; ++i)
+    {
+        unsigned int primitive_index = bvh.getPrimitiveIndex(i);
+        memcpy(p_data, &primitive_index, sizeof(primitive_index));
+        p_data += sizeof(primitive_index);
+    }
+
+    return writeFile(getMeshFileName(aKey, bvh.getBuildMethod(), aMesh.getTreeletRestructuring()), buffer);
+}
+
+
+//-------------------------------------------------------------
+bool MeshCache::loadIndex(const std::string& aFileName,
+                          std::vector<uint64_t>& aKeySet) const
+//-------------------------------------------------------------
+{
+    if (!isEnabled())
+    {
+        return false;
+    }
+
+    uint64_t file_size;
+    int64_t modification_time;
+    if (!getFileStatus(aFileName, file_size, modification_time))
+    {
+        return false;
+    }
+
+    MappedFile file(getIndexFileName(aFileName));
+
+    // Check the header
+    IndexFileHeader header;
+    if (file.getSize() < sizeof(header))
+    {
+        return false;
+    }
+
+    memcpy(&header, file.getData(), sizeof(header));
+
+    // The model file was modified since the index was written
+    if (memcmp(header.m_magic, g_index_magic, sizeof(g_index_magic)) ||
+            header.m_version != VERSION ||
+            header.m_byte_order != g_byte_order ||
+            header.m_file_size != file_size ||
+            header.m_modification_time != modification_time ||
+            file.getSize() != sizeof(header) + header.m_number_of_meshes * sizeof(uint64_t))
+    {
+        return false;
+    }
+
+    aKeySet.resize(header.m_number_of_meshes);
+    if (aKeySet.size())
+    {
+        memcpy(aKeySet.data(), file.getData() + sizeof(header), aKeySet.size() * sizeof(uint64_t));
+    }
+
+    return true;
+}
+
+
+//-------------------------------------------------------------------
+bool MeshCache::saveIndex(const std::string& aFileName,
+                          const std::vector<uint64_t>& aKeySet) const
+//-------------------------------------------------------------------
+{
+    if (!isEnabled())
+    {
+        return false;
+    }
+
+    IndexFileHeader header;
+    memcpy(header.m_magic, g_index_magic, sizeof(g_index_magic));
+    header.m_version = VERSION;
+    header.m_byte_order = g_byte_order;
+    header.m_number_of_meshes = aKeySet.size();
+
+    if (!getFileStatus(aFileName, header.m_file_size, header.m_modification_time))
+    {
+        return false;
+    }
+
+    std::vector<char> buffer(sizeof(header) + aKeySet.size() * sizeof(uint64_t));
+    memcpy(buffer.data(), &header, sizeof(header));
+    if (aKeySet.size())
+    {
+        memcpy(buffer.data() + sizeof(header), aKeySet.data(), aKeySet.size() * sizeof(uint64_t));
+    }
+
+    return writeFile(getIndexFileName(aFileName), buffer);
+}
+
+
+//-------------------------------------------------------------------------
+std::string MeshCache::getMeshFileName(uint64_t aKey,
+                                       BVH::BuildMethod aBuildMethod,
+                                       bool aRestructuringFlag) const
+//-------------------------------------------------------------------------
+{
+    std::stringstream file_name;
+    file_name << m_directory << "/" <<
+            std::hex << std::setw(16) << std::setfill('0') << aKey <<
+            (aBuildMethod == BVH::SAH ? "-sah" : aBuildMethod == BVH::LBVH ? "-lbvh" : "-sbvh") <<
+            (aRestructuringFlag ? "-treelets" : "") << ".mesh";
+
+    return file_name.str();
+}
+
+
+//-------------------------------------------------------------------------
+std::string MeshCache::getIndexFileName(const std::string& aFileName) const
+//-------------------------------------------------------------------------
+{
+    // The index is keyed by the path of the model file
+    uint64_t hash = hashBytes(14695981039346656037ULL, aFileName.data(), aFileName.size());
+
+    std::stringstream file_name;
+    file_name << m_directory << "/" <<
+            std::hex << std::setw(16) << std::setfill('0') << hash << ".index";
+
+    return file_name.str();
+}
+
+
+//---------------------------------------------------------------
+bool MeshCache::writeFile(const std::string& aFileName,
+                          const std::vector<char>& aBuffer) const
+//---------------------------------------------------------------
+{
+#ifdef HAS_POSIX_IO
+    // Create the directory if needed
+    mkdir(m_directory.c_str(), 0755);
+#endif
+
+    // Many jobs may write the same file at the same time: write a temporary
+    // file, then rename it, which replaces the file atomically
+    std::stringstream temp_file_name;
+    temp_file_name << aFileName << "." <<
+            std::chrono::high_resolution_clock::now().time_since_epoch().count();
+#ifdef HAS_POSIX_IO
+    temp_file_name << "." << getpid();
+#endif
+    temp_file_name << ".tmp";
+
+    FILE* p_file = fopen(temp_file_name.str().c_str(), "wb");
+    bool is_written = p_file &&
+            fwrite(aBuffer.data(), 1, aBuffer.size(), p_file) == aBuffer.size();
+
+    if (p_file)
+    {
+        is_written = !fclose(p_file) && is_written;
+    }
+
+    if (is_written)
+    {
+        is_written = !std::rename(temp_file_name.str().c_str(), aFileName.c_str());
+    }
+
+    if (!is_written)
+    {
+        std::remove(temp_file_name.str().c_str());
+        std::cerr << "WARNING: Cannot write the cache file " << aFileName << std::endl;
+    }
+
+    return is_written;
+}
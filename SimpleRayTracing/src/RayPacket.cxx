@@ -0,0 +1,320 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       RayPacket.cxx
+*
+*   @brief      Class to trace a packet of coherent rays together.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <cmath>
+#include <algorithm> // for min/max
+#include <stdexcept>
+
+#ifndef __RayPacket_h
+#include "RayPacket.h"
+#endif
+
+
+//******************************************************************************
+//  Static member definitions
+//******************************************************************************
+const unsigned int RayPacket::MAX_SIZE;
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//-----------------------------------------
+void RayPacket::addRay(const Ray& aRay)
+//-----------------------------------------
+{
+    if (m_ray_set.size() == MAX_SIZE)
+    {
+        throw std::out_of_range("The ray packet is full");
+    }
+
+    unsigned int i = m_ray_set.size();
+    m_ray_set.push_back(aRay);
+
+    const Vec3& origin = aRay.getOrigin();
+    const Vec3& direction = aRay.getDirection();
+    const Vec3& inverse_direction = aRay.getInverseDirection();
+
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        m_origin[axis][i] = origin[axis];
+        m_direction[axis][i] = direction[axis];
+        m_inverse_direction[axis][i] = inverse_direction[axis];
+    }
+
+    m_t_min[i] = aRay.getTMin();
+    m_t_max[i] = aRay.getTMax();
+    m_hit[i] = false;
+    m_u[i] = 0.0;
+    m_v[i] = 0.0;
+    m_primitive_id[i] = 0;
+    m_instance_id[i] = 0;
+
+    // Grow the frustum
+    if (i == 0)
+    {
+        for (unsigned int axis = 0; axis < 3; ++axis)
+        {
+            m_direction_sign[axis] = aRay.getDirectionSign(axis);
+        }
+
+        m_lower_origin = m_upper_origin = origin;
+        m_lower_inverse_direction = m_upper_inverse_direction = inverse_direction;
+    }
+    else
+    {
+        for (unsigned int axis = 0; axis < 3; ++axis)
+        {
+            if (m_direction_sign[axis] != aRay.getDirectionSign(axis))
+            {
+                m_coherent = false;
+            }
+
+            m_lower_origin[axis] = std::min(m_lower_origin[axis], origin[axis]);
+            m_upper_origin[axis] = std::max(m_upper_origin[axis], origin[axis]);
+            m_lower_inverse_direction[axis] = std::min(m_lower_inverse_direction[axis], inverse_direction[axis]);
+            m_upper_inverse_direction[axis] = std::max(m_upper_inverse_direction[axis], inverse_direction[axis]);
+        }
+    }
+
+    // A null component of a direction gives an infinite inverse, and
+    // the interval arithmetic below would produce NaNs
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        if (std::isinf(inverse_direction[axis]))
+        {
+            m_coherent = false;
+        }
+    }
+
+    m_lowest_t_min = std::min(m_lowest_t_min, aRay.getTMin());
+}
+
+
+//---------------------------------------------------------------------
+bool RayPacket::intersectFrustum(const Vec3& aLowerBBoxCorner,
+                                 const Vec3& anUpperBBoxCorner) const
+//---------------------------------------------------------------------
+{
+    const Vec3* p_bounds[2] = {&aLowerBBoxCorner, &anUpperBBoxCorner};
+
+    // The rays share the signs of their directions, hence their near and
+    // far planes. The slab distances (plane - origin) * inverse direction
+    // are bounded with interval arithmetic. The rounding is monotonic, so
+    // that the bounds hold for the distances computed ray by ray.
+    float t_near = m_lowest_t_min;
+    float t_far = INFINITY;
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        float near_plane = (*p_bounds[    m_direction_sign[axis]])[axis];
+        float far_plane  = (*p_bounds[1 - m_direction_sign[axis]])[axis];
+
+        float near_product[4] = {
+            (near_plane - m_upper_origin[axis]) * m_lower_inverse_direction[axis],
+            (near_plane - m_upper_origin[axis]) * m_upper_inverse_direction[axis],
+            (near_plane - m_lower_origin[axis]) * m_lower_inverse_direction[axis],
+            (near_plane - m_lower_origin[axis]) * m_upper_inverse_direction[axis]
+        };
+
+        float far_product[4] = {
+            (far_plane - m_upper_origin[axis]) * m_lower_inverse_direction[axis],
+            (far_plane - m_upper_origin[axis]) * m_upper_inverse_direction[axis],
+            (far_plane - m_lower_origin[axis]) * m_lower_inverse_direction[axis],
+            (far_plane - m_lower_origin[axis]) * m_upper_inverse_direction[axis]
+        };
+
+        t_near = std::max(t_near, *std::min_element(near_product, near_product + 4));
+        t_far = std::min(t_far, *std::max_element(far_product, far_product + 4));
+    }
+
+    return t_near <= t_far;
+}
+
+
+//------------------------------------------------------------------------
+unsigned int RayPacket::findFirstHit(const Vec3& aLowerBBoxCorner,
+                                     const Vec3& anUpperBBoxCorner,
+                                     unsigned int aFirstRay,
+                                     float& tNear) const
+//------------------------------------------------------------------------
+{
+    // The same slab test as Ray::intersect, ray by ray
+    const Vec3* p_bounds[2] = {&aLowerBBoxCorner, &anUpperBBoxCorner};
+
+    float near_plane[3];
+    float far_plane[3];
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        near_plane[axis] = (*p_bounds[    m_direction_sign[axis]])[axis];
+        far_plane[axis]  = (*p_bounds[1 - m_direction_sign[axis]])[axis];
+    }
+
+    unsigned int size = m_ray_set.size();
+    for (unsigned int i = aFirstRay; i < size; ++i)
+    {
+        float tx_near = (near_plane[0] - m_origin[0][i]) * m_inverse_direction[0][i];
+        float tx_far  = (far_plane[0]  - m_origin[0][i]) * m_inverse_direction[0][i];
+        float ty_near = (near_plane[1] - m_origin[1][i]) * m_inverse_direction[1][i];
+        float ty_far  = (far_plane[1]  - m_origin[1][i]) * m_inverse_direction[1][i];
+        float tz_near = (near_plane[2] - m_origin[2][i]) * m_inverse_direction[2][i];
+        float tz_far  = (far_plane[2]  - m_origin[2][i]) * m_inverse_direction[2][i];
+
+        float t_near = std::max(std::max(std::max(tx_near, ty_near), tz_near), m_t_min[i]);
+        float t_far  = std::min(std::min(std::min(tx_far,  ty_far),  tz_far),  m_t_max[i]);
+
+        if (t_near <= t_far)
+        {
+            tNear = t_near;
+            return i;
+        }
+    }
+
+    return size;
+}
+
+
+//------------------------------------------------------------
+void RayPacket::intersect(const TriangleRecord& aRecord,
+                          unsigned int aTriangleId,
+                          unsigned int aFirstRay)
+//------------------------------------------------------------
+{
+    // The Möller–Trumbore test of Ray::intersect, with the same rejection
+    // conditions, written without branches so that it is vectorised
+    // across the rays
+    const float e1x = aRecord.m_edge1.getX();
+    const float e1y = aRecord.m_edge1.getY();
+    const float e1z = aRecord.m_edge1.getZ();
+    const float e2x = aRecord.m_edge2.getX();
+    const float e2y = aRecord.m_edge2.getY();
+    const float e2z = aRecord.m_edge2.getZ();
+    const float p1x = aRecord.m_p1.getX();
+    const float p1y = aRecord.m_p1.getY();
+    const float p1z = aRecord.m_p1.getZ();
+
+    unsigned int size = m_ray_set.size();
+
+    #pragma omp simd
+    for (unsigned int i = aFirstRay; i < size; ++i)
+    {
+        const float dx = m_direction[0][i];
+        const float dy = m_direction[1][i];
+        const float dz = m_direction[2][i];
+
+        // pvec = direction x edge2
+        float pvec_x = dy * e2z - dz * e2y;
+        float pvec_y = dz * e2x - dx * e2z;
+        float pvec_z = dx * e2y - dy * e2x;
+
+        float det = e1x * pvec_x + e1y * pvec_y + e1z * pvec_z;
+        float inv_det = 1.0f / det;
+
+        // tvec = origin - p1
+        float tvec_x = m_origin[0][i] - p1x;
+        float tvec_y = m_origin[1][i] - p1y;
+        float tvec_z = m_origin[2][i] - p1z;
+
+        float u = (tvec_x * pvec_x + tvec_y * pvec_y + tvec_z * pvec_z) * inv_det;
+
+        // qvec = tvec x edge1
+        float qvec_x = tvec_y * e1z - tvec_z * e1y;
+        float qvec_y = tvec_z * e1x - tvec_x * e1z;
+        float qvec_z = tvec_x * e1y - tvec_y * e1x;
+
+        float t = (e2x * qvec_x + e2y * qvec_y + e2z * qvec_z) * inv_det;
+        float v = (dx * qvec_x + dy * qvec_y + dz * qvec_z) * inv_det;
+
+        bool hit = det != 0.0f &&
+            !(u < 0.0f) && !(u > 1.0f) &&
+            !(t <= m_t_min[i]) && !(t >= m_t_max[i]) &&
+            !(v < 0.0f) && !(u + v > 1.0f);
+
+        m_t_max[i] = hit ? t : m_t_max[i];
+        m_u[i] = hit ? u : m_u[i];
+        m_v[i] = hit ? v : m_v[i];
+        m_primitive_id[i] = hit ? aTriangleId : m_primitive_id[i];
+        m_hit[i] = m_hit[i] || hit;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+void RayPacket::occlude(const TriangleRecord& aRecord, unsigned int aFirstRay)
+//----------------------------------------------------------------------------
+{
+    intersect(aRecord, 0, aFirstRay);
+
+    // Any intersection will do: the rays that are hit, now or before, are
+    // occluded
+    unsigned int size = m_ray_set.size();
+
+    #pragma omp simd
+    for (unsigned int i = aFirstRay; i < size; ++i)
+    {
+        m_t_max[i] = m_hit[i] ? -INFINITY : m_t_max[i];
+    }
+}
@@ -0,0 +1,212 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       RayStream.cxx
+*
+*   @brief      Class to trace a large batch of rays as a stream.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <algorithm> // for min/max
+
+#ifndef __RayStream_h
+#include "RayStream.h"
+#endif
+
+
+//******************************************************************************
+//  Function declarations
+//******************************************************************************
+
+// Morton code of a point of the unit cube on 30 bits (see BVH.cxx)
+unsigned int getMortonCode(const Vec3& aPoint);
+
+// Stable parallel radix sort of 32-bit keys (see BVH.cxx)
+void radixSort(std::vector<unsigned int>& aKeySet,
+               std::vector<unsigned int>& aValueSet);
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//--------------------
+void RayStream::sort()
+//--------------------
+{
+    if (m_ray_set.empty())
+    {
+        return;
+    }
+
+    // The box of the origins, to quantise them
+    Vec3 lower_origin = m_ray_set[0].getOrigin();
+    Vec3 upper_origin = lower_origin;
+    for (unsigned int i = 1; i < m_ray_set.size(); ++i)
+    {
+        const Vec3& origin = m_ray_set[i].getOrigin();
+        for (unsigned int axis = 0; axis < 3; ++axis)
+        {
+            lower_origin[axis] = std::min(lower_origin[axis], origin[axis]);
+            upper_origin[axis] = std::max(upper_origin[axis], origin[axis]);
+        }
+    }
+
+    Vec3 origin_scale;
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        float extent = upper_origin[axis] - lower_origin[axis];
+        origin_scale[axis] = extent > 0.0 ? 1.0 / extent : 0.0;
+    }
+
+    // Rays that share their origin are only sorted by direction
+    if (lower_origin[0] == upper_origin[0] &&
+            lower_origin[1] == upper_origin[1] &&
+            lower_origin[2] == upper_origin[2])
+    {
+        sortByDirection();
+        return;
+    }
+
+    // The keys are made of 3 bits for the octant and 27 bits for the
+    // origin (high key), then 30 bits for the direction mapped to the unit
+    // cube (low key)
+    unsigned int size = m_ray_set.size();
+    std::vector<unsigned int> high_key_set(size);
+    std::vector<unsigned int> low_key_set(size);
+    std::vector<unsigned int> index_set(size);
+
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        const Ray& ray = m_ray_set[i];
+
+        unsigned int octant = (ray.getDirectionSign(0) << 2) | (ray.getDirectionSign(1) << 1) | ray.getDirectionSign(2);
+
+        Vec3 origin = ray.getOrigin() - lower_origin;
+        for (unsigned int axis = 0; axis < 3; ++axis)
+        {
+            origin[axis] *= origin_scale[axis];
+        }
+
+        high_key_set[i] = (octant << 27) | (getMortonCode(origin) >> 3);
+
+        Vec3 direction = (ray.getDirection() + Vec3(1.0, 1.0, 1.0)) * 0.5f;
+        low_key_set[i] = getMortonCode(direction);
+        index_set[i] = i;
+    }
+
+    // The radix sort is stable: sort by the low keys, then by the high keys
+    radixSort(low_key_set, index_set);
+
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        low_key_set[i] = high_key_set[index_set[i]];
+    }
+
+    radixSort(low_key_set, index_set);
+    reorder(index_set);
+}
+
+
+//-------------------------------
+void RayStream::sortByDirection()
+//-------------------------------
+{
+    // The octant and the direction mapped to the unit cube fit in one key
+    unsigned int size = m_ray_set.size();
+    std::vector<unsigned int> key_set(size);
+    std::vector<unsigned int> index_set(size);
+
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        const Ray& ray = m_ray_set[i];
+
+        unsigned int octant = (ray.getDirectionSign(0) << 2) | (ray.getDirectionSign(1) << 1) | ray.getDirectionSign(2);
+        Vec3 direction = (ray.getDirection() + Vec3(1.0, 1.0, 1.0)) * 0.5f;
+
+        key_set[i] = (octant << 27) | (getMortonCode(direction) >> 3);
+        index_set[i] = i;
+    }
+
+    radixSort(key_set, index_set);
+    reorder(index_set);
+}
+
+
+//---------------------------------------------------------------------
+void RayStream::reorder(const std::vector<unsigned int>& anIndexSet)
+//---------------------------------------------------------------------
+{
+    // Reorder the rays and their IDs
+    unsigned int size = m_ray_set.size();
+    std::vector<Ray> ray_set;
+    std::vector<unsigned int> id_set;
+    ray_set.reserve(size);
+    id_set.reserve(size);
+
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        ray_set.push_back(m_ray_set[anIndexSet[i]]);
+        id_set.push_back(m_id_set[anIndexSet[i]]);
+    }
+
+    m_ray_set.swap(ray_set);
+    m_id_set.swap(id_set);
+}
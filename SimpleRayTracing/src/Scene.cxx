@@ -0,0 +1,549 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       Scene.cxx
+*
+*   @brief      Class to manipulate a scene made of instanced triangle meshes.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#include <limits>    // for inf
+#include <algorithm> // for min/max
+#include <stdexcept> // for exceptions
+
+#ifndef __Scene_h
+#include "Scene.h"
+#endif
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//----------------------------------------------------
+unsigned int Scene::addMesh(const TriangleMesh& aMesh)
+//----------------------------------------------------
+{
+    m_mesh_set.push_back(aMesh);
+
+    return m_mesh_set.size() - 1;
+}
+
+
+//----------------------------------------------------------
+unsigned int Scene::addInstance(unsigned int aMeshId,
+                                const Transform& aTransform)
+//----------------------------------------------------------
+{
+    if (aMeshId >= m_mesh_set.size())
+    {
+        throw std::out_of_range("Invalid mesh ID");
+    }
+
+    m_instance_set.push_back(Instance(aMeshId, aTransform));
+    m_instance_lower_bbox_corner_set.push_back(Vec3());
+    m_instance_upper_bbox_corner_set.push_back(Vec3());
+
+    computeInstanceBBox(m_instance_set.size() - 1);
+
+    return m_instance_set.size() - 1;
+}
+
+
+//-----------------
+void Scene::build()
+//-----------------
+{
+    for (unsigned int i = 0; i < m_instance_set.size(); ++i)
+    {
+        computeInstanceBBox(i);
+    }
+
+    m_bvh.build(m_instance_lower_bbox_corner_set, m_instance_upper_bbox_corner_set);
+}
+
+
+//----------------------------------------------------
+bool Scene::intersect(const Ray& aRay,
+                      float& t,
+                      unsigned int& anInstanceId,
+                      unsigned int& aTriangleId) const
+//----------------------------------------------------
+{
+    // The barycentric coordinates are dropped
+    float u;
+    float v;
+    return intersect(aRay, t, u, v, anInstanceId, aTriangleId);
+}
+
+
+//----------------------------------------------------
+bool Scene::intersect(const Ray& aRay,
+                      float& t,
+                      float& u,
+                      float& v,
+                      unsigned int& anInstanceId,
+                      unsigned int& aTriangleId) const
+//----------------------------------------------------
+{
+    const std::vector<TriangleMesh>& mesh_set = m_mesh_set;
+    const std::vector<Instance>& instance_set = m_instance_set;
+
+    // The barycentric coordinates are the same in the mesh's coordinate
+    // system, they are kept for the last instance that is hit (the closest)
+    return m_bvh.intersect(aRay,
+            [&mesh_set, &instance_set, &u, &v, &aTriangleId](const Ray& aRay, unsigned int anInstanceId, float& t)
+            {
+                const Instance& instance = instance_set[anInstanceId];
+                const TriangleMesh& mesh = mesh_set[instance.getMeshId()];
+
+                float object_t;
+                unsigned int triangle_id;
+
+                // No need to transform the ray
+                if (instance.isIdentity())
+                {
+                    if (mesh.intersect(aRay, object_t, u, v, triangle_id))
+                    {
+                        t = object_t;
+                        aTriangleId = triangle_id;
+                        return true;
+                    }
+                }
+                // Intersect the mesh in its own coordinate system
+                // (the ray's interval is transformed too, so only the
+                // intersections closer than the closest one so far are found)
+                else
+                {
+                    float scale;
+                    Ray object_ray = instance.transformRay(aRay, scale);
+
+                    if (mesh.intersect(object_ray, object_t, u, v, triangle_id))
+                    {
+                        t = object_t / scale;
+                        aTriangleId = triangle_id;
+                        return true;
+                    }
+                }
+
+                return false;
+            },
+            t, anInstanceId);
+}
+
+
+//-----------------------------------------------------
+bool Scene::intersect(const Ray& aRay, Hit& aHit) const
+//-----------------------------------------------------
+{
+    return intersect(aRay,
+            aHit.m_t,
+            aHit.m_u,
+            aHit.m_v,
+            aHit.m_instance_id,
+            aHit.m_triangle_id);
+}
+
+
+//----------------------------------------------
+void Scene::intersect(RayPacket& aPacket) const
+//----------------------------------------------
+{
+    if (!aPacket.isCoherent())
+    {
+        for (unsigned int i = 0; i < aPacket.getSize(); ++i)
+        {
+            float t;
+            float u;
+            float v;
+            unsigned int instance_id;
+            unsigned int triangle_id;
+            if (intersect(aPacket.getRay(i), t, u, v, instance_id, triangle_id))
+            {
+                aPacket.setHit(i, t, u, v, triangle_id);
+                aPacket.setInstanceId(i, instance_id);
+            }
+        }
+        return;
+    }
+
+    const std::vector<TriangleMesh>& mesh_set = m_mesh_set;
+    const std::vector<Instance>& instance_set = m_instance_set;
+
+    m_bvh.intersect(aPacket,
+            [&mesh_set, &instance_set](RayPacket& aPacket, unsigned int anInstanceId, unsigned int aFirstRay)
+            {
+                const Instance& instance = instance_set[anInstanceId];
+                const TriangleMesh& mesh = mesh_set[instance.getMeshId()];
+
+                // No need to transform the rays, the instance ID is recorded
+                // for the rays whose interval shrank
+                if (instance.isIdentity())
+                {
+                    float t_max[RayPacket::MAX_SIZE];
+                    for (unsigned int i = aFirstRay; i < aPacket.getSize(); ++i)
+                    {
+                        t_max[i] = aPacket.getTMax(i);
+                    }
+
+                    mesh.intersect(aPacket);
+
+                    for (unsigned int i = aFirstRay; i < aPacket.getSize(); ++i)
+                    {
+                        if (aPacket.getTMax(i) != t_max[i])
+                        {
+                            aPacket.setInstanceId(i, anInstanceId);
+                        }
+                    }
+                }
+                // Intersect the mesh with a packet of rays in its own
+                // coordinate system
+                else
+                {
+                    RayPacket object_packet;
+                    float scale[RayPacket::MAX_SIZE];
+                    for (unsigned int i = 0; i < aPacket.getSize(); ++i)
+                    {
+                        object_packet.addRay(instance.transformRay(aPacket.getRay(i), scale[i]));
+                    }
+
+                    mesh.intersect(object_packet);
+
+                    for (unsigned int i = 0; i < aPacket.getSize(); ++i)
+                    {
+                        if (object_packet.hasHit(i))
+                        {
+                            aPacket.setHit(i,
+                                    object_packet.getT(i) / scale[i],
+                                    object_packet.getU(i),
+                                    object_packet.getV(i),
+                                    object_packet.getPrimitiveId(i));
+                            aPacket.setInstanceId(i, anInstanceId);
+                        }
+                    }
+                }
+            });
+}
+
+
+//---------------------------------------------
+void Scene::intersect(RayStream& aStream) const
+//---------------------------------------------
+{
+    // The stream is sorted, consecutive rays are likely to be coherent
+    RayPacket packet;
+    for (unsigned int first_ray = 0; first_ray < aStream.getSize(); first_ray += RayPacket::MAX_SIZE)
+    {
+        unsigned int last_ray = std::min(first_ray + RayPacket::MAX_SIZE, (unsigned int)aStream.getSize());
+
+        packet.clear();
+        for (unsigned int i = first_ray; i < last_ray; ++i)
+        {
+            packet.addRay(aStream.getRay(i));
+        }
+
+        intersect(packet);
+
+        for (unsigned int i = first_ray; i < last_ray; ++i)
+        {
+            if (packet.hasHit(i - first_ray))
+            {
+                aStream.setHit(i,
+                        packet.getT(i - first_ray),
+                        packet.getU(i - first_ray),
+                        packet.getV(i - first_ray),
+                        packet.getInstanceId(i - first_ray),
+                        packet.getPrimitiveId(i - first_ray));
+            }
+        }
+    }
+}
+
+
+//-----------------------------------------
+bool Scene::occluded(const Ray& aRay) const
+//-----------------------------------------
+{
+    unsigned int instance_id;
+    unsigned int triangle_id;
+    return occluded(aRay, instance_id, triangle_id);
+}
+
+
+//---------------------------------------------------
+bool Scene::occluded(const Ray& aRay,
+                     unsigned int& anInstanceId,
+                     unsigned int& aTriangleId) const
+//---------------------------------------------------
+{
+    const std::vector<TriangleMesh>& mesh_set = m_mesh_set;
+    const std::vector<Instance>& instance_set = m_instance_set;
+
+    return m_bvh.occluded(aRay,
+            [&mesh_set, &instance_set, &anInstanceId, &aTriangleId](const Ray& aRay, unsigned int aPrimitiveId)
+            {
+                const Instance& instance = instance_set[aPrimitiveId];
+                const TriangleMesh& mesh = mesh_set[instance.getMeshId()];
+
+                // No need to transform the ray
+                bool occluded = false;
+                if (instance.isIdentity())
+                {
+                    occluded = mesh.occluded(aRay, aTriangleId);
+                }
+                // Test the mesh in its own coordinate system
+                else
+                {
+                    float scale;
+                    Ray object_ray = instance.transformRay(aRay, scale);
+
+                    occluded = mesh.occluded(object_ray, aTriangleId);
+                }
+
+                if (occluded)
+                {
+                    anInstanceId = aPrimitiveId;
+                }
+
+                return occluded;
+            });
+}
+
+
+//----------------------------------------------------------------
+bool Scene::occluded(const Ray& aRay, OccluderCache& aCache) const
+//----------------------------------------------------------------
+{
+    // Test the last occluder first
+    if (aCache.hasOccluder() &&
+            intersectTriangle(aRay, aCache.getInstanceId(), aCache.getTriangleId()))
+    {
+        aCache.addQuery(true, true);
+        return true;
+    }
+
+    // Otherwise traverse the scene, and remember the new occluder if any
+    unsigned int instance_id;
+    unsigned int triangle_id;
+    bool is_occluded = occluded(aRay, instance_id, triangle_id);
+
+    if (is_occluded)
+    {
+        aCache.setOccluder(instance_id, triangle_id);
+    }
+
+    aCache.addQuery(is_occluded, false);
+    return is_occluded;
+}
+
+
+//--------------------------------------------
+void Scene::occluded(RayPacket& aPacket) const
+//--------------------------------------------
+{
+    if (!aPacket.isCoherent())
+    {
+        for (unsigned int i = 0; i < aPacket.getSize(); ++i)
+        {
+            if (occluded(aPacket.getRay(i)))
+            {
+                aPacket.setOccluded(i);
+            }
+        }
+        return;
+    }
+
+    const std::vector<TriangleMesh>& mesh_set = m_mesh_set;
+    const std::vector<Instance>& instance_set = m_instance_set;
+
+    m_bvh.intersect(aPacket,
+            [&mesh_set, &instance_set](RayPacket& aPacket, unsigned int anInstanceId, unsigned int aFirstRay)
+            {
+                const Instance& instance = instance_set[anInstanceId];
+                const TriangleMesh& mesh = mesh_set[instance.getMeshId()];
+
+                // No need to transform the rays
+                if (instance.isIdentity())
+                {
+                    mesh.occluded(aPacket);
+                }
+                // Test the mesh with the rays that are not occluded yet, in
+                // its own coordinate system
+                else
+                {
+                    RayPacket object_packet;
+                    unsigned int index_set[RayPacket::MAX_SIZE];
+                    for (unsigned int i = aFirstRay; i < aPacket.getSize(); ++i)
+                    {
+                        if (!aPacket.hasHit(i))
+                        {
+                            float scale;
+                            index_set[object_packet.getSize()] = i;
+                            object_packet.addRay(instance.transformRay(aPacket.getRay(i), scale));
+                        }
+                    }
+
+                    mesh.occluded(object_packet);
+
+                    for (unsigned int i = 0; i < object_packet.getSize(); ++i)
+                    {
+                        if (object_packet.hasHit(i))
+                        {
+                            aPacket.setOccluded(index_set[i]);
+                        }
+                    }
+                }
+            });
+}
+
+
+//--------------------------------------------
+void Scene::occluded(RayStream& aStream) const
+//--------------------------------------------
+{
+    // The stream is sorted, consecutive rays are likely to be coherent
+    RayPacket packet;
+    for (unsigned int first_ray = 0; first_ray < aStream.getSize(); first_ray += RayPacket::MAX_SIZE)
+    {
+        unsigned int last_ray = std::min(first_ray + RayPacket::MAX_SIZE, (unsigned int)aStream.getSize());
+
+        packet.clear();
+        for (unsigned int i = first_ray; i < last_ray; ++i)
+        {
+            packet.addRay(aStream.getRay(i));
+        }
+
+        occluded(packet);
+
+        for (unsigned int i = first_ray; i < last_ray; ++i)
+        {
+            if (packet.hasHit(i - first_ray))
+            {
+                aStream.setOccluded(i);
+            }
+        }
+    }
+}
+
+
+//-----------------------------------------------------------
+bool Scene::intersectTriangle(const Ray& aRay,
+                              unsigned int anInstanceId,
+                              unsigned int aTriangleId) const
+//-----------------------------------------------------------
+{
+    const Instance& instance = m_instance_set[anInstanceId];
+    const TriangleRecord& record = m_mesh_set[instance.getMeshId()].getTriangleRecord(aTriangleId);
+
+    float t;
+
+    // No need to transform the ray
+    if (instance.isIdentity())
+    {
+        return aRay.intersect(record, t);
+    }
+
+    // Test the triangle in the mesh's coordinate system
+    float scale;
+    return instance.transformRay(aRay, scale).intersect(record, t);
+}
+
+
+//---------------------------------------------
+void Scene::computeInstanceBBox(unsigned int i)
+//---------------------------------------------
+{
+    const Instance& instance = m_instance_set[i];
+    const TriangleMesh& mesh = m_mesh_set[instance.getMeshId()];
+
+    const Vec3& lower = mesh.getLowerBBoxCorner();
+    const Vec3& upper = mesh.getUpperBBoxCorner();
+
+    float inf = std::numeric_limits<float>::infinity();
+    Vec3 lower_bbox_corner( inf,  inf,  inf);
+    Vec3 upper_bbox_corner(-inf, -inf, -inf);
+
+    // The mesh is empty, so is the instance
+    if (!mesh.getNumberOfTriangles())
+    {
+        m_instance_lower_bbox_corner_set[i] = lower_bbox_corner;
+        m_instance_upper_bbox_corner_set[i] = upper_bbox_corner;
+        return;
+    }
+
+    // Transform the 8 corners of the mesh's bbox
+    for (unsigned int corner = 0; corner < 8; ++corner)
+    {
+        Vec3 point(corner & 1 ? upper.getX() : lower.getX(),
+                   corner & 2 ? upper.getY() : lower.getY(),
+                   corner & 4 ? upper.getZ() : lower.getZ());
+
+        point = instance.getTransform().transformPoint(point);
+
+        for (unsigned int axis = 0; axis < 3; ++axis)
+        {
+            lower_bbox_corner[axis] = std::min(lower_bbox_corner[axis], point[axis]);
+            upper_bbox_corner[axis] = std::max(upper_bbox_corner[axis], point[axis]);
+        }
+    }
+
+    m_instance_lower_bbox_corner_set[i] = lower_bbox_corner;
+    m_instance_upper_bbox_corner_set[i] = upper_bbox_corner;
+}
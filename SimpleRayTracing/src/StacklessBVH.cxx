@@ -0,0 +1,125 @@
+/*
+
+Copyright (c) 2020, Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+http://www.fpvidal.net/
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+3. Neither the name of the Bangor University nor the names of its contributors
+may be used to endorse or promote products derived from this software without
+specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+
+/**
+********************************************************************************
+*
+*   @file       StacklessBVH.cxx
+*
+*   @brief      Class to traverse a BVH without stack using skip pointers.
+*
+*   @version    1.0
+*
+*   @date       17/10/2026
+*
+*   @author     Dr Franck P. Vidal
+*
+*   License
+*   BSD 3-Clause License.
+*
+*   For details on use and redistribution please refer
+*   to http://opensource.org/licenses/BSD-3-Clause
+*
+*   Copyright
+*   (c) by Dr Franck P. Vidal (f.vidal@bangor.ac.uk),
+*   http://www.fpvidal.net/, Oct 2026, 2026, version 1.0, BSD 3-Clause License
+*
+********************************************************************************
+*/
+
+
+//******************************************************************************
+//  Include
+//******************************************************************************
+#ifndef __StacklessBVH_h
+#include "StacklessBVH.h"
+#endif
+
+
+//******************************************************************************
+//  Method definitions
+//******************************************************************************
+
+
+//---------------------------------------
+void StacklessBVH::build(const BVH& aBVH)
+//---------------------------------------
+{
+    clear();
+
+    if (aBVH.isEmpty())
+    {
+        return;
+    }
+
+    // The leaves reference the same primitive ranges as in the binary BVH
+    m_primitive_index_set.resize(aBVH.getNumberOfPrimitiveIndices());
+    for (unsigned int i = 0; i < m_primitive_index_set.size(); ++i)
+    {
+        m_primitive_index_set[i] = aBVH.getPrimitiveIndex(i);
+    }
+
+    // Same number of nodes, only their order changes
+    m_node_set.reserve(aBVH.getNumberOfNodes());
+    thread(aBVH, 0);
+}
+
+
+//--------------------------------------------------------------------
+void StacklessBVH::thread(const BVH& aBVH, unsigned int aBinaryNodeId)
+//--------------------------------------------------------------------
+{
+    const BVHNode& binary_node = aBVH.getNode(aBinaryNodeId);
+
+    // The node is accessed by index as m_node_set may be reallocated
+    unsigned int node_id = m_node_set.size();
+
+    StacklessBVHNode node;
+    node.m_lower_bbox_corner = binary_node.m_lower_bbox_corner;
+    node.m_upper_bbox_corner = binary_node.m_upper_bbox_corner;
+    node.m_index = binary_node.m_first;
+    node.m_primitive_count = binary_node.m_primitive_count;
+    m_node_set.push_back(node);
+
+    // Store the subtrees of the children right after the node,
+    // then the skip pointer is the node that follows them
+    if (!binary_node.isLeaf())
+    {
+        thread(aBVH, binary_node.m_first);
+        thread(aBVH, binary_node.m_first + 1);
+
+        m_node_set[node_id].m_index = m_node_set.size();
+    }
+}
@@ -80,18 +80,13 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 void TriangleMesh::setGeometry(const std::vector<float>& aVertexSet)
 //------------------------------------------------------------------
 {
-	m_p_triangle_set.clear();
 	if (aVertexSet.size() % 9 == 0)
 	{
-		for (int i = 0; i < aVertexSet.size() / 9; ++i)
-		{
-			m_p_triangle_set.push_back(Triangle(
-			Vec3(aVertexSet[i * 9 + 0], aVertexSet[i * 9 + 1], aVertexSet[i * 9 + 2]),
-			Vec3(aVertexSet[i * 9 + 3], aVertexSet[i * 9 + 4], aVertexSet[i * 9 + 5]),
-			Vec3(aVertexSet[i * 9 + 6], aVertexSet[i * 9 + 7], aVertexSet[i * 9 + 8])));
-		}
+		setVertices(aVertexSet, std::vector<unsigned int>(), std::vector<float>());
 
 		computeBoundingBox();
+		computeTriangleRecords();
+		buildAccelerator();
 	}
 	else
 	{
@@ -105,22 +100,26 @@ void TriangleMesh::setGeometry(const std::vector<float>& aVertexSet,
 		                       const std::vector<unsigned int>& anIndexSet)
 //-------------------------------------------------------------------------
 {
-	m_p_triangle_set.clear();
-	if (aVertexSet.size() % 3 == 0 && anIndexSet.size() % 3 == 0)
+	setVertices(aVertexSet, anIndexSet, std::vector<float>());
+
+	computeBoundingBox();
+	computeTriangleRecords();
+	buildAccelerator();
+}
+
+
+//---------------------------------------------------------------------
+void TriangleMesh::setGeometry(const std::vector<float>& aVertexSet,
+		                       const std::vector<float>& aTextCoordSet)
+//---------------------------------------------------------------------
+{
+	if (aVertexSet.size() % 9 == 0)
 	{
-		for (int i = 0; i < anIndexSet.size() / 3; ++i)
-		{
-			unsigned int i1 = anIndexSet[i * 3 + 0];
-			unsigned int i2 = anIndexSet[i * 3 + 1];
-			unsigned int i3 = anIndexSet[i * 3 + 2];
-
-			m_p_triangle_set.push_back(Triangle(
-			Vec3(aVertexSet[i1 * 3 + 0], aVertexSet[i1 * 3 + 1], aVertexSet[i1 * 3 + 2]),
-			Vec3(aVertexSet[i2 * 3 + 0], aVertexSet[i2 * 3 + 1], aVertexSet[i2 * 3 + 2]),
-			Vec3(aVertexSet[i3 * 3 + 0], aVertexSet[i3 * 3 + 1], aVertexSet[i3 * 3 + 2])));
-		}
+		setVertices(aVertexSet, std::vector<unsigned int>(), aTextCoordSet);
 
 		computeBoundingBox();
+		computeTriangleRecords();
+		buildAccelerator();
 	}
 	else
 	{
@@ -129,98 +128,450 @@ void TriangleMesh::setGeometry(const std::vector<float>& aVertexSet,
 }
 
 
-//---------------------------------------------------------------------
+//-------------------------------------------------------------------------
 void TriangleMesh::setGeometry(const std::vector<float>& aVertexSet,
-		                       const std::vector<float>& aTextCoordSet)
-//---------------------------------------------------------------------
+		                       const std::vector<unsigned int>& anIndexSet,
+							   const std::vector<float>& aTextCoordSet)
+//-------------------------------------------------------------------------
+{
+	setVertices(aVertexSet, anIndexSet, aTextCoordSet);
+
+	computeBoundingBox();
+	computeTriangleRecords();
+	buildAccelerator();
+}
+
+
+//-------------------------------------
+void TriangleMesh::computeBoundingBox()
+//-------------------------------------
 {
-	setGeometry(aVertexSet);
-	if (aVertexSet.size() == aTextCoordSet.size())
+	float inf = std::numeric_limits<float>::infinity();
+
+	m_lower_bbox_corner = Vec3( inf,  inf,  inf);
+	m_upper_bbox_corner = Vec3(-inf, -inf, -inf);
+
+	// Only the vertices used by the triangles are bounded
+	for (unsigned int i = 0; i < getNumberOfTriangles(); ++i)
 	{
-		for (size_t i = 0; i < m_p_triangle_set.size(); ++i)
+		for (unsigned int j = 0; j < 3; ++j)
 		{
-			unsigned int i1 = i * 3 + 0;
-			unsigned int i2 = i * 3 + 1;
-			unsigned int i3 = i * 3 + 2;
+			const Vec3& vertex = getVertex(i, j);
 
-			Vec3 a(aTextCoordSet[i1 * 3 + 0], aTextCoordSet[i1 * 3 + 1], aTextCoordSet[i1 * 3 + 2]);
-			Vec3 b(aTextCoordSet[i2 * 3 + 0], aTextCoordSet[i2 * 3 + 1], aTextCoordSet[i2 * 3 + 2]);
-			Vec3 c(aTextCoordSet[i3 * 3 + 0], aTextCoordSet[i3 * 3 + 1], aTextCoordSet[i3 * 3 + 2]);
+			m_lower_bbox_corner[0] = std::min(m_lower_bbox_corner[0], vertex[0]);
+			m_lower_bbox_corner[1] = std::min(m_lower_bbox_corner[1], vertex[1]);
+			m_lower_bbox_corner[2] = std::min(m_lower_bbox_corner[2], vertex[2]);
 
-			m_p_triangle_set[i].setTextCoords(a, b, c);
+			m_upper_bbox_corner[0] = std::max(m_upper_bbox_corner[0], vertex[0]);
+			m_upper_bbox_corner[1] = std::max(m_upper_bbox_corner[1], vertex[1]);
+			m_upper_bbox_corner[2] = std::max(m_upper_bbox_corner[2], vertex[2]);
 		}
 	}
-	else
+}
+
+
+//-----------------------------------------
+void TriangleMesh::computeTriangleRecords()
+//-----------------------------------------
+{
+	int number_of_triangles = getNumberOfTriangles();
+	m_triangle_record_set.resize(number_of_triangles);
+
+	#pragma omp parallel for
+	for (int i = 0; i < number_of_triangles; ++i)
 	{
-		throw std::length_error("buffer size error");
+		TriangleRecord& record = m_triangle_record_set[i];
+		record.m_p1 = getVertex(i, 0);
+		record.m_edge1 = getVertex(i, 1) - record.m_p1;
+		record.m_edge2 = getVertex(i, 2) - record.m_p1;
+	}
+}
+
+
+//------------------------------------------------------------------------
+void TriangleMesh::setTriangles(const std::vector<Triangle>& aTriangleSet)
+//------------------------------------------------------------------------
+{
+	// The vertices of separate triangles are not shared
+	m_short_index_set.clear();
+	m_index_set.clear();
+
+	m_vertex_set.resize(aTriangleSet.size() * 3);
+	m_text_coord_set.resize(aTriangleSet.size() * 3);
+
+	for (size_t i = 0; i < aTriangleSet.size(); ++i)
+	{
+		m_vertex_set[i * 3 + 0] = aTriangleSet[i].getP1();
+		m_vertex_set[i * 3 + 1] = aTriangleSet[i].getP2();
+		m_vertex_set[i * 3 + 2] = aTriangleSet[i].getP3();
+
+		m_text_coord_set[i * 3 + 0] = aTriangleSet[i].getTextCoord1();
+		m_text_coord_set[i * 3 + 1] = aTriangleSet[i].getTextCoord2();
+		m_text_coord_set[i * 3 + 2] = aTriangleSet[i].getTextCoord3();
 	}
 }
 
 
 //-------------------------------------------------------------------------
-void TriangleMesh::setGeometry(const std::vector<float>& aVertexSet,
+void TriangleMesh::setVertices(const std::vector<float>& aVertexSet,
 		                       const std::vector<unsigned int>& anIndexSet,
-							   const std::vector<float>& aTextCoordSet)
+		                       const std::vector<float>& aTextCoordSet)
 //-------------------------------------------------------------------------
 {
-	setGeometry(aVertexSet, anIndexSet);
-	if (aVertexSet.size() == aTextCoordSet.size())
+	// There is one texture coordinate per vertex, if any
+	if (aVertexSet.size() % 3 != 0 || anIndexSet.size() % 3 != 0 ||
+			(aTextCoordSet.size() && aTextCoordSet.size() != aVertexSet.size()))
+	{
+		throw std::length_error("buffer size error");
+	}
+
+	size_t number_of_vertices = aVertexSet.size() / 3;
+	for (size_t i = 0; i < anIndexSet.size(); ++i)
 	{
-		for (int i = 0; i < anIndexSet.size() / 3; ++i)
+		if (anIndexSet[i] >= number_of_vertices)
 		{
-			unsigned int i1 = anIndexSet[i * 3 + 0];
-			unsigned int i2 = anIndexSet[i * 3 + 1];
-			unsigned int i3 = anIndexSet[i * 3 + 2];
+			throw std::out_of_range("vertex index out of range");
+		}
+	}
 
-			Vec3 a(aTextCoordSet[i1 * 3 + 0], aTextCoordSet[i1 * 3 + 1], aTextCoordSet[i1 * 3 + 2]);
-			Vec3 b(aTextCoordSet[i2 * 3 + 0], aTextCoordSet[i2 * 3 + 1], aTextCoordSet[i2 * 3 + 2]);
-			Vec3 c(aTextCoordSet[i3 * 3 + 0], aTextCoordSet[i3 * 3 + 1], aTextCoordSet[i3 * 3 + 2]);
+	m_vertex_set.resize(number_of_vertices);
+	m_text_coord_set.resize(aTextCoordSet.size() / 3);
 
-			m_p_triangle_set[i].setTextCoords(a, b, c);
-		}
+	for (size_t i = 0; i < m_vertex_set.size(); ++i)
+	{
+		m_vertex_set[i] = Vec3(aVertexSet[i * 3 + 0], aVertexSet[i * 3 + 1], aVertexSet[i * 3 + 2]);
+	}
+
+	for (size_t i = 0; i < m_text_coord_set.size(); ++i)
+	{
+		m_text_coord_set[i] = Vec3(aTextCoordSet[i * 3 + 0], aTextCoordSet[i * 3 + 1], aTextCoordSet[i * 3 + 2]);
+	}
+
+	// The indices are halved when they fit in 16 bits
+	m_short_index_set.clear();
+	m_index_set.clear();
+
+	if (number_of_vertices <= size_t(std::numeric_limits<unsigned short>::max()) + 1)
+	{
+		m_short_index_set.assign(anIndexSet.begin(), anIndexSet.end());
 	}
 	else
+	{
+		m_index_set = anIndexSet;
+	}
+}
+
+
+//----------------------------------------
+void TriangleMesh::setBVH(const BVH& aBVH)
+//----------------------------------------
+{
+	m_build_method = aBVH.getBuildMethod();
+
+	computeBoundingBox();
+	computeTriangleRecords();
+
+	if (m_accelerator == BVH_ACCELERATOR)
+	{
+		m_bvh = aBVH;
+		m_built_sah_cost = m_bvh.getSAHCost();
+		collapseBVH();
+	}
+	else
+	{
+		buildAccelerator();
+	}
+}
+
+
+//------------------------------------------------------------------------
+void TriangleMesh::getTriangles(std::vector<Triangle>& aTriangleSet) const
+//------------------------------------------------------------------------
+{
+	aTriangleSet.clear();
+	aTriangleSet.reserve(getNumberOfTriangles());
+
+	for (unsigned int i = 0; i < getNumberOfTriangles(); ++i)
+	{
+		aTriangleSet.push_back(getTriangle(i));
+	}
+}
+
+
+//---------------------------------------------------------------------
+void TriangleMesh::updateVertices(const std::vector<float>& aVertexSet)
+//---------------------------------------------------------------------
+{
+	size_t number_of_vertices = m_vertex_set.size();
+	if (aVertexSet.size() != number_of_vertices * 3)
 	{
 		throw std::length_error("buffer size error");
 	}
+
+	// The indices and the texture coordinates are kept
+	#pragma omp parallel for
+	for (size_t i = 0; i < number_of_vertices; ++i)
+	{
+		m_vertex_set[i] = Vec3(aVertexSet[i * 3 + 0], aVertexSet[i * 3 + 1], aVertexSet[i * 3 + 2]);
+	}
+
+	computeBoundingBox();
+	computeTriangleRecords();
+	updateAccelerator();
 }
 
 
-//-------------------------------------
-void TriangleMesh::computeBoundingBox()
-//-------------------------------------
+//----------------------------------------------------------------------------
+void TriangleMesh::updateVertices(const std::vector<float>& aVertexSet,
+		                          const std::vector<unsigned int>& anIndexSet)
+//----------------------------------------------------------------------------
 {
-	float inf = std::numeric_limits<float>::infinity();
+	if (anIndexSet.size() != getNumberOfTriangles() * 3)
+	{
+		throw std::length_error("buffer size error");
+	}
 
-	m_lower_bbox_corner = Vec3( inf,  inf,  inf);
-	m_upper_bbox_corner = Vec3(-inf, -inf, -inf);
+	// The BVH is refitted, the triangles must stay the same
+	for (size_t i = 0; i < anIndexSet.size(); ++i)
+	{
+		if (anIndexSet[i] != getVertexIndex(i / 3, i % 3))
+		{
+			throw std::invalid_argument("the indices differ from the ones of setGeometry");
+		}
+	}
+
+	updateVertices(aVertexSet);
+}
+
+
+//-------------------------------------------------------------------------------------
+void TriangleMesh::computeTriangleBBoxes(std::vector<Vec3>& aLowerBBoxCornerSet,
+		                                 std::vector<Vec3>& anUpperBBoxCornerSet) const
+//-------------------------------------------------------------------------------------
+{
+	int number_of_triangles = getNumberOfTriangles();
+	aLowerBBoxCornerSet.resize(number_of_triangles);
+	anUpperBBoxCornerSet.resize(number_of_triangles);
+
+	#pragma omp parallel for
+	for (int i = 0; i < number_of_triangles; ++i)
+	{
+		const Vec3& p1 = getVertex(i, 0);
+		const Vec3& p2 = getVertex(i, 1);
+		const Vec3& p3 = getVertex(i, 2);
+
+		aLowerBBoxCornerSet[i] = Vec3(
+				std::min(std::min(p1.getX(), p2.getX()), p3.getX()),
+				std::min(std::min(p1.getY(), p2.getY()), p3.getY()),
+				std::min(std::min(p1.getZ(), p2.getZ()), p3.getZ()));
+
+		anUpperBBoxCornerSet[i] = Vec3(
+				std::max(std::max(p1.getX(), p2.getX()), p3.getX()),
+				std::max(std::max(p1.getY(), p2.getY()), p3.getY()),
+				std::max(std::max(p1.getZ(), p2.getZ()), p3.getZ()));
+	}
+}
+
+
+//-----------------------------------
+void TriangleMesh::buildAccelerator()
+//-----------------------------------
+{
+	// Gather the bbox of every triangle
+	std::vector<Vec3> lower_bbox_corner_set;
+	std::vector<Vec3> upper_bbox_corner_set;
+	computeTriangleBBoxes(lower_bbox_corner_set, upper_bbox_corner_set);
+
+	// Only keep the acceleration structure that is used for the traversal
+	if (m_accelerator == BVH_ACCELERATOR)
+	{
+		m_grid.clear();
+
+		// Only the SBVH build clips the triangles
+		std::vector<Triangle> triangle_set;
+		if (m_build_method == BVH::SBVH)
+		{
+			getTriangles(triangle_set);
+		}
+
+		m_bvh.build(triangle_set,
+				lower_bbox_corner_set, upper_bbox_corner_set,
+				m_lower_bbox_corner, m_upper_bbox_corner,
+				m_build_method);
+
+		if (m_treelet_restructuring)
+		{
+			m_bvh.restructure();
+		}
+
+		m_built_sah_cost = m_bvh.getSAHCost();
+	}
+	else
+	{
+		m_bvh.clear();
+
+		m_grid.build(lower_bbox_corner_set, upper_bbox_corner_set,
+				m_lower_bbox_corner, m_upper_bbox_corner,
+				m_accelerator == HIERARCHICAL_GRID_ACCELERATOR ? 2 : 1);
+	}
+
+	collapseBVH();
+}
+
+
+//------------------------------------
+void TriangleMesh::updateAccelerator()
+//------------------------------------
+{
+	// The grids are rebuilt, their build is linear anyway
+	if (m_accelerator != BVH_ACCELERATOR || m_bvh.isEmpty())
+	{
+		buildAccelerator();
+		return;
+	}
 
-	for (std::vector<Triangle>::const_iterator ite = m_p_triangle_set.begin();
-			ite != m_p_triangle_set.end();
-			++ite)
+	std::vector<Vec3> lower_bbox_corner_set;
+	std::vector<Vec3> upper_bbox_corner_set;
+	computeTriangleBBoxes(lower_bbox_corner_set, upper_bbox_corner_set);
+
+	m_bvh.refit(lower_bbox_corner_set, upper_bbox_corner_set);
+
+	// The refitted nodes overlap more and more as the mesh deforms
+	if (m_rebuild_threshold > 0.0 &&
+			m_bvh.getSAHCost() > m_built_sah_cost * (1.0 + m_rebuild_threshold))
 	{
-		m_lower_bbox_corner[0] = std::min(m_lower_bbox_corner[0], ite->getP1()[0]);
-		m_lower_bbox_corner[1] = std::min(m_lower_bbox_corner[1], ite->getP1()[1]);
-		m_lower_bbox_corner[2] = std::min(m_lower_bbox_corner[2], ite->getP1()[2]);
+		// Only the SBVH build clips the triangles
+		std::vector<Triangle> triangle_set;
+		if (m_build_method == BVH::SBVH)
+		{
+			getTriangles(triangle_set);
+		}
+
+		m_bvh.build(triangle_set,
+				lower_bbox_corner_set, upper_bbox_corner_set,
+				m_lower_bbox_corner, m_upper_bbox_corner,
+				m_build_method);
+
+		if (m_treelet_restructuring)
+		{
+			m_bvh.restructure();
+		}
+
+		m_built_sah_cost = m_bvh.getSAHCost();
+	}
 
-		m_upper_bbox_corner[0] = std::max(m_upper_bbox_corner[0], ite->getP1()[0]);
-		m_upper_bbox_corner[1] = std::max(m_upper_bbox_corner[1], ite->getP1()[1]);
-		m_upper_bbox_corner[2] = std::max(m_upper_bbox_corner[2], ite->getP1()[2]);
+	// The wide nodes are collapsed again from the refitted binary nodes
+	collapseBVH();
+}
 
-		m_lower_bbox_corner[0] = std::min(m_lower_bbox_corner[0], ite->getP2()[0]);
-		m_lower_bbox_corner[1] = std::min(m_lower_bbox_corner[1], ite->getP2()[1]);
-		m_lower_bbox_corner[2] = std::min(m_lower_bbox_corner[2], ite->getP2()[2]);
 
-		m_upper_bbox_corner[0] = std::max(m_upper_bbox_corner[0], ite->getP2()[0]);
-		m_upper_bbox_corner[1] = std::max(m_upper_bbox_corner[1], ite->getP2()[1]);
-		m_upper_bbox_corner[2] = std::max(m_upper_bbox_corner[2], ite->getP2()[2]);
+//------------------------------
+void TriangleMesh::collapseBVH()
+//------------------------------
+{
+	// Only keep the wide BVH that is used for the traversal
+	m_bvh4.clear();
+	m_bvh8.clear();
+	m_compressed_bvh4.clear();
+	m_compressed_bvh8.clear();
+	m_stackless_bvh.clear();
+
+	// The wide BVH is collapsed from the BVH with blocks in the leaves, if any
+	buildTriangleBlocks();
+	const BVH& bvh = m_triangle_blocks ? m_block_bvh : m_bvh;
+
+	if (m_bvh_width == 2 && m_stackless_traversal)
+	{
+		m_stackless_bvh.build(bvh);
+	}
+	else if (m_bvh_width == 4)
+	{
+		m_bvh4.build(bvh);
 
-		m_lower_bbox_corner[0] = std::min(m_lower_bbox_corner[0], ite->getP3()[0]);
-		m_lower_bbox_corner[1] = std::min(m_lower_bbox_corner[1], ite->getP3()[1]);
-		m_lower_bbox_corner[2] = std::min(m_lower_bbox_corner[2], ite->getP3()[2]);
+		if (m_bvh_compression)
+		{
+			m_compressed_bvh4.build(m_bvh4);
+			m_bvh4.clear();
+		}
+	}
+	else if (m_bvh_width == 8)
+	{
+		m_bvh8.build(bvh);
 
-		m_upper_bbox_corner[0] = std::max(m_upper_bbox_corner[0], ite->getP3()[0]);
-		m_upper_bbox_corner[1] = std::max(m_upper_bbox_corner[1], ite->getP3()[1]);
-		m_upper_bbox_corner[2] = std::max(m_upper_bbox_corner[2], ite->getP3()[2]);
+		if (m_bvh_compression)
+		{
+			m_compressed_bvh8.build(m_bvh8);
+			m_bvh8.clear();
+		}
+	}
+}
+
+
+//--------------------------------------
+void TriangleMesh::buildTriangleBlocks()
+//--------------------------------------
+{
+	m_block_bvh.clear();
+	m_triangle_block_set.clear();
+
+	if (!m_triangle_blocks || m_bvh.isEmpty())
+	{
+		return;
+	}
+
+	// The small subtrees become leaves of whole blocks
+	std::vector<unsigned int> block_triangle_id_set;
+	m_block_bvh = m_bvh;
+	m_block_bvh.groupPrimitivesIntoBlocks(TRIANGLE_BLOCK_SIZE, block_triangle_id_set);
+
+	int number_of_blocks = block_triangle_id_set.size() / TRIANGLE_BLOCK_SIZE;
+	m_triangle_block_set.resize(number_of_blocks);
+
+	#pragma omp parallel for
+	for (int i = 0; i < number_of_blocks; ++i)
+	{
+		for (unsigned int j = 0; j < TRIANGLE_BLOCK_SIZE; ++j)
+		{
+			unsigned int triangle_id = block_triangle_id_set[i * TRIANGLE_BLOCK_SIZE + j];
+
+			if (triangle_id == BVH::NO_PRIMITIVE)
+			{
+				m_triangle_block_set[i].clearTriangle(j);
+			}
+			else
+			{
+				m_triangle_block_set[i].setTriangle(j, m_triangle_record_set[triangle_id], triangle_id);
+			}
+		}
+	}
+}
+
+
+//--------------------------------------------
+size_t TriangleMesh::getNodeMemorySize() const
+//--------------------------------------------
+{
+	if (m_accelerator != BVH_ACCELERATOR)
+	{
+		return m_grid.getNumberOfGrids() * sizeof(GridLevel) +
+				m_grid.getNumberOfCells() * sizeof(GridCell);
+	}
+
+	switch (m_bvh_width)
+	{
+	case 4:
+		return m_bvh_compression ?
+				m_compressed_bvh4.getNumberOfNodes() * sizeof(CompressedWideBVHNode<4>) :
+				m_bvh4.getNumberOfNodes() * sizeof(WideBVHNode<4>);
+
+	case 8:
+		return m_bvh_compression ?
+				m_compressed_bvh8.getNumberOfNodes() * sizeof(CompressedWideBVHNode<8>) :
+				m_bvh8.getNumberOfNodes() * sizeof(WideBVHNode<8>);
+
+	default:
+		return m_stackless_traversal ?
+				m_stackless_bvh.getNumberOfNodes() * sizeof(StacklessBVHNode) :
+				(m_triangle_blocks ? m_block_bvh : m_bvh).getNumberOfNodes() * sizeof(BVHNode);
 	}
 }
@@ -35,9 +35,9 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /**
 ********************************************************************************
 *
-*   @file       main.cxx
+*   @file       main-pthreads.cxx
 *
-*   @brief      A simple ray-tracer without parallelism.
+*   @brief      A simple ray-tracer parallelised with POSIX threads.
 *
 *   @version    1.0
 *
@@ -70,16 +70,16 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdexcept> // for exceptions
 #include <sstream>   // to format error messages
 #include <string>
+#include <chrono>    // for the rendering time
+#include <cstdio>    // to save the depth map
+#include <vector>
+
+#include <pthread.h>
 
 #include <assimp/Importer.hpp>  // C++ importer interface
 #include <assimp/scene.h>       // Output data structure
 #include <assimp/postprocess.h> // Post processing flags
 
-#include<pthread.h>
-#include<vector>
-#include<mutex>
-
-
 #ifndef __Vec3_h
 #include "Vec3.h"
 #endif
@@ -96,6 +96,18 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "TriangleMesh.h"
 #endif
 
+#ifndef __Scene_h
+#include "Scene.h"
+#endif
+
+#ifndef __Hit_h
+#include "Hit.h"
+#endif
+
+#ifndef __OccluderCache_h
+#include "OccluderCache.h"
+#endif
+
 #ifndef __Material_h
 #include "Material.h"
 #endif
@@ -111,6 +123,40 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 using namespace std;
 
 
+//******************************************************************************
+//  Type definitions
+//******************************************************************************
+
+/// The data shared with a rendering thread
+struct RenderThreadData
+{
+    /// The image, each thread writes its own rows
+    Image* m_p_output_image;
+
+    const Scene* m_p_scene;
+    const Light* m_p_light;
+
+    Vec3 m_detector_position;
+    Vec3 m_ray_origin;
+    Vec3 m_up_vector;
+    Vec3 m_right_vector;
+
+    /// The depth map of the whole image, each thread writes its own rows
+    /// (0 if it is not requested)
+    float* m_p_depth_map;
+
+    float m_pixel_spacing[2];
+    float m_shadow_bias;
+
+    /// The rows rendered by the thread, from m_first_row to m_last_row - 1
+    unsigned int m_first_row;
+    unsigned int m_last_row;
+
+    /// The counters of the thread's occluder cache, set when it ends
+    OccluderCache m_occluder_cache;
+};
+
+
 //******************************************************************************
 //  Function declarations
 //******************************************************************************
@@ -118,8 +164,12 @@ void showUsage(const std::string& aProgramName);
 
 void processCmd(int argc, char** argv,
                 string& aFileName,
+                string& aDepthFileName,
                 unsigned int& aWidth, unsigned int& aHeight,
-                unsigned char& r, unsigned char& g, unsigned char& b, unsigned int& t);
+                unsigned char& r, unsigned char& g, unsigned char& b, unsigned int& t,
+                unsigned int& aBVHWidth,
+                bool& aStacklessFlag,
+                bool& aTriangleBlockFlag);
 
 Vec3 applyShading(const Light& aLight,
                   const Material& aMaterial,
@@ -128,48 +178,32 @@ Vec3 applyShading(const Light& aLight,
                   const Vec3& aViewPosition);
 
 void loadMeshes(const std::string& aFileName,
-                vector<TriangleMesh>& aMeshSet);
+                Scene& aScene,
+                unsigned int aBVHWidth);
 
 TriangleMesh createBackground(const Vec3& anUpperBBoxCorner,
                               const Vec3& aLowerBBoxCorner);
 
-void getBBox(const vector<TriangleMesh>& aMeshSet,
+void getBBox(const Scene& aScene,
              Vec3& anUpperBBoxCorner,
              Vec3& aLowerBBoxCorner);
 
 void renderLoop(Image& anOutputImage,
-                const vector<TriangleMesh>& aTriangleMeshSet,
+                const Scene& aScene,
                 const Vec3& aDetectorPosition,
                 const Vec3& aRayOrigin,
                 const Vec3& anUpVector,
                 const Vec3& aRightVector,
-                const Light& aLight);
+                const Light& aLight,
+                unsigned int aNumberOfThreads,
+                std::vector<float>* apDepthMap);
 
+void* renderRows(void* aThreadData);
 
+void saveDepthMap(const std::string& aFileName,
+                  unsigned int aWidth, unsigned int aHeight,
+                  const std::vector<float>& aDepthMap);
 
-void* renderPartialImage(void* arg) {
-    RenderThreadData* data = static_cast<RenderThreadData*>(arg);
-    renderLoop(*data->output_image, *data->p_mesh_set, data->detector_position, data->origin, 
-               data->up, data->right, *data->light, data->start_row, data->end_row);
-    return nullptr;
-}
-std::mutex zbuffer_mutex;
-
-// Thread callback function
-void* callback(void* params) {
-    RenderThreadData* data = (RenderThreadData*)params;
-    // Process each row assigned to this thread
-    for (int y = data->startRow; y < data->endRow; ++y) {
-        for (int x = 0; x < data->outputImage->width(); ++x) {
-            // Calculate ray and perform shading
-            // Lock z-buffer access if required
-            zbuffer_mutex.lock();
-            // Render logic here (compute color, update z-buffer)
-            zbuffer_mutex.unlock();
-        }
-    }
-    pthread_exit(0);
-}
 
 //******************************************************************************
 //  Constant global variables
@@ -186,61 +220,82 @@ const Vec3 g_blue(0, 0, 1);
 
 const Vec3 g_background_colour = g_black;
 
-//Declare a structure to hold the thread data and pass it to threads
-struct RenderThreadData {
-    int startRow;
-    int endRow;
-    Image* outputImage;
-    const std::vector<TriangleMesh>* triangleMeshSet;
-    Vec3 detectorPosition;
-    Vec3 rayOrigin;
-    Vec3 upVector;
-    Vec3 rightVector;
-    Light light;
-    float* zBuffer;
-    float pixelSpacing[2];
-};
-
 
 //-----------------------------
-int main(int argc, char** argv) {
-    try {
-        // Output file and image properties
-        std::string output_file_name = "test.jpg";
+int main(int argc, char** argv)
+//-----------------------------
+{
+    try
+    {
+        // output file
+        string output_file_name = "test.jpg";
+
+        // Depth map of the primary hits, not written if empty
+        string depth_file_name;
+
+        // Update the image size if needed
         unsigned int image_width = g_default_image_width;
         unsigned int image_height = g_default_image_height;
 
-        // Background color
-        unsigned char r = 128, g = 128, b = 128;
+        // Update the background colour if needed
+        unsigned char r = 128;
+        unsigned char g = 128;
+        unsigned char b = 128;
+
+        // Number of threads
+        unsigned int t = 4;
+
+        // Number of children per BVH node used for the traversal
+        unsigned int bvh_width = 4;
+
+        // Traverse the binary BVH with skip pointers
+        bool stackless = false;
 
-        // Number of threads (can be modified)
-        unsigned int num_threads = 4; // Set desired number of threads
+        // Test the triangles of the leaves with SIMD instructions
+        bool triangle_blocks = false;
 
-        // Process command-line arguments
-        processCmd(argc, argv, output_file_name, image_width, image_height, r, g, b, num_threads);
+        processCmd(argc, argv,
+                   output_file_name,
+                   depth_file_name,
+                   image_width, image_height,
+                   r, g, b, t,
+                   bvh_width,
+                   stackless,
+                   triangle_blocks);
+
+        // The skip pointers are only built for the binary BVH
+        if (stackless && bvh_width != 2)
+        {
+            throw std::invalid_argument("--bvh-stackless requires --bvh-width 2");
+        }
 
         // Load the polygon meshes
-        std::vector<TriangleMesh> p_mesh_set;
-        loadMeshes("./dragon.ply", p_mesh_set);
+        Scene scene;
+        loadMeshes("./dragon.ply", scene, bvh_width);
 
-        // Set material of the first mesh
+        // Change the material of the 1st mesh
         Material material(0.2 * g_red, g_green, g_blue, 1);
-        p_mesh_set[0].setMaterial(material);
+        scene.getMesh(0).setMaterial(material);
 
-        // Get scene bounding box
-        Vec3 lower_bbox_corner, upper_bbox_corner;
-        getBBox(p_mesh_set, upper_bbox_corner, lower_bbox_corner);
+        // Get the scene's bbox
+        Vec3 lower_bbox_corner;
+        Vec3 upper_bbox_corner;
 
-        // Initialize ray-tracing properties
+        getBBox(scene, upper_bbox_corner, lower_bbox_corner);
+
+        // Initialise the ray-tracer properties
         Vec3 range = upper_bbox_corner - lower_bbox_corner;
         Vec3 bbox_centre = lower_bbox_corner + range / 2.0;
+
         float diagonal = range.getLength();
 
         Vec3 up(0.0, 0.0, -1.0);
-        Vec3 origin = bbox_centre - Vec3(diagonal * 1, 0, 0);
-        Vec3 detector_position = bbox_centre + Vec3(diagonal * 0.6, 0, 0);
-        Vec3 direction = detector_position - origin;
-        direction.normalise();
+
+        Vec3 origin(bbox_centre - Vec3(diagonal * 1, 0, 0));
+        Vec3 detector_position(bbox_centre + Vec3(diagonal * 0.6, 0, 0));
+
+        Vec3 direction((detector_position - origin));
+        direction.normalize();
 
         Image output_image(image_width, image_height, r, g, b);
 
@@ -249,43 +304,54 @@ int main(int argc, char** argv) {
         light_direction.normalise();
         Light light(g_white, light_direction, light_position);
 
-        Vec3 right = direction.crossProduct(up);
-
-        // Add background mesh
-        p_mesh_set.push_back(createBackground(upper_bbox_corner, lower_bbox_corner));
+        direction.normalise();
+        Vec3 right(direction.crossProduct(up));
 
-        // Thread data array and thread handles
-        std::vector<pthread_t> threads(num_threads);
-        std::vector<RenderThreadData> thread_data(num_threads);
+        // Create a mesh that will go behing the scene (some kind of background)
+        TriangleMesh background = createBackground(upper_bbox_corner, lower_bbox_corner);
+        background.setBVHWidth(bvh_width);
+        scene.addInstance(scene.addMesh(background));
 
-        unsigned int rows_per_thread = image_height / num_threads;
-        
-        // Launch threads
-        for (unsigned int i = 0; i < num_threads; ++i) {
-            thread_data[i] = {
-                &output_image, &p_mesh_set, detector_position, origin, up, right, &light,
-                i * rows_per_thread, (i == num_threads - 1) ? image_height : (i + 1) * rows_per_thread
-            };
-            pthread_create(&threads[i], nullptr, renderPartialImage, &thread_data[i]);
+        // The traversal and the triangle blocks do not change the BVH itself
+        for (unsigned int mesh_id = 0; mesh_id < scene.getNumberOfMeshes(); ++mesh_id)
+        {
+            scene.getMesh(mesh_id).setStacklessTraversal(stackless);
+            scene.getMesh(mesh_id).setTriangleBlocks(triangle_blocks);
         }
 
-        // Join threads
-        for (unsigned int i = 0; i < num_threads; ++i) {
-            pthread_join(threads[i], nullptr);
-        }
+        // Build the BVH over the instances
+        scene.build();
 
-        // Save the rendered image
+        // Rendering loop
+        std::vector<float> depth_map;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        renderLoop(output_image, scene, detector_position, origin, up, right, light, t,
+                   depth_file_name.empty() ? 0 : &depth_map);
+        std::cout << "Rendering time with " << t << " threads: " <<
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() <<
+            " s" << std::endl;
+
+        // Save the image
         output_image.saveJPEGFile(output_file_name);
+
+        if (!depth_file_name.empty())
+        {
+            saveDepthMap(depth_file_name, image_width, image_height, depth_map);
+        }
     }
-    catch (const std::exception& e) {
+    // Catch exceptions and error messages
+    catch (const std::exception& e)
+    {
         std::cerr << "ERROR: " << e.what() << std::endl;
         return 1;
     }
-    catch (const std::string& e) {
+    catch (const std::string& e)
+    {
         std::cerr << "ERROR: " << e << std::endl;
         return 2;
     }
-    catch (const char* e) {
+    catch (const char* e)
+    {
         std::cerr << "ERROR: " << e << std::endl;
         return 3;
     }
@@ -310,6 +376,10 @@ void showUsage(const std::string& aProgramName)
         "\t-s,--size IMG_WIDTH IMG_HEIGHT\tSpecify the image size in number of pixels (default values: 2048 2048)" << endl << 
         "\t-b,--background R G B\t\tSpecify the background colour in RGB, acceptable values are between 0 and 255 (inclusive) (default values: 128 128 128)" << endl << 
         "\t-j,--jpeg FILENAME\t\tName of the JPEG file (default value: test.jpg)" << endl << 
+        "\t--depth FILENAME\t\tAlso save the distance to the closest hit of each pixel as a PFM file, infinite if none (default: no depth map)" << endl << 
+        "\t--bvh-width 2|4|8\t\tNumber of children per BVH node, 4 and 8 test the children's boxes with SSE and AVX respectively (default value: 4)" << endl << 
+        "\t--bvh-stackless\t\tTraverse the binary BVH (--bvh-width 2) with skip pointers instead of a stack" << endl << 
+        "\t--triangle-blocks\t\tPack the triangles of the BVH leaves into blocks tested at once with SIMD instructions (" << TRIANGLE_BLOCK_SIZE << " triangles per block)" << endl << 
         std::endl;
 }
 
@@ -317,9 +387,13 @@ void showUsage(const std::string& aProgramName)
 //-------------------------------------------------------------------
 void processCmd(int argc, char** argv,
                 string& aFileName,
+                string& aDepthFileName,
                 unsigned int& aWidth, unsigned int& aHeight,
                 unsigned char& r, unsigned char& g, unsigned char& b,
-                unsigned int& t)
+                unsigned int& t,
+                unsigned int& aBVHWidth,
+                bool& aStacklessFlag,
+                bool& aTriangleBlockFlag)
 //-------------------------------------------------------------------
 {
     // Process the command line
@@ -405,10 +479,23 @@ void processCmd(int argc, char** argv,
                 exit(EXIT_FAILURE);
             }
         }
-        else if (arg == "-t" || arg == "--threads")
+        else if (arg == "--depth")
         {
             ++i;
             if (i < argc)
+            {
+                aDepthFileName = argv[i];
+            }
+            else
+            {
+                showUsage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (arg == "-t" || arg == "--threads")
+        {
+            ++i;
+            if (i < argc && stoi(argv[i]) > 0)
             {
                 t = stoi(argv[i]);
             }
@@ -418,6 +505,28 @@ void processCmd(int argc, char** argv,
                 exit(EXIT_FAILURE);
             }
         }
+        else if (arg == "--bvh-width")
+        {
+            ++i;
+            if (i < argc)
+            {
+                aBVHWidth = stoi(argv[i]);
+            }
+
+            if (i >= argc || (aBVHWidth != 2 && aBVHWidth != 4 && aBVHWidth != 8))
+            {
+                showUsage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (arg == "--bvh-stackless")
+        {
+            aStacklessFlag = true;
+        }
+        else if (arg == "--triangle-blocks")
+        {
+            aTriangleBlockFlag = true;
+        }
         else
         {
             showUsage(argv[0]);
@@ -462,7 +571,8 @@ Vec3 applyShading(const Light& aLight,
 
 //---------------------------------------------
 void loadMeshes(const std::string& aFileName,
-                                vector<TriangleMesh>& aMeshSet)
+                                Scene& aScene,
+                                unsigned int aBVHWidth)
 //-----------------------------==--------------
 {
     // Create an instance of the Importer class
@@ -491,8 +601,6 @@ void loadMeshes(const std::string& aFileName,
     // Now we can access the file's contents.
     if (scene->HasMeshes())
     {
-        aMeshSet.clear();
-
         for (int mesh_id = 0; mesh_id < scene->mNumMeshes; ++mesh_id)
         {
             aiMesh* p_mesh = scene->mMeshes[mesh_id];
@@ -518,6 +626,7 @@ void loadMeshes(const std::string& aFileName,
                 material.setShininess(shininess);
 
                 mesh.setMaterial(material);
+                mesh.setBVHWidth(aBVHWidth);
 
                 // Load the vertices
                 std::vector<float> p_vertices;
@@ -541,16 +650,18 @@ void loadMeshes(const std::string& aFileName,
                 }
                 mesh.setGeometry(p_vertices, p_index_set);
             }
-            aMeshSet.push_back(mesh);
+
+            // The mesh is stored once, and placed in the scene by an instance
+            aScene.addInstance(aScene.addMesh(mesh));
         }
     }
 }
 
 
-//----------------------------------------------------------
+//-----------------------------------------------------------
 TriangleMesh createBackground(const Vec3& anUpperBBoxCorner,
                                 const Vec3& aLowerBBoxCorner)
-//----------------------------------------------------------
+//-----------------------------------------------------------
 {
     Vec3 range = anUpperBBoxCorner - aLowerBBoxCorner;
 
@@ -581,23 +692,23 @@ TriangleMesh createBackground(const Vec3& anUpperBBoxCorner,
 }
 
 
-//------------------------------------------------
-void getBBox(const vector<TriangleMesh>& aMeshSet,
+//-----------------------------------------------
+void getBBox(const Scene& aScene,
                          Vec3& anUpperBBoxCorner,
                          Vec3& aLowerBBoxCorner)
-//------------------------------------------------
+//-----------------------------------------------
 {
     float inf = std::numeric_limits<float>::infinity();
 
     aLowerBBoxCorner = Vec3( inf,  inf,  inf);
     anUpperBBoxCorner = Vec3(-inf, -inf, -inf);
 
-    for (std::vector<TriangleMesh>::const_iterator ite = aMeshSet.begin();
-            ite != aMeshSet.end();
-            ++ite)
+    for (unsigned int instance_id = 0;
+            instance_id < aScene.getNumberOfInstances();
+            ++instance_id)
     {
-        Vec3 mesh_lower_bbox_corner = ite->getLowerBBoxCorner();
-        Vec3 mesh_upper_bbox_corner = ite->getUpperBBoxCorner();
+        Vec3 mesh_lower_bbox_corner = aScene.getInstanceLowerBBoxCorner(instance_id);
+        Vec3 mesh_upper_bbox_corner = aScene.getInstanceUpperBBoxCorner(instance_id);
 
         aLowerBBoxCorner[0] = std::min(aLowerBBoxCorner[0], mesh_lower_bbox_corner[0]);
         aLowerBBoxCorner[1] = std::min(aLowerBBoxCorner[1], mesh_lower_bbox_corner[1]);
@@ -609,115 +720,280 @@ void getBBox(const vector<TriangleMesh>& aMeshSet,
     }
 }
 
-// Thread function to process a subset of rows
-void* renderThreadFunc(void* arg) {
-    RenderThreadData* data = static_cast<RenderThreadData*>(arg);
-    int width = data->outputImage->getWidth();
 
-    for (int row = data->startRow; row < data->endRow; ++row) {
-        for (int col = 0; col < width; ++col) {
-            // Calculate pixel offsets
-            float v_offset = data->pixelSpacing[1] * (0.5 + row - data->outputImage->getHeight() / 2.0);
-            float u_offset = data->pixelSpacing[0] * (0.5 + col - data->outputImage->getWidth() / 2.0);
+//--------------------------------------------
+void renderLoop(Image& anOutputImage,
+                const Scene& aScene,
+                const Vec3& aDetectorPosition,
+                const Vec3& aRayOrigin,
+                const Vec3& anUpVector,
+                const Vec3& aRightVector,
+                const Light& aLight,
+                unsigned int aNumberOfThreads,
+                std::vector<float>* apDepthMap)
+//--------------------------------------------
+{
+    // Initialise some parameters
+    Vec3 upper_bbox_corner;
+    Vec3 lower_bbox_corner;
+    getBBox(aScene, upper_bbox_corner, lower_bbox_corner);
+
+    // Initialise the ray-tracer properties
+    Vec3 range = upper_bbox_corner - lower_bbox_corner;
+
+    float res1 = range[2] / anOutputImage.getWidth();
+    float res2 = range[1] / anOutputImage.getHeight();
+
+    // Each pixel is only traced once, the closest hit of its ray is all
+    // that is needed. The depth map is only filled if it is requested
+    if (apDepthMap)
+    {
+        apDepthMap->assign(anOutputImage.getWidth() * anOutputImage.getHeight(), std::numeric_limits<float>::infinity());
+    }
+
+    // The rows are split evenly between the threads. Each thread only
+    // writes its own rows of the image and of the depth map, no lock is needed
+    std::vector<pthread_t> thread_set(aNumberOfThreads);
+    std::vector<RenderThreadData> thread_data_set(aNumberOfThreads);
+    unsigned int number_of_threads_created = 0;
 
-            // Initialize ray direction
-            Vec3 direction = data->detectorPosition + data->upVector * v_offset + data->rightVector * u_offset - data->rayOrigin;
+    for (unsigned int i = 0; i < aNumberOfThreads; ++i)
+    {
+        RenderThreadData& data = thread_data_set[i];
+
+        data.m_p_output_image = &anOutputImage;
+        data.m_p_scene = &aScene;
+        data.m_p_light = &aLight;
+        data.m_detector_position = aDetectorPosition;
+        data.m_ray_origin = aRayOrigin;
+        data.m_up_vector = anUpVector;
+        data.m_right_vector = aRightVector;
+        data.m_p_depth_map = apDepthMap ? &(*apDepthMap)[0] : 0;
+        data.m_pixel_spacing[0] = 2 * std::max(res1, res2);
+        data.m_pixel_spacing[1] = 2 * std::max(res1, res2);
+
+        // Offset of the shadow rays, relative to the size of the scene
+        data.m_shadow_bias = 1.0e-5 * range.getLength();
+
+        data.m_first_row = i * anOutputImage.getHeight() / aNumberOfThreads;
+        data.m_last_row = (i + 1) * anOutputImage.getHeight() / aNumberOfThreads;
+
+        if (pthread_create(&thread_set[i], 0, renderRows, &data))
+        {
+            break;
+        }
+
+        ++number_of_threads_created;
+    }
+
+    // Wait for all the rows. The threads that are running read the data
+    // and write the image, they must end before any error is reported
+    OccluderCache occluder_cache;
+    for (unsigned int i = 0; i < number_of_threads_created; ++i)
+    {
+        pthread_join(thread_set[i], 0);
+        occluder_cache.addCounters(thread_data_set[i].m_occluder_cache);
+    }
+
+    if (number_of_threads_created < aNumberOfThreads)
+    {
+        throw std::runtime_error("Cannot create a rendering thread");
+    }
+
+    std::cout << "Occluder cache: " << occluder_cache.getNumberOfCacheHits() <<
+        " hits out of " << occluder_cache.getNumberOfQueries() << " shadow rays (" <<
+        100.0 * occluder_cache.getHitRate() << "%), " <<
+        occluder_cache.getNumberOfOccludedRays() << " occluded" << std::endl;
+}
+
+
+//---------------------------------
+void* renderRows(void* aThreadData)
+//---------------------------------
+{
+    // The traversal state lives on the thread's stack,
+    // there is no heap allocation per ray
+    RenderThreadData* p_data = static_cast<RenderThreadData*>(aThreadData);
+
+    Image& output_image = *p_data->m_p_output_image;
+    const Scene& scene = *p_data->m_p_scene;
+    const Light& light = *p_data->m_p_light;
+
+    const Vec3& detector_position = p_data->m_detector_position;
+    const Vec3& ray_origin = p_data->m_ray_origin;
+    const Vec3& up_vector = p_data->m_up_vector;
+    const Vec3& right_vector = p_data->m_right_vector;
+
+    float* p_depth_map = p_data->m_p_depth_map;
+    const float* pixel_spacing = p_data->m_pixel_spacing;
+    float shadow_bias = p_data->m_shadow_bias;
+
+    // The cache is local to the thread, and copied back at the end only,
+    // so that the threads do not write to the same cache lines
+    OccluderCache occluder_cache;
+
+    // Process the rows of the thread
+    for (unsigned int row = p_data->m_first_row; row < p_data->m_last_row; ++row)
+    {
+        // Process every column
+        for (unsigned int col = 0; col < output_image.getWidth(); ++col)
+        {
+            float v_offset = pixel_spacing[1] * (0.5 + row - output_image.getHeight() / 2.0);
+            float u_offset = pixel_spacing[0] * (0.5 + col - output_image.getWidth() / 2.0);
+
+            // Initialise the ray direction for this pixel
+            Vec3 direction = detector_position + up_vector * v_offset + right_vector * u_offset - ray_origin;
             direction.normalise();
-            Ray ray(data->rayOrigin, direction);
-
-            const TriangleMesh* intersectedObject = nullptr;
-            const Triangle* intersectedTriangle = nullptr;
-            float minT = std::numeric_limits<float>::infinity();
-
-            // Iterate over each mesh and each triangle
-            for (const auto& mesh : *data->triangleMeshSet) {
-                if (mesh.intersectBBox(ray)) {
-                    for (unsigned int triId = 0; triId < mesh.getNumberOfTriangles(); ++triId) {
-                        const Triangle& triangle = mesh.getTriangle(triId);
-                        float t;
-                        if (ray.intersect(triangle, t) && t < minT) {
-                            minT = t;
-                            intersectedObject = &mesh;
-                            intersectedTriangle = &triangle;
-                        }
-                    }
+            Ray ray(ray_origin, direction);
+
+            const Instance* p_intersected_instance = 0;
+            const TriangleMesh* p_intersected_object = 0;
+
+            // Retrieve the closest intersection in the scene if any
+            // (the BVH over the instances skips whole instances at once)
+            Hit hit;
+            bool intersect = scene.intersect(ray, hit);
+
+            // The ray interescted the scene, the hit is the closest one
+            if (intersect)
+            {
+                p_intersected_instance = &scene.getInstance(hit.m_instance_id);
+                p_intersected_object = &scene.getInstanceMesh(hit.m_instance_id);
+
+                if (p_depth_map)
+                {
+                    p_depth_map[row * output_image.getWidth() + col] = hit.m_t;
                 }
             }
 
-            // Update the pixel color if an intersection was found
-            if (intersectedObject && intersectedTriangle) {
-                int idx = row * width + col;
-                if (data->zBuffer[idx] > minT) {
-                    data->zBuffer[idx] = minT;
-                    Vec3 pointHit = ray.getOrigin() + minT * ray.getDirection();
-                    Material material = intersectedObject->getMaterial();
-                    Vec3 color = applyShading(data->light, material, intersectedTriangle->getNormal(), pointHit, ray.getOrigin());
-                    data->outputImage->setPixel(col, row, static_cast<unsigned char>(color[0]), 
-                                                       static_cast<unsigned char>(color[1]), 
-                                                       static_cast<unsigned char>(color[2]));
+            // An interesection was found
+            if (p_intersected_object)
+            {
+                float t = hit.m_t;
+                Vec3 point_hit = ray.getOrigin() + t * ray.getDirection();
+                Material material = p_intersected_object->getMaterial();
+                Vec3 normal = p_intersected_instance->transformNormal(p_intersected_object->getNormal(hit.m_triangle_id));
+                Vec3 colour = applyShading(light, material, normal, point_hit, ray.getOrigin());
+
+                unsigned char r = 0;
+                unsigned char g = 0;
+                unsigned char b = 0;
+
+                // Define the shadow ray, it stops at the light. It starts
+                // slightly away from the point so that the surface that
+                // was hit does not shadow itself
+                Vec3 shadow_ray_direction = light.getPosition() - point_hit;
+                float light_distance = shadow_ray_direction.getLength();
+                Ray shadow_ray(point_hit, shadow_ray_direction, shadow_bias, light_distance);
+
+                // Stop at the first occluder found anywhere in the scene,
+                // the thread's last occluder is tested first
+                bool is_point_in_shadow = scene.occluded(shadow_ray, occluder_cache);
+
+                // Apply soft shadows
+                if (is_point_in_shadow)
+                {
+                    colour[0] *= 0.25;
+                    colour[1] *= 0.25;
+                    colour[2] *= 0.25;
+                }
+
+                const Image& texture = p_intersected_object->getTexture();
+
+                // Use texturing
+                if (texture.getWidth() && texture.getHeight())
+                {
+                    // Interpolate the texture coordinates with the
+                    // barycentric coordinates of the intersection
+                    float u = hit.m_u;
+                    float v = hit.m_v;
+                    float w = 1.0 - u - v;
+
+                    // Getthe texel cooredinate
+                    Vec3 texel_coord(w * p_intersected_object->getTextCoord(hit.m_triangle_id, 0) +
+                            u * p_intersected_object->getTextCoord(hit.m_triangle_id, 1) +
+                            v * p_intersected_object->getTextCoord(hit.m_triangle_id, 2));
+
+                    unsigned char texel_r;
+                    unsigned char texel_g;
+                    unsigned char texel_b;
+
+                    // Retrieve the pixel value from the texture
+                    texture.getPixel(texel_coord[0] * (texture.getWidth() - 1),
+                        texel_coord[1] * (texture.getHeight() - 1),
+                        texel_r, texel_g, texel_b);
+
+                    colour[0] *= texel_r;
+                    colour[1] *= texel_g;
+                    colour[2] *= texel_b;
+
+                    // Clamp the value to the range 0 to 255
+                    if (colour[0] < 0) r = 0;
+                    else if (colour[0] > 255) r = 255;
+                    else r = int(colour[0]);
+
+                    if (colour[1] < 0) g = 0;
+                    else if (colour[1] > 255) g = 255;
+                    else g = int(colour[1]);
+
+                    if (colour[2] < 0) b = 0;
+                    else if (colour[2] > 255) b = 255;
+                    else b = int(colour[2]);
                 }
+                else
+                {
+                    // Convert from float to UCHAR and
+                    // clamp the value to the range 0 to 255
+                    if (255.0 * colour[0] < 0) r = 0;
+                    else if (255.0 * colour[0] > 255) r = 255;
+                    else r = int(255.0 * colour[0]);
+
+                    if (255.0 * colour[1] < 0) g = 0;
+                    else if (255.0 * colour[1] > 255) g = 255;
+                    else g = int(255.0 * colour[1]);
+
+                    if (255.0 * colour[2] < 0) b = 0;
+                    else if (255.0 * colour[2] > 255) b = 255;
+                    else b = int(255.0 * colour[2]);
+                }
+
+                // Update the pixel value
+                output_image.setPixel(col, row, r, g, b);
             }
         }
     }
-    pthread_exit(nullptr);
-}
 
+    p_data->m_occluder_cache = occluder_cache;
+
+    return 0;
+}
 
 
-//-------------------------------------------------------------
-// Main render loop using pthreads
-void renderLoop(Image& anOutputImage,
-                const std::vector<TriangleMesh>& aTriangleMeshSet,
-                const Vec3& aDetectorPosition,
-                const Vec3& aRayOrigin,
-                const Vec3& anUpVector,
-                const Vec3& aRightVector,
-                const Light& aLight) 
+//----------------------------------------------------------
+void saveDepthMap(const std::string& aFileName,
+                  unsigned int aWidth, unsigned int aHeight,
+                  const std::vector<float>& aDepthMap)
+//----------------------------------------------------------
 {
-    int numThreads = 32;
-    pthread_t threads[numThreads];
-    RenderThreadData threadData[numThreads];
-    float inf = std::numeric_limits<float>::infinity();
-    int height = anOutputImage.getHeight();
-    int width = anOutputImage.getWidth();
-    
-    // Bounding box calculations
-    Vec3 upper_bbox_corner, lower_bbox_corner;
-    getBBox(aTriangleMeshSet, upper_bbox_corner, lower_bbox_corner);
-    Vec3 range = upper_bbox_corner - lower_bbox_corner;
+    FILE* p_output_file(fopen(aFileName.c_str(), "wb"));
+    if (!p_output_file)
+    {
+        std::stringstream error_message;
+        error_message << "Cannot create the file " << aFileName << ", in File " << __FILE__ <<
+            ", in Function " << __FUNCTION__ <<
+            ", at Line " << __LINE__;
 
-    // Pixel spacing
-    float res1 = range[2] / width;
-    float res2 = range[1] / height;
-    float pixel_spacing[] = {2 * std::max(res1, res2), 2 * std::max(res1, res2)};
-    
-    // Initialize z-buffer
-    std::vector<float> z_buffer(width * height, inf);
-
-    int rowsPerThread = height / numThreads;
-    for (int i = 0; i < numThreads; ++i) {
-        // Set the range of rows for each thread
-        threadData[i].startRow = i * rowsPerThread;
-        threadData[i].endRow = (i == numThreads - 1) ? height : (i + 1) * rowsPerThread;
-        
-        // Set other thread data parameters
-        threadData[i].outputImage = &anOutputImage;
-        threadData[i].triangleMeshSet = &aTriangleMeshSet;
-        threadData[i].detectorPosition = aDetectorPosition;
-        threadData[i].rayOrigin = aRayOrigin;
-        threadData[i].upVector = anUpVector;
-        threadData[i].rightVector = aRightVector;
-        threadData[i].light = aLight;
-        threadData[i].zBuffer = z_buffer.data();
-        threadData[i].pixelSpacing[0] = pixel_spacing[0];
-        threadData[i].pixelSpacing[1] = pixel_spacing[1];
-        
-        // Create thread
-        pthread_create(&threads[i], nullptr, renderThreadFunc, &threadData[i]);
+        throw std::runtime_error(error_message.str());
     }
 
-    // Join threads
-    for (int i = 0; i < numThreads; ++i) {
-        pthread_join(threads[i], nullptr);
+    // Greyscale PFM: the negative scale stands for little-endian floats,
+    // the rows are stored from the bottom to the top
+    fprintf(p_output_file, "Pf\n%u %u\n-1.0\n", aWidth, aHeight);
+
+    for (unsigned int row = aHeight; row > 0; --row)
+    {
+        fwrite(&aDepthMap[(row - 1) * aWidth], sizeof(float), aWidth, p_output_file);
     }
-}
\ No newline at end of file
+
+    fclose(p_output_file);
+}
@@ -70,6 +70,16 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdexcept> // for exceptions
 #include <sstream>   // to format error messages
 #include <string>
+#include <chrono>    // for the rendering time
+#include <cstdio>    // to save the depth map
+#include <cstring>   // for memset
+
+#ifdef __linux__
+#include <linux/perf_event.h> // for the hardware counters of the benchmark
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
 
 #include <assimp/Importer.hpp>  // C++ importer interface
 #include <assimp/scene.h>       // Output data structure
@@ -87,10 +97,38 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Ray.h"
 #endif
 
+#ifndef __RayPacket_h
+#include "RayPacket.h"
+#endif
+
+#ifndef __RayStream_h
+#include "RayStream.h"
+#endif
+
 #ifndef __TriangleMesh_h
 #include "TriangleMesh.h"
 #endif
 
+#ifndef __Scene_h
+#include "Scene.h"
+#endif
+
+#ifndef __Hit_h
+#include "Hit.h"
+#endif
+
+#ifndef __GBuffer_h
+#include "GBuffer.h"
+#endif
+
+#ifndef __OccluderCache_h
+#include "OccluderCache.h"
+#endif
+
+#ifndef __MeshCache_h
+#include "MeshCache.h"
+#endif
+
 #ifndef __Material_h
 #include "Material.h"
 #endif
@@ -113,8 +151,23 @@ void showUsage(const std::string& aProgramName);
 
 void processCmd(int argc, char** argv,
                 string& aFileName,
+                string& aDepthFileName,
                 unsigned int& aWidth, unsigned int& aHeight,
-                unsigned char& r, unsigned char& g, unsigned char& b, unsigned int& t);
+                unsigned char& r, unsigned char& g, unsigned char& b, unsigned int& t,
+                BVH::BuildMethod& aBuildMethod,
+                bool& aRestructuringFlag,
+                unsigned int& aBVHWidth,
+                bool& aBVHCompression,
+                bool& aStacklessFlag,
+                bool& aTriangleBlockFlag,
+                unsigned int& aPacketSize,
+                bool& aWavefrontFlag,
+                bool& aDeferredFlag,
+                bool& aShadowPacketFlag,
+                TriangleMesh::Accelerator& anAccelerator,
+                string& aCacheDirectory,
+                bool& aBenchmarkFlag,
+                bool& aStatisticsFlag);
 
 Vec3 applyShading(const Light& aLight,
                   const Material& aMaterial,
@@ -123,22 +176,116 @@ Vec3 applyShading(const Light& aLight,
                   const Vec3& aViewPosition);
 
 void loadMeshes(const std::string& aFileName,
-                vector<TriangleMesh>& aMeshSet);
+                Scene& aScene,
+                BVH::BuildMethod aBuildMethod,
+                bool aRestructuringFlag,
+                unsigned int aBVHWidth,
+                TriangleMesh::Accelerator anAccelerator,
+                const MeshCache& aCache);
+
+void reportBVHBuild(const Scene& aScene);
+
+float getPixelSpacing(const Vec3& aRange,
+                      unsigned int aWidth, unsigned int aHeight);
+
+Ray createPrimaryRay(unsigned int aColumn, unsigned int aRow,
+                     unsigned int aWidth, unsigned int aHeight,
+                     float aPixelSpacing,
+                     const Vec3& aDetectorPosition,
+                     const Vec3& aRayOrigin,
+                     const Vec3& anUpVector,
+                     const Vec3& aRightVector);
+
+void createPrimaryRays(const Scene& aScene,
+                       unsigned int aWidth, unsigned int aHeight,
+                       const Vec3& aDetectorPosition,
+                       const Vec3& aRayOrigin,
+                       const Vec3& anUpVector,
+                       const Vec3& aRightVector,
+                       std::vector<Ray>& aRaySet);
+
+void runBenchmark(Scene& aScene,
+                  unsigned int aWidth, unsigned int aHeight,
+                  const Vec3& aDetectorPosition,
+                  const Vec3& aRayOrigin,
+                  const Vec3& anUpVector,
+                  const Vec3& aRightVector);
+
+void reportBVHStatistics(const Scene& aScene,
+                         unsigned int aWidth, unsigned int aHeight,
+                         const Vec3& aDetectorPosition,
+                         const Vec3& aRayOrigin,
+                         const Vec3& anUpVector,
+                         const Vec3& aRightVector);
+
+int openHardwareCounter(unsigned long long aConfig);
+void startHardwareCounter(int aFileDescriptor);
+long long stopHardwareCounter(int aFileDescriptor);
+
+void reportBenchmark(const std::string& aLabel,
+                     size_t aNumberOfRays,
+                     double anElapsedTime,
+                     long long aNumberOfMisses,
+                     long long aNumberOfReferences,
+                     unsigned int aNumberOfMismatches);
 
 TriangleMesh createBackground(const Vec3& anUpperBBoxCorner,
                               const Vec3& aLowerBBoxCorner);
 
-void getBBox(const vector<TriangleMesh>& aMeshSet,
+void getBBox(const Scene& aScene,
              Vec3& anUpperBBoxCorner,
              Vec3& aLowerBBoxCorner);
 
 void renderLoop(Image& anOutputImage,
-                const vector<TriangleMesh>& aTriangleMeshSet,
+                const Scene& aScene,
                 const Vec3& aDetectorPosition,
                 const Vec3& aRayOrigin,
                 const Vec3& anUpVector,
                 const Vec3& aRightVector,
-                const Light& aLight);
+                const Light& aLight,
+                unsigned int aPacketSize,
+                std::vector<float>* apDepthMap);
+
+void renderWavefront(Image& anOutputImage,
+                     const Scene& aScene,
+                     const Vec3& aDetectorPosition,
+                     const Vec3& aRayOrigin,
+                     const Vec3& anUpVector,
+                     const Vec3& aRightVector,
+                     const Light& aLight);
+
+void renderDeferred(Image& anOutputImage,
+                    const Scene& aScene,
+                    const Vec3& aDetectorPosition,
+                    const Vec3& aRayOrigin,
+                    const Vec3& anUpVector,
+                    const Vec3& aRightVector,
+                    const Light& aLight,
+                    bool aShadowPacketFlag);
+
+void shadeTile(Image& anOutputImage,
+               const Scene& aScene,
+               const GBuffer& aGBuffer,
+               const Vec3& aViewPosition,
+               const Light& aLight);
+
+Ray createShadowRay(const Light& aLight,
+                    const Vec3& aPoint,
+                    float aShadowBias);
+
+void reportOccluderCache(const OccluderCache& aCache);
+
+void saveDepthMap(const std::string& aFileName,
+                  unsigned int aWidth, unsigned int aHeight,
+                  const std::vector<float>& aDepthMap);
+
+void shadePixel(Image& anOutputImage,
+                unsigned int aColumn, unsigned int aRow,
+                const Scene& aScene,
+                const Ray& aRay,
+                const Hit& aHit,
+                const Light& aLight,
+                bool isInShadow);
 
 
 //******************************************************************************
@@ -147,6 +294,12 @@ void renderLoop(Image& anOutputImage,
 const unsigned int g_default_image_width  = 2048;
 const unsigned int g_default_image_height = 2048;
 
+// Number of pixels per batch of the wavefront renderer
+const unsigned int g_stream_size = 1 << 16;
+
+// Number of pixels per side of the tiles of the deferred renderer
+const unsigned int g_tile_size = 64;
+
 const Vec3 g_black(0, 0, 0);
 const Vec3 g_white(1, 1, 1);
 
@@ -166,6 +319,9 @@ int main(int argc, char** argv)
         // output file
         string output_file_name = "test.jpg";
 
+        // Depth map of the primary hits, not written if empty
+        string depth_file_name;
+
         // Update the image size if needed
         unsigned int image_width = g_default_image_width;
         unsigned int image_height = g_default_image_height;
@@ -178,24 +334,93 @@ int main(int argc, char** argv)
         // Number of threads
         unsigned int t = 1;
 
+        // BVH build algorithm
+        BVH::BuildMethod build_method = BVH::SAH;
+
+        // Optimise the BVH after its build
+        bool treelet_restructuring = false;
+
+        // Number of children per BVH node used for the traversal
+        unsigned int bvh_width = 4;
+
+        // Quantize the child boxes of the wide BVH
+        bool bvh_compression = false;
+
+        // Traverse the binary BVH with skip pointers
+        bool stackless = false;
+
+        // Test the triangles of the leaves with SIMD instructions
+        bool triangle_blocks = false;
+
+        // Trace the primary rays in packets of N x N rays, one by one if 0
+        unsigned int packet_size = 0;
+
+        // Trace the rays in sorted streams, one stage at a time
+        bool wavefront = false;
+
+        // Shade the tiles of pixels after their visibility pass
+        bool deferred = false;
+
+        // Trace the shadow rays of each tile as packets sorted by direction
+        bool shadow_packets = false;
+
+        // Acceleration structure of the meshes
+        TriangleMesh::Accelerator accelerator = TriangleMesh::BVH_ACCELERATOR;
+
+        // Directory of the mesh cache, no cache if empty
+        string cache_directory;
+
+        // Compare the BVH layouts instead of rendering
+        bool benchmark = false;
+
+        // Print the quality of the BVHs instead of rendering
+        bool bvh_statistics = false;
+
         processCmd(argc, argv,
                    output_file_name,
+                   depth_file_name,
                    image_width, image_height,
-                   r, g, b, t);
+                   r, g, b, t,
+                   build_method,
+                   treelet_restructuring,
+                   bvh_width,
+                   bvh_compression,
+                   stackless,
+                   triangle_blocks,
+                   packet_size,
+                   wavefront,
+                   deferred,
+                   shadow_packets,
+                   accelerator,
+                   cache_directory,
+                   benchmark,
+                   bvh_statistics);
+
+        // Only renderLoop traces the pixels one ray after the other
+        if (!depth_file_name.empty() && (wavefront || deferred || shadow_packets))
+        {
+            throw std::invalid_argument("The depth map cannot be saved with --wavefront, --deferred or --shadow-packets");
+        }
+
+        // The skip pointers are only built for the binary BVH
+        if (stackless && bvh_width != 2)
+        {
+            throw std::invalid_argument("--bvh-stackless requires --bvh-width 2");
+        }
 
         // Load the polygon meshes
-        vector<TriangleMesh> p_mesh_set;
-        loadMeshes("./dragon.ply", p_mesh_set);
+        Scene scene;
+        loadMeshes("./dragon.ply", scene, build_method, treelet_restructuring, bvh_width, accelerator, MeshCache(cache_directory));
 
         // Change the material of the 1st mesh
         Material material(0.2 * g_red, g_green, g_blue, 1);
-        p_mesh_set[0].setMaterial(material);
+        scene.getMesh(0).setMaterial(material);
 
         // Get the scene's bbox
         Vec3 lower_bbox_corner;
         Vec3 upper_bbox_corner;
 
-        getBBox(p_mesh_set, upper_bbox_corner, lower_bbox_corner);
+        getBBox(scene, upper_bbox_corner, lower_bbox_corner);
 
         // Initialise the ray-tracer properties
         Vec3 range = upper_bbox_corner - lower_bbox_corner;
@@ -222,13 +447,64 @@ int main(int argc, char** argv)
         Vec3 right(direction.crossProduct(up));
 
         // Create a mesh that will go behing the scene (some kind of background)
-        p_mesh_set.push_back(createBackground(upper_bbox_corner, lower_bbox_corner));
+        TriangleMesh background = createBackground(upper_bbox_corner, lower_bbox_corner);
+        background.setBuildMethod(build_method);
+        background.setTreeletRestructuring(treelet_restructuring);
+        background.setBVHWidth(bvh_width);
+        background.setAccelerator(accelerator);
+        scene.addInstance(scene.addMesh(background));
+
+        // The BVH width, the compression, the traversal and the triangle blocks do not change the BVH itself
+        for (unsigned int mesh_id = 0; mesh_id < scene.getNumberOfMeshes(); ++mesh_id)
+        {
+            scene.getMesh(mesh_id).setBVHCompression(bvh_compression);
+            scene.getMesh(mesh_id).setStacklessTraversal(stackless);
+            scene.getMesh(mesh_id).setTriangleBlocks(triangle_blocks);
+        }
+
+        // Build the BVH over the instances
+        scene.build();
+        reportBVHBuild(scene);
+
+        if (benchmark)
+        {
+            runBenchmark(scene, image_width, image_height, detector_position, origin, up, right);
+            return 0;
+        }
+
+        if (bvh_statistics)
+        {
+            reportBVHStatistics(scene, image_width, image_height, detector_position, origin, up, right);
+            return 0;
+        }
 
         // Rendering loop
-        renderLoop(output_image, p_mesh_set, detector_position, origin, up, right, light);
+        std::vector<float> depth_map;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (wavefront)
+        {
+            renderWavefront(output_image, scene, detector_position, origin, up, right, light);
+        }
+        else if (deferred || shadow_packets)
+        {
+            renderDeferred(output_image, scene, detector_position, origin, up, right, light, shadow_packets);
+        }
+        else
+        {
+            renderLoop(output_image, scene, detector_position, origin, up, right, light, packet_size,
+                       depth_file_name.empty() ? 0 : &depth_map);
+        }
+        std::cout << "Rendering time: " <<
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() <<
+            " s" << std::endl;
 
         // Save the image
         output_image.saveJPEGFile(output_file_name);
+
+        if (!depth_file_name.empty())
+        {
+            saveDepthMap(depth_file_name, image_width, image_height, depth_map);
+        }
     }
     // Catch exceptions and error messages
     catch (const std::exception& e)
@@ -267,6 +543,21 @@ void showUsage(const std::string& aProgramName)
         "\t-s,--size IMG_WIDTH IMG_HEIGHT\tSpecify the image size in number of pixels (default values: 2048 2048)" << endl << 
         "\t-b,--background R G B\t\tSpecify the background colour in RGB, acceptable values are between 0 and 255 (inclusive) (default values: 128 128 128)" << endl << 
         "\t-j,--jpeg FILENAME\t\tName of the JPEG file (default value: test.jpg)" << endl << 
+        "\t--depth FILENAME\t\tAlso save the distance to the closest hit of each pixel as a PFM file, infinite if none, with the default rendering or --packets only (default: no depth map)" << endl << 
+        "\t--bvh sah|lbvh|sbvh\t\tBVH build algorithm, binned SAH (slower build, faster rendering), parallel LBVH (faster build, slower rendering) or SAH with spatial splits (slowest build, fewer overlapping nodes) (default value: sah)" << endl << 
+        "\t--bvh-treelets\t\tRestructure the treelets of the BVH after the build to lower its SAH cost" << endl << 
+        "\t--bvh-width 2|4|8\t\tNumber of children per BVH node, 4 and 8 test the children's boxes with SSE and AVX respectively (default value: 4)" << endl << 
+        "\t--bvh-compression\t\tQuantize the child boxes of the BVH4 and BVH8 nodes on 8 bits" << endl << 
+        "\t--bvh-stackless\t\tTraverse the binary BVH (--bvh-width 2) with skip pointers instead of a stack" << endl << 
+        "\t--triangle-blocks\t\tPack the triangles of the BVH leaves into blocks tested at once with SIMD instructions (" << TRIANGLE_BLOCK_SIZE << " triangles per block)" << endl << 
+        "\t--packets 4|8\t\t\tTrace the primary rays of blocks of 4x4 or 8x8 pixels together, the BVH nodes outside of their frustum are culled (default: one ray at a time)" << endl << 
+        "\t--wavefront\t\t\tRender in batches of " << g_stream_size << " pixels, the primary rays, then the shadow rays are sorted and traced as streams before the shading" << endl << 
+        "\t--deferred\t\t\tRender in tiles of " << g_tile_size << "x" << g_tile_size << " pixels, a visibility pass stores the hits of a tile, then a shading pass shades its pixels by material with SIMD instructions" << endl << 
+        "\t--shadow-packets\t\tRender as with --deferred, but the shadow rays of a tile are sorted by direction and traced as packets toward the light, into a shadow mask read by the shading pass" << endl << 
+        "\t--benchmark\t\t\tCompare the BVH layouts (node bytes, cache miss rate and misses per ray, rays/s) with the primary rays instead of rendering" << endl << 
+        "\t--bvh-stats\t\t\tPrint the quality of the BVHs (SAH cost, relative to a plain SAH build for sbvh, node and leaf counts, depth and leaf size histograms, node visits per primary ray) instead of rendering" << endl << 
+        "\t--accel bvh|grid|hgrid\t\tAcceleration structure of the meshes, BVH, uniform grid or hierarchical grid (default value: bvh)" << endl << 
+        "\t--cache DIR\t\t\tDirectory of the mesh cache, the meshes and their BVH are saved there and reused by the next runs (default: no cache)" << endl << 
         std::endl;
 }
 
@@ -274,9 +565,24 @@ void showUsage(const std::string& aProgramName)
 //-------------------------------------------------------------------
 void processCmd(int argc, char** argv,
                 string& aFileName,
+                string& aDepthFileName,
                 unsigned int& aWidth, unsigned int& aHeight,
                 unsigned char& r, unsigned char& g, unsigned char& b,
-                unsigned int& t)
+                unsigned int& t,
+                BVH::BuildMethod& aBuildMethod,
+                bool& aRestructuringFlag,
+                unsigned int& aBVHWidth,
+                bool& aBVHCompression,
+                bool& aStacklessFlag,
+                bool& aTriangleBlockFlag,
+                unsigned int& aPacketSize,
+                bool& aWavefrontFlag,
+                bool& aDeferredFlag,
+                bool& aShadowPacketFlag,
+                TriangleMesh::Accelerator& anAccelerator,
+                string& aCacheDirectory,
+                bool& aBenchmarkFlag,
+                bool& aStatisticsFlag)
 //-------------------------------------------------------------------
 {
     // Process the command line
@@ -362,6 +668,19 @@ void processCmd(int argc, char** argv,
                 exit(EXIT_FAILURE);
             }
         }
+        else if (arg == "--depth")
+        {
+            ++i;
+            if (i < argc)
+            {
+                aDepthFileName = argv[i];
+            }
+            else
+            {
+                showUsage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        }
         else if (arg == "-t" || arg == "--threads")
         {
             ++i;
@@ -375,6 +694,125 @@ void processCmd(int argc, char** argv,
                 exit(EXIT_FAILURE);
             }
         }
+        else if (arg == "--bvh")
+        {
+            ++i;
+            if (i < argc && std::string(argv[i]) == "sah")
+            {
+                aBuildMethod = BVH::SAH;
+            }
+            else if (i < argc && std::string(argv[i]) == "lbvh")
+            {
+                aBuildMethod = BVH::LBVH;
+            }
+            else if (i < argc && std::string(argv[i]) == "sbvh")
+            {
+                aBuildMethod = BVH::SBVH;
+            }
+            else
+            {
+                showUsage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (arg == "--bvh-width")
+        {
+            ++i;
+            if (i < argc)
+            {
+                aBVHWidth = stoi(argv[i]);
+            }
+
+            if (i >= argc || (aBVHWidth != 2 && aBVHWidth != 4 && aBVHWidth != 8))
+            {
+                showUsage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (arg == "--bvh-compression")
+        {
+            aBVHCompression = true;
+        }
+        else if (arg == "--bvh-stackless")
+        {
+            aStacklessFlag = true;
+        }
+        else if (arg == "--triangle-blocks")
+        {
+            aTriangleBlockFlag = true;
+        }
+        else if (arg == "--packets")
+        {
+            ++i;
+            if (i < argc)
+            {
+                aPacketSize = stoi(argv[i]);
+            }
+
+            if (i >= argc || (aPacketSize != 4 && aPacketSize != 8))
+            {
+                showUsage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (arg == "--wavefront")
+        {
+            aWavefrontFlag = true;
+        }
+        else if (arg == "--deferred")
+        {
+            aDeferredFlag = true;
+        }
+        else if (arg == "--shadow-packets")
+        {
+            aShadowPacketFlag = true;
+        }
+        else if (arg == "--benchmark")
+        {
+            aBenchmarkFlag = true;
+        }
+        else if (arg == "--bvh-stats")
+        {
+            aStatisticsFlag = true;
+        }
+        else if (arg == "--bvh-treelets")
+        {
+            aRestructuringFlag = true;
+        }
+        else if (arg == "--accel")
+        {
+            ++i;
+            if (i < argc && std::string(argv[i]) == "bvh")
+            {
+                anAccelerator = TriangleMesh::BVH_ACCELERATOR;
+            }
+            else if (i < argc && std::string(argv[i]) == "grid")
+            {
+                anAccelerator = TriangleMesh::GRID_ACCELERATOR;
+            }
+            else if (i < argc && std::string(argv[i]) == "hgrid")
+            {
+                anAccelerator = TriangleMesh::HIERARCHICAL_GRID_ACCELERATOR;
+            }
+            else
+            {
+                showUsage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (arg == "--cache")
+        {
+            ++i;
+            if (i < argc)
+            {
+                aCacheDirectory = argv[i];
+            }
+            else
+            {
+                showUsage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        }
         else
         {
             showUsage(argv[0]);
@@ -419,9 +857,47 @@ Vec3 applyShading(const Light& aLight,
 
 //---------------------------------------------
 void loadMeshes(const std::string& aFileName,
-                                vector<TriangleMesh>& aMeshSet)
+                                Scene& aScene,
+                                BVH::BuildMethod aBuildMethod,
+                                bool aRestructuringFlag,
+                                unsigned int aBVHWidth,
+                                TriangleMesh::Accelerator anAccelerator,
+                                const MeshCache& aCache)
 //-----------------------------==--------------
 {
+    // Skip the import and the BVH builds if all the meshes of the file
+    // are in the cache
+    std::vector<uint64_t> key_set;
+    if (aCache.loadIndex(aFileName, key_set))
+    {
+        std::vector<TriangleMesh> mesh_set(key_set.size());
+        bool is_cached = true;
+
+        for (unsigned int mesh_id = 0; is_cached && mesh_id < key_set.size(); ++mesh_id)
+        {
+            mesh_set[mesh_id].setBuildMethod(aBuildMethod);
+            mesh_set[mesh_id].setTreeletRestructuring(aRestructuringFlag);
+            mesh_set[mesh_id].setBVHWidth(aBVHWidth);
+            mesh_set[mesh_id].setAccelerator(anAccelerator);
+            is_cached = aCache.load(key_set[mesh_id], mesh_set[mesh_id]);
+        }
+
+        if (is_cached)
+        {
+            for (unsigned int mesh_id = 0; mesh_id < mesh_set.size(); ++mesh_id)
+            {
+                aScene.addInstance(aScene.addMesh(mesh_set[mesh_id]));
+            }
+
+            std::cout << "Meshes of " << aFileName << " loaded from the cache " <<
+                aCache.getDirectory() << std::endl;
+
+            return;
+        }
+
+        key_set.clear();
+    }
+
     // Create an instance of the Importer class
     Assimp::Importer importer;
 
@@ -448,8 +924,6 @@ void loadMeshes(const std::string& aFileName,
     // Now we can access the file's contents.
     if (scene->HasMeshes())
     {
-        aMeshSet.clear();
-
         for (int mesh_id = 0; mesh_id < scene->mNumMeshes; ++mesh_id)
         {
             aiMesh* p_mesh = scene->mMeshes[mesh_id];
@@ -476,6 +950,11 @@ void loadMeshes(const std::string& aFileName,
 
                 mesh.setMaterial(material);
 
+                mesh.setBuildMethod(aBuildMethod);
+                mesh.setTreeletRestructuring(aRestructuringFlag);
+                mesh.setBVHWidth(aBVHWidth);
+                mesh.setAccelerator(anAccelerator);
+
                 // Load the vertices
                 std::vector<float> p_vertices;
                 for (unsigned int vertex_id = 0; vertex_id < p_mesh->mNumVertices; ++vertex_id)
@@ -496,283 +975,1338 @@ void loadMeshes(const std::string& aFileName,
                         p_index_set.push_back(p_mesh->mFaces[index_id].mIndices[2]);
                     }
                 }
-                mesh.setGeometry(p_vertices, p_index_set);
+                // Reuse the BVH if the same mesh is in the cache,
+                // the BVH is built when the geometry is set otherwise.
+                // The key hashes the whole geometry and the material (the
+                // cache restores both), it is only computed if there is a cache
+                if (aCache.isEnabled())
+                {
+                    uint64_t key = MeshCache::computeKey(p_vertices, p_index_set, mesh.getMaterial());
+                    if (!aCache.load(key, mesh))
+                    {
+                        mesh.setGeometry(p_vertices, p_index_set);
+                        aCache.save(key, mesh);
+                    }
+                    key_set.push_back(key);
+                }
+                else
+                {
+                    mesh.setGeometry(p_vertices, p_index_set);
+                }
             }
-            aMeshSet.push_back(mesh);
+            // Not a triangle mesh, it is kept empty
+            else if (aCache.isEnabled())
+            {
+                uint64_t key = MeshCache::computeKey(std::vector<float>(), std::vector<unsigned int>(), mesh.getMaterial());
+                aCache.save(key, mesh);
+                key_set.push_back(key);
+            }
+
+            // The mesh is stored once, and placed in the scene by an instance
+            aScene.addInstance(aScene.addMesh(mesh));
         }
     }
+
+    // The next runs will skip the import
+    aCache.saveIndex(aFileName, key_set);
 }
 
 
-//----------------------------------------------------------
-TriangleMesh createBackground(const Vec3& anUpperBBoxCorner,
-                                const Vec3& aLowerBBoxCorner)
-//----------------------------------------------------------
+//--------------------------------------
+void reportBVHBuild(const Scene& aScene)
+//--------------------------------------
 {
-    Vec3 range = anUpperBBoxCorner - aLowerBBoxCorner;
+    for (unsigned int mesh_id = 0; mesh_id < aScene.getNumberOfMeshes(); ++mesh_id)
+    {
+        const TriangleMesh& mesh = aScene.getMesh(mesh_id);
+        const BVH& bvh = mesh.getBVH();
 
-    std::vector<float> vertices = {
-        anUpperBBoxCorner[0] + range[0] * 0.1f, aLowerBBoxCorner[1] - range[1] * 0.5f, aLowerBBoxCorner[2] - range[2] * 0.5f,
-        anUpperBBoxCorner[0] + range[0] * 0.1f, anUpperBBoxCorner[1] + range[1] * 0.5f, aLowerBBoxCorner[2] - range[2] * 0.5f,
-        anUpperBBoxCorner[0] + range[0] * 0.1f, anUpperBBoxCorner[1] + range[1] * 0.5f, anUpperBBoxCorner[2] + range[2] * 0.5f,
-        anUpperBBoxCorner[0] + range[0] * 0.1f, aLowerBBoxCorner[1] - range[1] * 0.5f, anUpperBBoxCorner[2] + range[2] * 0.5f,
-    };
+        std::cout << "Mesh " << mesh_id << ": " <<
+            mesh.getNumberOfTriangles() << " triangles (" <<
+            mesh.getNumberOfVertices() << " vertices, " <<
+            (!mesh.isIndexed() ? "not indexed" : mesh.hasShortIndices() ? "16-bit indices" : "32-bit indices") << ", " <<
+            mesh.getGeometryMemorySize() / 1024 << " KB), ";
 
-    std::vector<float> text_coords = {
-        0, 1, 0,
-        1, 1, 0,
-        1, 0, 0,
-        0, 0, 0,
-    };
+        if (mesh.getAccelerator() != TriangleMesh::BVH_ACCELERATOR)
+        {
+            const Grid& grid = mesh.getGrid();
 
-    std::vector<unsigned int> indices = {
-        0, 1, 2,
-        0, 2, 3,
-    };
+            std::cout << (grid.getNumberOfLevels() > 1 ? "hierarchical grid" : "grid");
 
-    TriangleMesh background_mesh(vertices, indices, text_coords);
-    Image background_texture("background.jpg");
-    background_mesh.setTexture(background_texture);
+            if (!grid.isEmpty())
+            {
+                std::cout << " of " << grid.getGrid(0).m_resolution[0] << "x" <<
+                    grid.getGrid(0).m_resolution[1] << "x" <<
+                    grid.getGrid(0).m_resolution[2] << " cells";
+            }
 
-    return (background_mesh);
-}
+            std::cout << " (" << grid.getNumberOfGrids() << " grids, " <<
+                grid.getNumberOfCells() << " cells, " <<
+                grid.getNumberOfPrimitiveIndices() << " references) built in " <<
+                grid.getBuildTime() << " s" << std::endl;
 
+            continue;
+        }
 
-//------------------------------------------------
-void getBBox(const vector<TriangleMesh>& aMeshSet,
-                         Vec3& anUpperBBoxCorner,
-                         Vec3& aLowerBBoxCorner)
-//------------------------------------------------
-{
-    float inf = std::numeric_limits<float>::infinity();
+        std::cout << "BVH (" <<
+            (bvh.getBuildMethod() == BVH::SAH ? "SAH" : bvh.getBuildMethod() == BVH::LBVH ? "LBVH" : "SBVH") <<
+            (mesh.getTreeletRestructuring() ? ", restructured treelets" : "") << ") with " <<
+            bvh.getNumberOfNodes() << " nodes built in " <<
+            bvh.getBuildTime() << " s, SAH cost " << bvh.getSAHCost();
 
-    aLowerBBoxCorner = Vec3( inf,  inf,  inf);
-    anUpperBBoxCorner = Vec3(-inf, -inf, -inf);
+        // The cost is compared with the plain SAH build by --bvh-stats only
+        if (bvh.getBuildMethod() == BVH::SBVH)
+        {
+            std::cout << " (" << bvh.getNumberOfPrimitiveIndices() - mesh.getNumberOfTriangles() <<
+                " split references)";
+        }
 
-    for (std::vector<TriangleMesh>::const_iterator ite = aMeshSet.begin();
-            ite != aMeshSet.end();
-            ++ite)
-    {
-        Vec3 mesh_lower_bbox_corner = ite->getLowerBBoxCorner();
-        Vec3 mesh_upper_bbox_corner = ite->getUpperBBoxCorner();
+        if (mesh.getBVHWidth() == 4)
+        {
+            std::cout << ", collapsed into " <<
+                (mesh.getBVHCompression() ? mesh.getCompressedBVH4().getNumberOfNodes() : mesh.getBVH4().getNumberOfNodes()) <<
+                " BVH4 nodes";
+        }
+        else if (mesh.getBVHWidth() == 8)
+        {
+            std::cout << ", collapsed into " <<
+                (mesh.getBVHCompression() ? mesh.getCompressedBVH8().getNumberOfNodes() : mesh.getBVH8().getNumberOfNodes()) <<
+                " BVH8 nodes";
+        }
+        else if (mesh.getStacklessTraversal())
+        {
+            std::cout << ", threaded with skip pointers";
+        }
 
-        aLowerBBoxCorner[0] = std::min(aLowerBBoxCorner[0], mesh_lower_bbox_corner[0]);
-        aLowerBBoxCorner[1] = std::min(aLowerBBoxCorner[1], mesh_lower_bbox_corner[1]);
-        aLowerBBoxCorner[2] = std::min(aLowerBBoxCorner[2], mesh_lower_bbox_corner[2]);
+        std::cout << " (" << mesh.getNodeMemorySize() << " bytes" <<
+            (mesh.getBVHCompression() && mesh.getBVHWidth() != 2 ? ", 8-bit boxes)" : ")");
 
-        anUpperBBoxCorner[0] = std::max(anUpperBBoxCorner[0], mesh_upper_bbox_corner[0]);
-        anUpperBBoxCorner[1] = std::max(anUpperBBoxCorner[1], mesh_upper_bbox_corner[1]);
-        anUpperBBoxCorner[2] = std::max(anUpperBBoxCorner[2], mesh_upper_bbox_corner[2]);
+        if (mesh.getTriangleBlocks())
+        {
+            std::cout << ", " << mesh.getNumberOfTriangleBlocks() << " blocks of " <<
+                TRIANGLE_BLOCK_SIZE << " triangles";
+        }
+
+        std::cout << std::endl;
     }
+
+    std::cout << "Scene: " << aScene.getNumberOfInstances() << " instances, " <<
+        "top-level BVH built in " << aScene.getBVH().getBuildTime() << " s" << std::endl;
+}
+
+
+//--------------------------------------------------------------
+float getPixelSpacing(const Vec3& aRange,
+                      unsigned int aWidth, unsigned int aHeight)
+//--------------------------------------------------------------
+{
+    // The scene fits in the image, with a margin
+    float res1 = aRange[2] / aWidth;
+    float res2 = aRange[1] / aHeight;
+    return 2 * std::max(res1, res2);
 }
 
 
 //-------------------------------------------------------------
-void renderLoop(Image& anOutputImage,
-                  const vector<TriangleMesh>& aTriangleMeshSet,
-                  const Vec3& aDetectorPosition,
-                  const Vec3& aRayOrigin,
-                  const Vec3& anUpVector,
-                  const Vec3& aRightVector,
-                  const Light& aLight)
+Ray createPrimaryRay(unsigned int aColumn, unsigned int aRow,
+                     unsigned int aWidth, unsigned int aHeight,
+                     float aPixelSpacing,
+                     const Vec3& aDetectorPosition,
+                     const Vec3& aRayOrigin,
+                     const Vec3& anUpVector,
+                     const Vec3& aRightVector)
 //-------------------------------------------------------------
 {
-    // Initialise some parameters
-    Vec3 upper_bbox_corner;
-    Vec3 lower_bbox_corner;
-    getBBox(aTriangleMeshSet, upper_bbox_corner, lower_bbox_corner);
+    // The ray goes through the centre of the pixel on the detector
+    float v_offset = aPixelSpacing * (0.5 + aRow - aHeight / 2.0);
+    float u_offset = aPixelSpacing * (0.5 + aColumn - aWidth / 2.0);
 
-    // Initialise the ray-tracer properties
-    Vec3 range = upper_bbox_corner - lower_bbox_corner;
+    Vec3 direction = aDetectorPosition + anUpVector * v_offset + aRightVector * u_offset - aRayOrigin;
+    direction.normalise();
+    return Ray(aRayOrigin, direction);
+}
 
-    float res1 = range[2] / anOutputImage.getWidth();
-    float res2 = range[1] / anOutputImage.getHeight();
-    float pixel_spacing[] = {2 * std::max(res1, res2), 2 * std::max(res1, res2)};
 
-    // Process every row
-    float inf = std::numeric_limits<float>::infinity();
-    std::vector<float> z_buffer(anOutputImage.getWidth() * anOutputImage.getHeight(), inf);
+//---------------------------------------------------------------
+void createPrimaryRays(const Scene& aScene,
+                       unsigned int aWidth, unsigned int aHeight,
+                       const Vec3& aDetectorPosition,
+                       const Vec3& aRayOrigin,
+                       const Vec3& anUpVector,
+                       const Vec3& aRightVector,
+                       std::vector<Ray>& aRaySet)
+//---------------------------------------------------------------
+{
+    // The primary rays of renderLoop
+    Vec3 upper_bbox_corner;
+    Vec3 lower_bbox_corner;
+    getBBox(aScene, upper_bbox_corner, lower_bbox_corner);
+
+    float pixel_spacing = getPixelSpacing(upper_bbox_corner - lower_bbox_corner, aWidth, aHeight);
 
-    for (int row = 0; row < anOutputImage.getHeight(); ++row)
+    aRaySet.clear();
+    aRaySet.reserve(aWidth * aHeight);
+    for (unsigned int row = 0; row < aHeight; ++row)
     {
-        // Process every column
-        for (int col = 0; col < anOutputImage.getWidth(); ++col)
+        for (unsigned int col = 0; col < aWidth; ++col)
         {
-            float v_offset = pixel_spacing[1] * (0.5 + row - anOutputImage.getHeight() / 2.0);
-            float u_offset = pixel_spacing[0] * (0.5 + col - anOutputImage.getWidth() / 2.0);
-
-            // Initialise the ray direction for this pixel
-            Vec3 direction = aDetectorPosition + anUpVector * v_offset + aRightVector * u_offset - aRayOrigin;
-            direction.normalise();
-            Ray ray(aRayOrigin, direction);
+            aRaySet.push_back(createPrimaryRay(col, row, aWidth, aHeight, pixel_spacing,
+                    aDetectorPosition, aRayOrigin, anUpVector, aRightVector));
+        }
+    }
+}
+
+
+//----------------------------------------------------------
+void runBenchmark(Scene& aScene,
+                  unsigned int aWidth, unsigned int aHeight,
+                  const Vec3& aDetectorPosition,
+                  const Vec3& aRayOrigin,
+                  const Vec3& anUpVector,
+                  const Vec3& aRightVector)
+//----------------------------------------------------------
+{
+    std::vector<Ray> ray_set;
+    createPrimaryRays(aScene, aWidth, aHeight, aDetectorPosition, aRayOrigin, anUpVector, aRightVector, ray_set);
+
+    // The layouts to compare, the first one is the reference
+    const unsigned int number_of_layouts = 9;
+    const unsigned int width_set[number_of_layouts] = {2, 2, 4, 4, 8, 8, 2, 4, 8};
+    const bool compression_set[number_of_layouts] = {false, false, false, true, false, true, false, false, false};
+    const bool stackless_set[number_of_layouts] = {false, true, false, false, false, false, false, false, false};
+    const bool block_set[number_of_layouts] = {false, false, false, false, false, false, true, true, true};
+
+    // The cache miss rate is reported if the hardware counters are available
+#ifdef __linux__
+    int cache_reference_counter = openHardwareCounter(PERF_COUNT_HW_CACHE_REFERENCES);
+    int cache_miss_counter = openHardwareCounter(PERF_COUNT_HW_CACHE_MISSES);
+#else
+    int cache_reference_counter = -1;
+    int cache_miss_counter = -1;
+#endif
+
+    std::vector<float> reference_t_set(ray_set.size());
 
-            const TriangleMesh* p_intersected_object = 0;
-            const Triangle* p_intersected_triangle = 0;
+    for (unsigned int layout = 0; layout < number_of_layouts; ++layout)
+    {
+        size_t node_memory_size = 0;
+        for (unsigned int mesh_id = 0; mesh_id < aScene.getNumberOfMeshes(); ++mesh_id)
+        {
+            TriangleMesh& mesh = aScene.getMesh(mesh_id);
+            mesh.setAccelerator(TriangleMesh::BVH_ACCELERATOR);
+            mesh.setBVHWidth(width_set[layout]);
+            mesh.setBVHCompression(compression_set[layout]);
+            mesh.setStacklessTraversal(stackless_set[layout]);
+            mesh.setTriangleBlocks(block_set[layout]);
+
+            node_memory_size += mesh.getNodeMemorySize();
+        }
+
+        startHardwareCounter(cache_reference_counter);
+        startHardwareCounter(cache_miss_counter);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
-            // Process every mesh
-            for (std::vector<TriangleMesh>::const_iterator mesh_ite = aTriangleMeshSet.begin();
-                    mesh_ite != aTriangleMeshSet.end();
-                    ++mesh_ite)
+        unsigned int number_of_mismatches = 0;
+        for (unsigned int i = 0; i < ray_set.size(); ++i)
+        {
+            float t = -1.0;
+            unsigned int instance_id;
+            unsigned int triangle_id;
+            aScene.intersect(ray_set[i], t, instance_id, triangle_id);
+
+            // No hit may be lost by the compression. The SIMD triangle
+            // tests may round differently when multiply-adds are fused
+            if (!layout)
+            {
+                reference_t_set[i] = t;
+            }
+            else if (std::abs(reference_t_set[i] - t) > 1.0e-5 * std::abs(reference_t_set[i]))
             {
-                // The ray intersect the mesh's bbox
-                if (mesh_ite->intersectBBox(ray))
+                ++number_of_mismatches;
+            }
+        }
+
+        double elapsed_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        long long number_of_misses = stopHardwareCounter(cache_miss_counter);
+        long long number_of_references = stopHardwareCounter(cache_reference_counter);
+
+        std::stringstream label;
+        label << "BVH" << width_set[layout] <<
+            (stackless_set[layout] ? " skip pointers" : compression_set[layout] ? " 8-bit boxes" : " float boxes") <<
+            (block_set[layout] ? ", triangle blocks" : "") <<
+            " (" << node_memory_size << " node bytes)";
+
+        reportBenchmark(label.str(), ray_set.size(), elapsed_time,
+                number_of_misses, number_of_references, number_of_mismatches);
+    }
+
+    // The primary rays of blocks of pixels traced together
+    // (the packets traverse the binary BVH)
+    const unsigned int packet_size_set[] = {4, 8};
+    for (unsigned int packet_size : packet_size_set)
+    {
+        startHardwareCounter(cache_reference_counter);
+        startHardwareCounter(cache_miss_counter);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        unsigned int number_of_mismatches = 0;
+        RayPacket packet;
+        for (unsigned int block_row = 0; block_row < aHeight; block_row += packet_size)
+        {
+            for (unsigned int block_col = 0; block_col < aWidth; block_col += packet_size)
+            {
+                unsigned int last_row = std::min(block_row + packet_size, aHeight);
+                unsigned int last_col = std::min(block_col + packet_size, aWidth);
+
+                packet.clear();
+                for (unsigned int row = block_row; row < last_row; ++row)
                 {
-                    // Process all the triangles of the mesh
-                    for (unsigned int triangle_id = 0;
-                            triangle_id < mesh_ite->getNumberOfTriangles();
-                            ++triangle_id)
+                    for (unsigned int col = block_col; col < last_col; ++col)
                     {
-                        // Retrievethe triangle
-                        const Triangle& triangle = mesh_ite->getTriangle(triangle_id);
+                        packet.addRay(ray_set[row * aWidth + col]);
+                    }
+                }
 
-                        // Retrieve the intersection if any
-                        float t;
-                        bool intersect = ray.intersect(triangle, t);
+                aScene.intersect(packet);
 
-                        // The ray interescted the triangle
-                        if (intersect)
+                unsigned int i = 0;
+                for (unsigned int row = block_row; row < last_row; ++row)
+                {
+                    for (unsigned int col = block_col; col < last_col; ++col, ++i)
+                    {
+                        float t = packet.hasHit(i) ? packet.getT(i) : -1.0;
+                        float reference_t = reference_t_set[row * aWidth + col];
+                        if (std::abs(reference_t - t) > 1.0e-5 * std::abs(reference_t))
                         {
-                            // The intersection is closer to the view point than the previously recorded intersection
-                            // Update the pixel value
-                            if (z_buffer[row * anOutputImage.getWidth() + col] > t)
-                            {
-                                z_buffer[row * anOutputImage.getWidth() + col] = t;
-
-                                p_intersected_object = &(*mesh_ite);
-                                p_intersected_triangle = &triangle;
-                            }
+                            ++number_of_mismatches;
                         }
                     }
                 }
             }
+        }
+
+        double elapsed_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        long long number_of_misses = stopHardwareCounter(cache_miss_counter);
+        long long number_of_references = stopHardwareCounter(cache_reference_counter);
+
+        std::stringstream label;
+        label << "BVH2 packets of " << packet_size << "x" << packet_size << " rays";
+
+        reportBenchmark(label.str(), ray_set.size(), elapsed_time,
+                number_of_misses, number_of_references, number_of_mismatches);
+    }
+
+    // The primary rays sorted, then traced as streams, in batches as in
+    // renderWavefront (the sort is included in the timing)
+    {
+        startHardwareCounter(cache_reference_counter);
+        startHardwareCounter(cache_miss_counter);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        unsigned int number_of_mismatches = 0;
+        RayStream stream;
+        for (unsigned int first_ray = 0; first_ray < ray_set.size(); first_ray += g_stream_size)
+        {
+            unsigned int last_ray = std::min(first_ray + g_stream_size, (unsigned int)ray_set.size());
+
+            stream.clear();
+            for (unsigned int i = first_ray; i < last_ray; ++i)
+            {
+                stream.addRay(ray_set[i], i);
+            }
 
-            // An interesection was found
-            if (p_intersected_object && p_intersected_triangle)
+            stream.sort();
+            aScene.intersect(stream);
+
+            for (unsigned int i = 0; i < stream.getSize(); ++i)
             {
-                float t = z_buffer[row * anOutputImage.getWidth() + col];
-                Vec3 point_hit = ray.getOrigin() + t * ray.getDirection();
-                Material material = p_intersected_object->getMaterial();
-                Vec3 colour = applyShading(aLight, material, p_intersected_triangle->getNormal(), point_hit, ray.getOrigin());
+                float t = stream.hasHit(i) ? stream.getT(i) : -1.0;
+                float reference_t = reference_t_set[stream.getId(i)];
+                if (std::abs(reference_t - t) > 1.0e-5 * std::abs(reference_t))
+                {
+                    ++number_of_mismatches;
+                }
+            }
+        }
+
+        double elapsed_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        long long number_of_misses = stopHardwareCounter(cache_miss_counter);
+        long long number_of_references = stopHardwareCounter(cache_reference_counter);
+
+        reportBenchmark("BVH2 sorted ray stream", ray_set.size(), elapsed_time,
+                number_of_misses, number_of_references, number_of_mismatches);
+    }
+
+#ifdef __linux__
+    if (cache_reference_counter >= 0) close(cache_reference_counter);
+    if (cache_miss_counter >= 0) close(cache_miss_counter);
+#endif
+}
+
+
+//-----------------------------------------------------------------
+void reportBVHStatistics(const Scene& aScene,
+                         unsigned int aWidth, unsigned int aHeight,
+                         const Vec3& aDetectorPosition,
+                         const Vec3& aRayOrigin,
+                         const Vec3& anUpVector,
+                         const Vec3& aRightVector)
+//-----------------------------------------------------------------
+{
+    std::vector<Ray> ray_set;
+    createPrimaryRays(aScene, aWidth, aHeight, aDetectorPosition, aRayOrigin, anUpVector, aRightVector, ray_set);
 
-                unsigned char r = 0;
-                unsigned char g = 0;
-                unsigned char b = 0;
+    for (unsigned int mesh_id = 0; mesh_id < aScene.getNumberOfMeshes(); ++mesh_id)
+    {
+        const TriangleMesh& mesh = aScene.getMesh(mesh_id);
+        const BVH& bvh = mesh.getBVH();
 
-                // Define the shadow ray
-                Vec3 shadow_ray_direction = aLight.getPosition() - point_hit;
-                shadow_ray_direction.normalise();
-                Ray shadow_ray(point_hit, shadow_ray_direction);
+        if (bvh.isEmpty())
+        {
+            std::cout << "Mesh " << mesh_id << ": no BVH" << std::endl;
+            continue;
+        }
 
-                bool is_point_in_shadow = false;
+        BVHStatistics statistics = bvh.getStatistics();
 
-                // Process every mesh
-                for (std::vector<TriangleMesh>::const_iterator mesh_ite = aTriangleMeshSet.begin();
-                        mesh_ite != aTriangleMeshSet.end();
-                        ++mesh_ite)
+        std::cout << "Mesh " << mesh_id << ": BVH (" <<
+            (bvh.getBuildMethod() == BVH::SAH ? "SAH" : bvh.getBuildMethod() == BVH::LBVH ? "LBVH" : "SBVH") <<
+            (mesh.getTreeletRestructuring() ? ", restructured treelets" : "") << "), SAH cost " <<
+            statistics.m_sah_cost << ", " <<
+            statistics.m_number_of_nodes << " nodes, " <<
+            statistics.m_number_of_leaves << " leaves, " <<
+            bvh.getNumberOfPrimitiveIndices() << " primitive references" << std::endl;
+
+        // Compare the spatial splits with a plain SAH build of the same
+        // geometry (the vertex buffers only, not the texture)
+        if (bvh.getBuildMethod() == BVH::SBVH)
+        {
+            std::vector<float> vertex_set;
+            vertex_set.reserve(mesh.getNumberOfVertices() * 3);
+            for (unsigned int i = 0; i < mesh.getNumberOfVertices(); ++i)
+            {
+                for (unsigned int axis = 0; axis < 3; ++axis)
                 {
-                    // Process all the triangles of the mesh
-                    for (unsigned int triangle_id = 0;
-                            triangle_id < mesh_ite->getNumberOfTriangles();
-                            ++triangle_id)
+                    vertex_set.push_back(mesh.getVertices()[i][axis]);
+                }
+            }
+
+            std::vector<unsigned int> index_set;
+            if (mesh.isIndexed())
+            {
+                index_set.reserve(mesh.getNumberOfTriangles() * 3);
+                for (unsigned int i = 0; i < mesh.getNumberOfTriangles(); ++i)
+                {
+                    for (unsigned int j = 0; j < 3; ++j)
                     {
-                        // Retrievethe triangle
-                        const Triangle& triangle = mesh_ite->getTriangle(triangle_id);
+                        index_set.push_back(mesh.getVertexIndex(i, j));
+                    }
+                }
+            }
+
+            // The binary BVH is enough, it is not collapsed
+            TriangleMesh sah_mesh;
+            sah_mesh.setBuildMethod(BVH::SAH);
+            sah_mesh.setBVHWidth(2);
+            sah_mesh.setGeometry(vertex_set, index_set);
+
+            float sah_cost = sah_mesh.getBVH().getSAHCost();
+            std::cout << "  SAH cost " << 100.0 * (statistics.m_sah_cost - sah_cost) / sah_cost <<
+                "% relative to the SAH build" << std::endl;
+        }
+
+        // Number of leaves per depth
+        double mean_depth = 0.0;
+        std::cout << "  Leaf depth (depth: leaves):";
+        for (unsigned int depth = 0; depth < statistics.m_depth_histogram.size(); ++depth)
+        {
+            if (statistics.m_depth_histogram[depth])
+            {
+                std::cout << " " << depth << ": " << statistics.m_depth_histogram[depth];
+                mean_depth += double(depth) * statistics.m_depth_histogram[depth];
+            }
+        }
+        std::cout << " (mean " << mean_depth / statistics.m_number_of_leaves <<
+            ", max " << statistics.m_depth_histogram.size() - 1 << ")" << std::endl;
+
+        // Number of leaves per number of primitives
+        std::cout << "  Leaf size (primitives: leaves):";
+        for (unsigned int size = 0; size < statistics.m_leaf_size_histogram.size(); ++size)
+        {
+            if (statistics.m_leaf_size_histogram[size])
+            {
+                std::cout << " " << size << ": " << statistics.m_leaf_size_histogram[size];
+            }
+        }
+        std::cout << " (mean " << double(bvh.getNumberOfPrimitiveIndices()) / statistics.m_number_of_leaves <<
+            ")" << std::endl;
+
+        // Trace the primary rays through the binary BVH alone, in the
+        // coordinate system of every instance of the mesh
+        unsigned long long number_of_rays = 0;
+        unsigned long long number_of_visits = 0;
+        unsigned long long number_of_tests = 0;
+
+        for (unsigned int instance_id = 0; instance_id < aScene.getNumberOfInstances(); ++instance_id)
+        {
+            const Instance& instance = aScene.getInstance(instance_id);
+            if (instance.getMeshId() != mesh_id)
+            {
+                continue;
+            }
+
+            auto intersector = [&mesh, &number_of_tests](const Ray& aRay, unsigned int aTriangleId, float& t)
+            {
+                ++number_of_tests;
+                return aRay.intersect(mesh.getTriangleRecord(aTriangleId), t);
+            };
+
+            for (unsigned int i = 0; i < ray_set.size(); ++i)
+            {
+                float scale;
+                Ray ray = instance.isIdentity() ? ray_set[i] : instance.transformRay(ray_set[i], scale);
+
+                float t;
+                unsigned int triangle_id;
+                unsigned int visit_count = 0;
+                bvh.intersect(ray, intersector, t, triangle_id, &visit_count);
 
-                        if (&triangle != p_intersected_triangle)
+                number_of_visits += visit_count;
+                ++number_of_rays;
+            }
+        }
+
+        if (number_of_rays)
+        {
+            std::cout << "  Primary rays: " <<
+                double(number_of_visits) / number_of_rays << " node visits and " <<
+                double(number_of_tests) / number_of_rays << " triangle tests per ray" << std::endl;
+        }
+    }
+}
+
+
+//-------------------------------------------------
+int openHardwareCounter(unsigned long long aConfig)
+//-------------------------------------------------
+{
+#ifdef __linux__
+    // Count the events of the calling thread in user space
+    perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = aConfig;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+
+    return syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+#else
+    // No counter available
+    return -1;
+#endif
+}
+
+
+//--------------------------------------------
+void startHardwareCounter(int aFileDescriptor)
+//--------------------------------------------
+{
+#ifdef __linux__
+    if (aFileDescriptor >= 0)
+    {
+        ioctl(aFileDescriptor, PERF_EVENT_IOC_RESET, 0);
+        ioctl(aFileDescriptor, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+
+//------------------------------------------------
+long long stopHardwareCounter(int aFileDescriptor)
+//------------------------------------------------
+{
+    long long value = -1;
+
+#ifdef __linux__
+    if (aFileDescriptor >= 0)
+    {
+        ioctl(aFileDescriptor, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(aFileDescriptor, &value, sizeof(value)) != sizeof(value))
+        {
+            value = -1;
+        }
+    }
+#endif
+
+    return value;
+}
+
+
+//---------------------------------------------------
+void reportBenchmark(const std::string& aLabel,
+                     size_t aNumberOfRays,
+                     double anElapsedTime,
+                     long long aNumberOfMisses,
+                     long long aNumberOfReferences,
+                     unsigned int aNumberOfMismatches)
+//---------------------------------------------------
+{
+    std::cout << aLabel << ": " <<
+        aNumberOfRays / anElapsedTime / 1.0e6 << " Mrays/s, cache miss rate ";
+
+    // The counters are negative if they are not available. The misses per
+    // ray show the effect of the memory layout, whatever the number of
+    // references
+    if (aNumberOfReferences > 0 && aNumberOfMisses >= 0)
+    {
+        std::cout << 100.0 * aNumberOfMisses / aNumberOfReferences << "% (" <<
+            double(aNumberOfMisses) / aNumberOfRays << " misses per ray)";
+    }
+    else
+    {
+        std::cout << "n/a";
+    }
+
+    std::cout << ", " << aNumberOfMismatches << " mismatches" << std::endl;
+}
+
+
+//-----------------------------------------------------------
+TriangleMesh createBackground(const Vec3& anUpperBBoxCorner,
+                                const Vec3& aLowerBBoxCorner)
+//-----------------------------------------------------------
+{
+    Vec3 range = anUpperBBoxCorner - aLowerBBoxCorner;
+
+    std::vector<float> vertices = {
+        anUpperBBoxCorner[0] + range[0] * 0.1f, aLowerBBoxCorner[1] - range[1] * 0.5f, aLowerBBoxCorner[2] - range[2] * 0.5f,
+        anUpperBBoxCorner[0] + range[0] * 0.1f, anUpperBBoxCorner[1] + range[1] * 0.5f, aLowerBBoxCorner[2] - range[2] * 0.5f,
+        anUpperBBoxCorner[0] + range[0] * 0.1f, anUpperBBoxCorner[1] + range[1] * 0.5f, anUpperBBoxCorner[2] + range[2] * 0.5f,
+        anUpperBBoxCorner[0] + range[0] * 0.1f, aLowerBBoxCorner[1] - range[1] * 0.5f, anUpperBBoxCorner[2] + range[2] * 0.5f,
+    };
+
+    std::vector<float> text_coords = {
+        0, 1, 0,
+        1, 1, 0,
+        1, 0, 0,
+        0, 0, 0,
+    };
+
+    std::vector<unsigned int> indices = {
+        0, 1, 2,
+        0, 2, 3,
+    };
+
+    TriangleMesh background_mesh(vertices, indices, text_coords);
+    Image background_texture("background.jpg");
+    background_mesh.setTexture(background_texture);
+
+    return (background_mesh);
+}
+
+
+//-----------------------------------------------
+void getBBox(const Scene& aScene,
+                         Vec3& anUpperBBoxCorner,
+                         Vec3& aLowerBBoxCorner)
+//-----------------------------------------------
+{
+    float inf = std::numeric_limits<float>::infinity();
+
+    aLowerBBoxCorner = Vec3( inf,  inf,  inf);
+    anUpperBBoxCorner = Vec3(-inf, -inf, -inf);
+
+    for (unsigned int instance_id = 0;
+            instance_id < aScene.getNumberOfInstances();
+            ++instance_id)
+    {
+        Vec3 mesh_lower_bbox_corner = aScene.getInstanceLowerBBoxCorner(instance_id);
+        Vec3 mesh_upper_bbox_corner = aScene.getInstanceUpperBBoxCorner(instance_id);
+
+        aLowerBBoxCorner[0] = std::min(aLowerBBoxCorner[0], mesh_lower_bbox_corner[0]);
+        aLowerBBoxCorner[1] = std::min(aLowerBBoxCorner[1], mesh_lower_bbox_corner[1]);
+        aLowerBBoxCorner[2] = std::min(aLowerBBoxCorner[2], mesh_lower_bbox_corner[2]);
+
+        anUpperBBoxCorner[0] = std::max(anUpperBBoxCorner[0], mesh_upper_bbox_corner[0]);
+        anUpperBBoxCorner[1] = std::max(anUpperBBoxCorner[1], mesh_upper_bbox_corner[1]);
+        anUpperBBoxCorner[2] = std::max(anUpperBBoxCorner[2], mesh_upper_bbox_corner[2]);
+    }
+}
+
+
+//----------------------------------------------
+void renderLoop(Image& anOutputImage,
+                  const Scene& aScene,
+                  const Vec3& aDetectorPosition,
+                  const Vec3& aRayOrigin,
+                  const Vec3& anUpVector,
+                  const Vec3& aRightVector,
+                  const Light& aLight,
+                  unsigned int aPacketSize,
+                  std::vector<float>* apDepthMap)
+//----------------------------------------------
+{
+    // Initialise some parameters
+    Vec3 upper_bbox_corner;
+    Vec3 lower_bbox_corner;
+    getBBox(aScene, upper_bbox_corner, lower_bbox_corner);
+
+    // Initialise the ray-tracer properties
+    Vec3 range = upper_bbox_corner - lower_bbox_corner;
+
+    float pixel_spacing = getPixelSpacing(range, anOutputImage.getWidth(), anOutputImage.getHeight());
+
+    // Offset of the shadow rays, relative to the size of the scene
+    float shadow_bias = 1.0e-5 * range.getLength();
+
+    // Each pixel is only traced once, the closest hit of its ray is all
+    // that is needed. The depth map is only filled if it is requested
+    if (apDepthMap)
+    {
+        apDepthMap->assign(anOutputImage.getWidth() * anOutputImage.getHeight(), std::numeric_limits<float>::infinity());
+    }
+
+    // The triangle that blocked the last shadow ray is tested first
+    OccluderCache occluder_cache;
+
+    // Trace the primary rays of each block of pixels together
+    if (aPacketSize)
+    {
+        RayPacket packet;
+        for (unsigned int block_row = 0; block_row < anOutputImage.getHeight(); block_row += aPacketSize)
+        {
+            for (unsigned int block_col = 0; block_col < anOutputImage.getWidth(); block_col += aPacketSize)
+            {
+                unsigned int last_row = std::min(block_row + aPacketSize, anOutputImage.getHeight());
+                unsigned int last_col = std::min(block_col + aPacketSize, anOutputImage.getWidth());
+
+                packet.clear();
+                for (unsigned int row = block_row; row < last_row; ++row)
+                {
+                    for (unsigned int col = block_col; col < last_col; ++col)
+                    {
+                        packet.addRay(createPrimaryRay(col, row,
+                                anOutputImage.getWidth(), anOutputImage.getHeight(),
+                                pixel_spacing,
+                                aDetectorPosition, aRayOrigin, anUpVector, aRightVector));
+                    }
+                }
+
+                aScene.intersect(packet);
+
+                unsigned int i = 0;
+                for (unsigned int row = block_row; row < last_row; ++row)
+                {
+                    for (unsigned int col = block_col; col < last_col; ++col, ++i)
+                    {
+                        if (packet.hasHit(i))
                         {
-                            // Retrieve the intersection if any
-                            float t;
-                            bool intersection = shadow_ray.intersect(triangle, t);
-                            if (intersection && t > 0.0000001)
+                            Ray ray = packet.getRay(i);
+                            Hit hit;
+                            hit.m_t = packet.getT(i);
+                            hit.m_u = packet.getU(i);
+                            hit.m_v = packet.getV(i);
+                            hit.m_instance_id = packet.getInstanceId(i);
+                            hit.m_triangle_id = packet.getPrimitiveId(i);
+
+                            // Stop at the first occluder found anywhere in the scene
+                            bool is_point_in_shadow = aScene.occluded(createShadowRay(aLight, ray.getPointAt(hit.m_t), shadow_bias), occluder_cache);
+
+                            shadePixel(anOutputImage, col, row, aScene, ray, hit, aLight, is_point_in_shadow);
+
+                            if (apDepthMap)
                             {
-                                is_point_in_shadow = true;
-                                break;
+                                (*apDepthMap)[row * anOutputImage.getWidth() + col] = hit.m_t;
                             }
                         }
                     }
                 }
+            }
+        }
+
+        reportOccluderCache(occluder_cache);
+        return;
+    }
+
+    for (unsigned int row = 0; row < anOutputImage.getHeight(); ++row)
+    {
+        // Process every column
+        for (unsigned int col = 0; col < anOutputImage.getWidth(); ++col)
+        {
+            // Initialise the ray for this pixel
+            Ray ray = createPrimaryRay(col, row,
+                    anOutputImage.getWidth(), anOutputImage.getHeight(),
+                    pixel_spacing,
+                    aDetectorPosition, aRayOrigin, anUpVector, aRightVector);
+
+            // Retrieve the closest intersection in the scene if any
+            // (the BVH over the instances skips whole instances at once)
+            Hit hit;
+            bool intersect = aScene.intersect(ray, hit);
+
+            // The ray interescted the scene, the hit is the closest one
+            // Update the pixel value
+            if (intersect)
+            {
+                // Stop at the first occluder found anywhere in the scene
+                bool is_point_in_shadow = aScene.occluded(createShadowRay(aLight, ray.getPointAt(hit.m_t), shadow_bias), occluder_cache);
 
-                // Apply soft shadows
-                if (is_point_in_shadow)
+                shadePixel(anOutputImage, col, row, aScene, ray, hit, aLight, is_point_in_shadow);
+
+                if (apDepthMap)
                 {
-                    colour[0] *= 0.25;
-                    colour[1] *= 0.25;
-                    colour[2] *= 0.25;
+                    (*apDepthMap)[row * anOutputImage.getWidth() + col] = hit.m_t;
                 }
+            }
+        }
+    }
 
-                const Image& texture = p_intersected_object->getTexture();
+    reportOccluderCache(occluder_cache);
+}
 
-                // Use texturing
-                if (texture.getWidth() * texture.getHeight())
-                {
-                    // Get the position of the intersection
 
-                    Vec3 P = aRayOrigin + t * direction;
+//---------------------------------------------------
+void renderWavefront(Image& anOutputImage,
+                     const Scene& aScene,
+                     const Vec3& aDetectorPosition,
+                     const Vec3& aRayOrigin,
+                     const Vec3& anUpVector,
+                     const Vec3& aRightVector,
+                     const Light& aLight)
+//---------------------------------------------------
+{
+    // Initialise some parameters
+    Vec3 upper_bbox_corner;
+    Vec3 lower_bbox_corner;
+    getBBox(aScene, upper_bbox_corner, lower_bbox_corner);
 
-                    // See https://www.scratchapixel.com/lessons/3d-basic-rendering/ray-tracing-rendering-a-triangle/barycentric-coordinates
-                    Vec3 A = p_intersected_triangle->getP1();
-                    Vec3 B = p_intersected_triangle->getP2();
-                    Vec3 C = p_intersected_triangle->getP3();
+    // Initialise the ray-tracer properties
+    Vec3 range = upper_bbox_corner - lower_bbox_corner;
 
-                    Triangle ABC(A, B, C);
-                    Triangle ABP(A, B, P);
-                    Triangle BCP(B, C, P);
-                    Triangle CAP(C, A, P);
+    float pixel_spacing = getPixelSpacing(range, anOutputImage.getWidth(), anOutputImage.getHeight());
 
-                    float area_ABC = ABC.getArea();
-                    float u = CAP.getArea() / area_ABC;
-                    float v = ABP.getArea() / area_ABC;
-                    float w = BCP.getArea() / area_ABC;
+    // Offset of the shadow rays, relative to the size of the scene
+    float shadow_bias = 1.0e-5 * range.getLength();
 
-                    // Getthe texel cooredinate
-                    Vec3 texel_coord(w * p_intersected_triangle->getTextCoord1() + u * p_intersected_triangle->getTextCoord2() + v * p_intersected_triangle->getTextCoord3());
+    // The pixels are processed in batches, each stage runs over the whole
+    // batch before the next one starts
+    unsigned int number_of_pixels = anOutputImage.getWidth() * anOutputImage.getHeight();
 
-                    unsigned char texel_r;
-                    unsigned char texel_g;
-                    unsigned char texel_b;
+    RayStream primary_stream;
+    RayStream shadow_stream;
+    primary_stream.reserve(std::min(number_of_pixels, g_stream_size));
+    shadow_stream.reserve(std::min(number_of_pixels, g_stream_size));
 
-                    // Retrieve the pixel value from the texture
-                    texture.getPixel(texel_coord[0] * (texture.getWidth() - 1),
-                        texel_coord[1] * (texture.getHeight() - 1),
-                        texel_r, texel_g, texel_b);
+    std::vector<bool> shadow_set;
 
-                    colour[0] *= texel_r;
-                    colour[1] *= texel_g;
-                    colour[2] *= texel_b;
+    for (unsigned int first_pixel = 0; first_pixel < number_of_pixels; first_pixel += g_stream_size)
+    {
+        unsigned int last_pixel = std::min(first_pixel + g_stream_size, number_of_pixels);
+
+        // Generate the primary rays, their ID is the pixel index
+        primary_stream.clear();
+        for (unsigned int pixel = first_pixel; pixel < last_pixel; ++pixel)
+        {
+            unsigned int row = pixel / anOutputImage.getWidth();
+            unsigned int col = pixel % anOutputImage.getWidth();
+
+            primary_stream.addRay(createPrimaryRay(col, row,
+                    anOutputImage.getWidth(), anOutputImage.getHeight(),
+                    pixel_spacing,
+                    aDetectorPosition, aRayOrigin, anUpVector, aRightVector),
+                    pixel);
+        }
+
+        // Trace the primary rays
+        primary_stream.sort();
+        aScene.intersect(primary_stream);
+
+        // Generate the shadow rays of the hit points, their ID is the
+        // index of their primary ray
+        shadow_stream.clear();
+        for (unsigned int i = 0; i < primary_stream.getSize(); ++i)
+        {
+            if (primary_stream.hasHit(i))
+            {
+                Vec3 point_hit = primary_stream.getRay(i).getPointAt(primary_stream.getT(i));
+                shadow_stream.addRay(createShadowRay(aLight, point_hit, shadow_bias), i);
+            }
+        }
+
+        // Trace the shadow rays, they converge on the light and are
+        // sorted by direction
+        shadow_stream.sortByDirection();
+        aScene.occluded(shadow_stream);
+
+        shadow_set.assign(primary_stream.getSize(), false);
+        for (unsigned int i = 0; i < shadow_stream.getSize(); ++i)
+        {
+            shadow_set[shadow_stream.getId(i)] = shadow_stream.hasHit(i);
+        }
+
+        // Shade the hit points
+        for (unsigned int i = 0; i < primary_stream.getSize(); ++i)
+        {
+            if (primary_stream.hasHit(i))
+            {
+                unsigned int pixel = primary_stream.getId(i);
+
+                Hit hit;
+                hit.m_t = primary_stream.getT(i);
+                hit.m_u = primary_stream.getU(i);
+                hit.m_v = primary_stream.getV(i);
+                hit.m_instance_id = primary_stream.getInstanceId(i);
+                hit.m_triangle_id = primary_stream.getTriangleId(i);
+
+                shadePixel(anOutputImage,
+                        pixel % anOutputImage.getWidth(), pixel / anOutputImage.getWidth(),
+                        aScene,
+                        primary_stream.getRay(i),
+                        hit,
+                        aLight,
+                        shadow_set[i]);
+            }
+        }
+    }
+}
+
+
+//------------------------------------------------
+void renderDeferred(Image& anOutputImage,
+                    const Scene& aScene,
+                    const Vec3& aDetectorPosition,
+                    const Vec3& aRayOrigin,
+                    const Vec3& anUpVector,
+                    const Vec3& aRightVector,
+                    const Light& aLight,
+                    bool aShadowPacketFlag)
+//------------------------------------------------
+{
+    // Initialise some parameters
+    Vec3 upper_bbox_corner;
+    Vec3 lower_bbox_corner;
+    getBBox(aScene, upper_bbox_corner, lower_bbox_corner);
+
+    // Initialise the ray-tracer properties
+    Vec3 range = upper_bbox_corner - lower_bbox_corner;
 
-                    // Clamp the value to the range 0 to 255
-                    if (colour[0] < 0) r = 0;
-                    else if (colour[0] > 255) r = 255;
-                    else r = int(colour[0]);
+    float pixel_spacing = getPixelSpacing(range, anOutputImage.getWidth(), anOutputImage.getHeight());
+
+    // Offset of the shadow rays, relative to the size of the scene
+    float shadow_bias = 1.0e-5 * range.getLength();
+
+    GBuffer g_buffer;
+    g_buffer.reserve(g_tile_size * g_tile_size);
+
+    // The shadow rays of a tile, their ID is their pixel in the G-buffer
+    RayStream shadow_stream;
+    shadow_stream.reserve(g_tile_size * g_tile_size);
+
+    // Time spent in each pass, to profile them separately
+    double visibility_time = 0.0;
+    double shading_time = 0.0;
+
+    for (unsigned int tile_row = 0; tile_row < anOutputImage.getHeight(); tile_row += g_tile_size)
+    {
+        for (unsigned int tile_col = 0; tile_col < anOutputImage.getWidth(); tile_col += g_tile_size)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+            unsigned int last_row = std::min(tile_row + g_tile_size, anOutputImage.getHeight());
+            unsigned int last_col = std::min(tile_col + g_tile_size, anOutputImage.getWidth());
+
+            // Visibility pass: the closest hits of the primary rays, and
+            // whether they are in shadow
+            g_buffer.clear();
+            shadow_stream.clear();
+            for (unsigned int row = tile_row; row < last_row; ++row)
+            {
+                for (unsigned int col = tile_col; col < last_col; ++col)
+                {
+                    Ray ray = createPrimaryRay(col, row,
+                            anOutputImage.getWidth(), anOutputImage.getHeight(),
+                            pixel_spacing,
+                            aDetectorPosition, aRayOrigin, anUpVector, aRightVector);
+
+                    unsigned int i = g_buffer.getSize();
+                    g_buffer.addPixel(col, row);
+
+                    Hit hit;
+                    if (aScene.intersect(ray, hit))
+                    {
+                        Vec3 point_hit = ray.getPointAt(hit.m_t);
+                        g_buffer.setHit(i, hit, aScene.getInstance(hit.m_instance_id).getMeshId(), point_hit);
+
+                        if (aShadowPacketFlag)
+                        {
+                            shadow_stream.addRay(createShadowRay(aLight, point_hit, shadow_bias), i);
+                        }
+                        // Stop at the first occluder found anywhere in the scene
+                        else
+                        {
+                            g_buffer.setShadow(i, aScene.occluded(createShadowRay(aLight, point_hit, shadow_bias)));
+                        }
+                    }
+                }
+            }
 
-                    if (colour[1] < 0) g = 0;
-                    else if (colour[1] > 255) g = 255;
-                    else g = int(colour[1]);
+            // The shadow rays converge on the light: sorted by direction,
+            // consecutive rays form narrow packets, traced with the any-hit
+            // query into the shadow mask
+            if (aShadowPacketFlag)
+            {
+                shadow_stream.sortByDirection();
+                aScene.occluded(shadow_stream);
 
-                    if (colour[2] < 0) b = 0;
-                    else if (colour[2] > 255) b = 255;
-                    else b = int(colour[2]);
+                for (unsigned int i = 0; i < shadow_stream.getSize(); ++i)
+                {
+                    g_buffer.setShadow(shadow_stream.getId(i), shadow_stream.hasHit(i));
                 }
-                else
+            }
+
+            g_buffer.groupByMesh(aScene.getNumberOfMeshes());
+
+            std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+
+            // Shading pass
+            shadeTile(anOutputImage, aScene, g_buffer, aRayOrigin, aLight);
+
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            visibility_time += std::chrono::duration<double>(middle - start).count();
+            shading_time += std::chrono::duration<double>(end - middle).count();
+        }
+    }
+
+    std::cout << "Visibility pass: " << visibility_time << " s, shading pass: " << shading_time << " s" << std::endl;
+}
+
+
+//---------------------------------------
+void shadeTile(Image& anOutputImage,
+               const Scene& aScene,
+               const GBuffer& aGBuffer,
+               const Vec3& aViewPosition,
+               const Light& aLight)
+//---------------------------------------
+{
+    // The attributes of the pixels of a group, one array per component so
+    // that the loops over the pixels are vectorised
+    std::vector<float> point_x, point_y, point_z;
+    std::vector<float> normal_x, normal_y, normal_z;
+    std::vector<float> diffuse_set, specular_set, shadow_set;
+    std::vector<float> red_set, green_set, blue_set;
+    std::vector<unsigned char> r_set, g_set, b_set;
+
+    // The loops over the pixels only read plain floats
+    const float light_colour[3] = {aLight.getColour()[0], aLight.getColour()[1], aLight.getColour()[2]};
+    const float light_position_x = aLight.getPosition()[0];
+    const float light_position_y = aLight.getPosition()[1];
+    const float light_position_z = aLight.getPosition()[2];
+    const float view_position_x = aViewPosition[0];
+    const float view_position_y = aViewPosition[1];
+    const float view_position_z = aViewPosition[2];
+
+    // The pixels of a group share their material and their texture
+    for (unsigned int group_id = 0; group_id < aGBuffer.getNumberOfGroups(); ++group_id)
+    {
+        const TriangleMesh& mesh = aScene.getMesh(aGBuffer.getGroupMeshId(group_id));
+        const Material& material = mesh.getMaterial();
+        const Image& texture = mesh.getTexture();
+
+        int size = aGBuffer.getGroupSize(group_id);
+        point_x.resize(size); point_y.resize(size); point_z.resize(size);
+        normal_x.resize(size); normal_y.resize(size); normal_z.resize(size);
+        diffuse_set.resize(size); specular_set.resize(size); shadow_set.resize(size);
+        red_set.resize(size); green_set.resize(size); blue_set.resize(size);
+        r_set.resize(size); g_set.resize(size); b_set.resize(size);
+
+        // Gather the points and the normals in world space
+        for (int k = 0; k < size; ++k)
+        {
+            unsigned int i = aGBuffer.getGroupPixel(group_id, k);
+            const Hit& hit = aGBuffer.getHit(i);
+            const Vec3& point = aGBuffer.getPoint(i);
+            Vec3 normal = aScene.getInstance(hit.m_instance_id).transformNormal(mesh.getNormal(hit.m_triangle_id));
+
+            point_x[k] = point[0]; point_y[k] = point[1]; point_z[k] = point[2];
+            normal_x[k] = normal[0]; normal_y[k] = normal[1]; normal_z[k] = normal[2];
+
+            // Soft shadows
+            shadow_set[k] = aGBuffer.isInShadow(i) ? 0.25 : 1.0;
+        }
+
+        // Same steps as applyShading, in each lane
+        float* p_point_x = point_x.data(); float* p_point_y = point_y.data(); float* p_point_z = point_z.data();
+        float* p_normal_x = normal_x.data(); float* p_normal_y = normal_y.data(); float* p_normal_z = normal_z.data();
+        float* p_diffuse = diffuse_set.data();
+        float* p_specular = specular_set.data();
+
+        #pragma omp simd
+        for (int k = 0; k < size; ++k)
+        {
+            // diffuse
+            float light_x = light_position_x - p_point_x[k];
+            float light_y = light_position_y - p_point_y[k];
+            float light_z = light_position_z - p_point_z[k];
+            float light_length = std::sqrt(light_x * light_x + light_y * light_y + light_z * light_z);
+            light_x /= light_length;
+            light_y /= light_length;
+            light_z /= light_length;
+
+            p_diffuse[k] = std::abs(p_normal_x[k] * light_x + p_normal_y[k] * light_y + p_normal_z[k] * light_z);
+
+            // specular, reflect(-view, normal)
+            float view_x = view_position_x - p_point_x[k];
+            float view_y = view_position_y - p_point_y[k];
+            float view_z = view_position_z - p_point_z[k];
+            float view_length = std::sqrt(view_x * view_x + view_y * view_y + view_z * view_z);
+            view_x /= view_length;
+            view_y /= view_length;
+            view_z /= view_length;
+
+            float twice_cosine = 2.0f * (p_normal_x[k] * -view_x + p_normal_y[k] * -view_y + p_normal_z[k] * -view_z);
+            float reflect_x = -view_x - twice_cosine * p_normal_x[k];
+            float reflect_y = -view_y - twice_cosine * p_normal_y[k];
+            float reflect_z = -view_z - twice_cosine * p_normal_z[k];
+
+            float cosine = view_x * reflect_x + view_y * reflect_y + view_z * reflect_z;
+            p_specular[k] = cosine > 0.0f ? cosine : 0.0f;
+        }
+
+        // There is no vectorised pow without a vector maths library
+        float shininess = material.getShininess();
+        for (int k = 0; k < size; ++k)
+        {
+            p_specular[k] = std::pow(p_specular[k], shininess);
+        }
+
+        float* p_shadow = shadow_set.data();
+        float* p_colour[3] = {red_set.data(), green_set.data(), blue_set.data()};
+
+        for (unsigned int channel = 0; channel < 3; ++channel)
+        {
+            float light = light_colour[channel];
+            float ambient = light * material.getAmbient()[channel];
+            float diffuse = material.getDiffuse()[channel];
+            float specular = material.getSpecular()[channel];
+            float* p_channel = p_colour[channel];
+
+            #pragma omp simd
+            for (int k = 0; k < size; ++k)
+            {
+                p_channel[k] = (ambient + light * (p_diffuse[k] * diffuse) +
+                        light * (p_specular[k] * specular)) * p_shadow[k];
+            }
+        }
+
+        // Use texturing, the texels are gathered one by one
+        if (texture.getWidth() && texture.getHeight())
+        {
+            for (int k = 0; k < size; ++k)
+            {
+                const Hit& hit = aGBuffer.getHit(aGBuffer.getGroupPixel(group_id, k));
+
+                float w = 1.0 - hit.m_u - hit.m_v;
+                Vec3 texel_coord(w * mesh.getTextCoord(hit.m_triangle_id, 0) + hit.m_u * mesh.getTextCoord(hit.m_triangle_id, 1) + hit.m_v * mesh.getTextCoord(hit.m_triangle_id, 2));
+
+                unsigned char texel_r;
+                unsigned char texel_g;
+                unsigned char texel_b;
+
+                texture.getPixel(texel_coord[0] * (texture.getWidth() - 1),
+                    texel_coord[1] * (texture.getHeight() - 1),
+                    texel_r, texel_g, texel_b);
+
+                p_colour[0][k] *= texel_r;
+                p_colour[1][k] *= texel_g;
+                p_colour[2][k] *= texel_b;
+            }
+        }
+        // Convert from [0, 1] to [0, 255]
+        else
+        {
+            for (unsigned int channel = 0; channel < 3; ++channel)
+            {
+                float* p_channel = p_colour[channel];
+
+                #pragma omp simd
+                for (int k = 0; k < size; ++k)
                 {
-                    // Convert from float to UCHAR and
-                    // clamp the value to the range 0 to 255
-                    if (255.0 * colour[0] < 0) r = 0;
-                    else if (255.0 * colour[0] > 255) r = 255;
-                    else r = int(255.0 * colour[0]);
-
-                    if (255.0 * colour[1] < 0) g = 0;
-                    else if (255.0 * colour[1] > 255) g = 255;
-                    else g = int(255.0 * colour[1]);
-
-                    if (255.0 * colour[2] < 0) b = 0;
-                    else if (255.0 * colour[2] > 255) b = 255;
-                    else b = int(255.0 * colour[2]);
+                    p_channel[k] = 255.0 * p_channel[k];
                 }
+            }
+        }
+
+        // Clamp the values to the range 0 to 255
+        unsigned char* p_byte[3] = {r_set.data(), g_set.data(), b_set.data()};
+        for (unsigned int channel = 0; channel < 3; ++channel)
+        {
+            float* p_channel = p_colour[channel];
+            unsigned char* p_channel_byte = p_byte[channel];
 
-                // Update the pixel value
-                anOutputImage.setPixel(col, row, r, g, b);
+            #pragma omp simd
+            for (int k = 0; k < size; ++k)
+            {
+                float value = p_channel[k] < 0.0f ? 0.0f : p_channel[k] > 255.0f ? 255.0f : p_channel[k];
+                p_channel_byte[k] = int(value);
             }
         }
+
+        // Update the pixel values
+        for (int k = 0; k < size; ++k)
+        {
+            unsigned int i = aGBuffer.getGroupPixel(group_id, k);
+            anOutputImage.setPixel(aGBuffer.getColumn(i), aGBuffer.getRow(i), r_set[k], g_set[k], b_set[k]);
+        }
+    }
+}
+
+
+//------------------------------------------------
+Ray createShadowRay(const Light& aLight,
+                    const Vec3& aPoint,
+                    float aShadowBias)
+//------------------------------------------------
+{
+    // The shadow ray stops at the light. It starts slightly away from
+    // the point so that the surface that was hit does not shadow itself
+    Vec3 shadow_ray_direction = aLight.getPosition() - aPoint;
+    float light_distance = shadow_ray_direction.getLength();
+
+    return Ray(aPoint, shadow_ray_direction, aShadowBias, light_distance);
+}
+
+
+//---------------------------------------------------
+void reportOccluderCache(const OccluderCache& aCache)
+//---------------------------------------------------
+{
+    std::cout << "Occluder cache: " << aCache.getNumberOfCacheHits() <<
+        " hits out of " << aCache.getNumberOfQueries() << " shadow rays (" <<
+        100.0 * aCache.getHitRate() << "%), " <<
+        aCache.getNumberOfOccludedRays() << " occluded" << std::endl;
+}
+
+
+//----------------------------------------------------------
+void saveDepthMap(const std::string& aFileName,
+                  unsigned int aWidth, unsigned int aHeight,
+                  const std::vector<float>& aDepthMap)
+//----------------------------------------------------------
+{
+    FILE* p_output_file(fopen(aFileName.c_str(), "wb"));
+    if (!p_output_file)
+    {
+        std::stringstream error_message;
+        error_message << "Cannot create the file " << aFileName << ", in File " << __FILE__ <<
+            ", in Function " << __FUNCTION__ <<
+            ", at Line " << __LINE__;
+
+        throw std::runtime_error(error_message.str());
     }
+
+    // Greyscale PFM: the negative scale stands for little-endian floats,
+    // the rows are stored from the bottom to the top
+    fprintf(p_output_file, "Pf\n%u %u\n-1.0\n", aWidth, aHeight);
+
+    for (unsigned int row = aHeight; row > 0; --row)
+    {
+        fwrite(&aDepthMap[(row - 1) * aWidth], sizeof(float), aWidth, p_output_file);
+    }
+
+    fclose(p_output_file);
+}
+
+
+//--------------------------------------------------
+void shadePixel(Image& anOutputImage,
+                unsigned int aColumn, unsigned int aRow,
+                const Scene& aScene,
+                const Ray& aRay,
+                const Hit& aHit,
+                const Light& aLight,
+                bool isInShadow)
+//--------------------------------------------------
+{
+    const Instance& instance = aScene.getInstance(aHit.m_instance_id);
+    const TriangleMesh& mesh = aScene.getInstanceMesh(aHit.m_instance_id);
+
+    Vec3 point_hit = aRay.getPointAt(aHit.m_t);
+    Material material = mesh.getMaterial();
+    Vec3 normal = instance.transformNormal(mesh.getNormal(aHit.m_triangle_id));
+    Vec3 colour = applyShading(aLight, material, normal, point_hit, aRay.getOrigin());
+
+    unsigned char r = 0;
+    unsigned char g = 0;
+    unsigned char b = 0;
+
+    // Apply soft shadows
+    if (isInShadow)
+    {
+        colour[0] *= 0.25;
+        colour[1] *= 0.25;
+        colour[2] *= 0.25;
+    }
+
+    const Image& texture = mesh.getTexture();
+
+    // Use texturing
+    if (texture.getWidth() && texture.getHeight())
+    {
+        // Interpolate the texture coordinates with the barycentric
+        // coordinates of the intersection
+        float u = aHit.m_u;
+        float v = aHit.m_v;
+        float w = 1.0 - u - v;
+
+        // Getthe texel cooredinate
+        Vec3 texel_coord(w * mesh.getTextCoord(aHit.m_triangle_id, 0) + u * mesh.getTextCoord(aHit.m_triangle_id, 1) + v * mesh.getTextCoord(aHit.m_triangle_id, 2));
+
+        unsigned char texel_r;
+        unsigned char texel_g;
+        unsigned char texel_b;
+
+        // Retrieve the pixel value from the texture
+        texture.getPixel(texel_coord[0] * (texture.getWidth() - 1),
+            texel_coord[1] * (texture.getHeight() - 1),
+            texel_r, texel_g, texel_b);
+
+        colour[0] *= texel_r;
+        colour[1] *= texel_g;
+        colour[2] *= texel_b;
+
+        // Clamp the value to the range 0 to 255
+        if (colour[0] < 0) r = 0;
+        else if (colour[0] > 255) r = 255;
+        else r = int(colour[0]);
+
+        if (colour[1] < 0) g = 0;
+        else if (colour[1] > 255) g = 255;
+        else g = int(colour[1]);
+
+        if (colour[2] < 0) b = 0;
+        else if (colour[2] > 255) b = 255;
+        else b = int(colour[2]);
+    }
+    else
+    {
+        // Convert from float to UCHAR and
+        // clamp the value to the range 0 to 255
+        if (255.0 * colour[0] < 0) r = 0;
+        else if (255.0 * colour[0] > 255) r = 255;
+        else r = int(255.0 * colour[0]);
+
+        if (255.0 * colour[1] < 0) g = 0;
+        else if (255.0 * colour[1] > 255) g = 255;
+        else g = int(255.0 * colour[1]);
+
+        if (255.0 * colour[2] < 0) b = 0;
+        else if (255.0 * colour[2] > 255) b = 255;
+        else b = int(255.0 * colour[2]);
+    }
+
+    // Update the pixel value
+    anOutputImage.setPixel(aColumn, aRow, r, g, b);
 }